@@ -2,120 +2,788 @@
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
 #include "include/ArrayDataAnalyzer.h"
+#include "include/RowSchema.h"
+#include "include/LazyTable.h"
+#include "include/QueryLanguage.h"
+#include "include/ResultCache.h"
+#include "include/StreamReader.h"
 
-// Helper function to split CSV line
-Array<std::string> splitCSV(const std::string& line) {
-    Array<std::string> result;
-    std::stringstream ss(line);
-    std::string item;
-    
-    while (std::getline(ss, item, ',')) {
-        // Remove quotes if present
-        if (item.front() == '"' && item.back() == '"') {
-            item = item.substr(1, item.length() - 2);
+// Optional extras for Questions 1 and 2, set from the command line
+struct QueryOptions {
+    std::string rangeFrom;   // Summarize this date range after Question 1
+    std::string rangeTo;
+    bool useBitmapIndex;     // Answer Question 2 from the bitmap indexes
+
+    QueryOptions() : useBitmapIndex(false) {}
+};
+
+// Count rows matching "column=value&column=value[&column=value]" using the
+// bitmap indexes; returns -1 if the expression is malformed
+long long countFilter(const TransactionBitmapIndex& index, const std::string& expression) {
+    TransactionColumn columns[3];
+    std::string values[3];
+    int terms = 0;
+    size_t start = 0;
+    while (start <= expression.size()) {
+        size_t end = expression.find('&', start);
+        if (end == std::string::npos) end = expression.size();
+        std::string term = expression.substr(start, end - start);
+        size_t equals = term.find('=');
+        if (terms == 3 || equals == std::string::npos ||
+            !parseTransactionColumn(term.substr(0, equals), columns[terms])) {
+            return -1;
         }
-        result.push_back(item);
+        values[terms++] = term.substr(equals + 1);
+        start = end + 1;
     }
-    return result;
+
+    if (terms == 1) return index.count(columns[0], values[0]);
+    if (terms == 2) return index.countAnd(columns[0], values[0], columns[1], values[1]);
+    return index.countAnd(columns[0], values[0], columns[1], values[1], columns[2], values[2]);
 }
 
-int main() {
-    ArrayDataAnalyzer analyzer;
+// Run one --query and print its result table; false if the query is invalid
+template <typename TR, typename RV>
+bool printQuery(const std::string& text, const Array<TR>& transactions, const Array<RV>& reviews) {
+    QueryResult result;
+    std::string error;
+    if (!runQuery(text, transactions, reviews, result, error)) {
+        std::cerr << "Invalid query (" << error << "): " << text << std::endl;
+        return false;
+    }
+    std::cout << "\nQuery: " << text << std::endl;
+    std::cout << result.header << std::endl;
+    for (int i = 0; i < result.rows.getSize(); i++) {
+        std::cout << result.rows[i] << std::endl;
+    }
+    return true;
+}
 
-    // Read transactions
-    std::ifstream transFile("transactions_cleaned.csv");
-    std::string line;
-    
-    // Skip header
-    std::getline(transFile, line);
-    
-    while (std::getline(transFile, line)) {
-        Array<std::string> fields = splitCSV(line);
-        if (fields.getSize() >= 6) {
-            Transaction trans(
-                fields[0], // Customer ID
-                fields[1], // Product
-                fields[2], // Category
-                std::stod(fields[3]), // Price
-                fields[4], // Date
-                fields[5]  // Payment Method
-            );
-            analyzer.addTransaction(trans);
-        }
+// Print one transaction row of the Question 1 listing
+template <typename T>
+void printTransaction(const T& t) {
+    std::cout << t.date << ", " 
+              << t.customerId << ", "
+              << t.product << ", "
+              << t.category << ", "
+              << t.price << ", "
+              << t.paymentMethod << std::endl;
+}
+
+// Total and first 100 rows of the Question 1 listing; rowAt(i) returns the
+// i-th transaction in date order
+template <typename F>
+void printSortedTransactions(int totalTransactions, F rowAt) {
+    std::cout << "\nTotal number of transactions: " << totalTransactions << std::endl;
+    std::cout << "\nFirst 100 transactions (sorted by date):" << std::endl;
+    std::cout << "Date, Customer ID, Product, Category, Price, Payment Method" << std::endl;
+    for (int i = 0; i < totalTransactions && i < 100; i++) {
+        printTransaction(rowAt(i));
+    }
+    if (totalTransactions > 100) {
+        std::cout << "\n... and " << (totalTransactions - 100) << " more transactions" << std::endl;
     }
+}
 
-    // Read reviews
-    std::ifstream reviewFile("reviews_cleaned.csv");
-    
-    // Skip header
-    std::getline(reviewFile, line);
-    
-    while (std::getline(reviewFile, line)) {
-        Array<std::string> fields = splitCSV(line);
-        if (fields.getSize() >= 4) {
-            Review review(
-                fields[0], // Product ID
-                fields[1], // Customer ID
-                std::stoi(fields[2]), // Rating
-                fields[3]  // Review Text
-            );
-            analyzer.addReview(review);
-        }
+void printQuestion2(int totalElectronics, int electronicsCreditCard) {
+    if (totalElectronics > 0) {
+        double percentage = (static_cast<double>(electronicsCreditCard) / totalElectronics) * 100;
+        std::cout << "\nOut of " << totalElectronics << " Electronics purchases:" << std::endl;
+        std::cout << electronicsCreditCard << " were made with Credit Card (" << std::fixed << std::setprecision(2) << percentage << "%)" << std::endl;
+    } else {
+        std::cout << "\nNo Electronics purchases found in the dataset." << std::endl;
+    }
+}
+
+void printTopWords(const Array<WordFrequency>& topWords) {
+    std::cout << "\nTop 5 frequent words in negative reviews:\n";
+    for (int i = 0; i < topWords.getSize(); i++) {
+        std::cout << topWords[i].word << ": " << topWords[i].frequency << " occurrences\n";
+    }
+}
+
+void printProductList(const Array<ProductRating>& products) {
+    std::cout << "Product ID, Reviews, Mean, Score, 1-5 star counts" << std::endl;
+    for (int i = 0; i < products.getSize(); i++) {
+        const ProductRating& p = products[i];
+        std::cout << p.productId << ", " << p.count << ", " << p.mean() << ", " << p.score << ",";
+        for (int r = 0; r < 5; r++) std::cout << " " << p.histogram[r];
+        std::cout << std::endl;
+    }
+}
+
+// --search: match count and the first few matching reviews
+template <typename R>
+void printSearchResult(const std::string& text, const ReviewQuery& query, const Array<int>& rows,
+                       const Array<R>& reviews) {
+    std::cout << "\nReviews matching \"" << text << "\"";
+    if (query.rating > 0) std::cout << " rated " << query.rating;
+    if (!query.productId.empty()) std::cout << " for " << query.productId;
+    std::cout << ": " << rows.getSize() << std::endl;
+    for (int i = 0; i < rows.getSize() && i < 5; i++) {
+        const R& review = reviews[rows[i]];
+        std::cout << review.productId << ", " << review.customerId << ", " << review.rating << ", "
+                  << review.reviewText << std::endl;
+    }
+}
+
+// --product-ratings: the k worst and best products by smoothed rating
+void printProductRankings(const ProductRatingTable& ratings, int k) {
+    std::cout << "\nProducts reviewed: " << ratings.getProductCount() << " (" << ratings.getReviewCount()
+              << " reviews, mean rating " << ratings.globalMean() << ", prior weight " << ratings.getPriorWeight()
+              << ")" << std::endl;
+    std::cout << "Worst " << k << " products:" << std::endl;
+    printProductList(ratings.worst(k));
+    std::cout << "Best " << k << " products:" << std::endl;
+    printProductList(ratings.best(k));
+}
+
+// --rfm: customers per segment and the k customers with the best RFM scores
+void printRfm(const RfmTable& rfm, int k) {
+    int segments[RFM_SEGMENT_COUNT];
+    rfm.countSegments(segments);
+    std::cout << "\nCustomers by RFM segment (" << rfm.getCustomerCount() << " customers):" << std::endl;
+    for (int s = 0; s < RFM_SEGMENT_COUNT; s++) {
+        std::cout << RFM_SEGMENT_NAMES[s] << ": " << segments[s] << std::endl;
+    }
+    std::cout << "Top " << k << " customers (customer, days since last purchase, purchases, spend, RFM):" << std::endl;
+    Array<int> top = rfm.topCustomers(k);
+    for (int i = 0; i < top.getSize(); i++) {
+        int c = top[i];
+        std::cout << rfm.customerAt(c) << ", " << rfm.recencyDays(c) << ", " << rfm.purchasesOf(c) << ", "
+                  << rfm.spendOf(c) << ", " << rfm.recencyScoreOf(c) << rfm.frequencyScoreOf(c)
+                  << rfm.monetaryScoreOf(c) << std::endl;
+    }
+}
+
+// Quantiles and histogram counts for each group of one column
+void printPriceGroups(const char* column, GroupedPriceSketches& groups) {
+    std::cout << "\nPrices by " << column << " (count, min, p50, p90, p95, p99, max):" << std::endl;
+    for (int g = 0; g < groups.getGroupCount(); g++) {
+        PriceSketch& sketch = groups.sketchAt(g);
+        std::cout << groups.groupAt(g) << ": " << static_cast<long long>(sketch.count()) << ", " << sketch.min();
+        const double quantiles[4] = {0.5, 0.9, 0.95, 0.99};
+        for (int q = 0; q < 4; q++) std::cout << ", " << sketch.quantile(quantiles[q]);
+        std::cout << ", " << sketch.max() << std::endl;
     }
+    if (groups.getGroupCount() == 0) return;
 
+    const PriceHistogram& layout = groups.sketchAt(0).getHistogram();
+    std::cout << "Histogram of " << column << " prices, " << layout.getBucketCount() << " buckets from "
+              << layout.getLow() << " to " << layout.getHigh() << " (below, buckets..., above):" << std::endl;
+    for (int g = 0; g < groups.getGroupCount(); g++) {
+        const PriceHistogram& histogram = groups.sketchAt(g).getHistogram();
+        std::cout << groups.groupAt(g) << ": " << histogram.underflow();
+        for (int b = 0; b < histogram.getBucketCount(); b++) std::cout << " " << histogram.bucketCountAt(b);
+        std::cout << " " << histogram.overflow() << std::endl;
+    }
+}
+
+// --price-quantiles: t-digest quantiles per category and payment method
+void printPriceStatistics(PriceStatistics& statistics) {
+    printPriceGroups("category", statistics.byCategory());
+    printPriceGroups("payment method", statistics.byPaymentMethod());
+}
+
+// Questions 1 and 2, for owned (Transaction) or arena-backed (TransactionRef) records
+template <typename T>
+void answerTransactionQuestions(ArrayDataAnalyzer& analyzer, const Array<T>& storedTransactions,
+                                const QueryOptions& options) {
     // 1. How can you efficiently sort customer transactions by date and display the total number of transactions in both datasets?
     std::cout << "1. How can you efficiently sort customer transactions by date and display the total number of transactions in both datasets?" << std::endl;
     
     // Get all transactions and sort them by date
-    Array<Transaction> transactions = analyzer.getTransactions();
+    ScopedTimer sortTimer("sort.transactionsByDate");
+    Array<T> transactions = storedTransactions;
     analyzer.quickSort(transactions, compareTransactionsByDate);
+    sortTimer.addRows(transactions.getSize());
+    sortTimer.stop();
 
-    // Display total number of transactions
-    int totalTransactions = transactions.getSize();
-    std::cout << "\nTotal number of transactions: " << totalTransactions << std::endl;
-
-    // Display first 100 transactions
-    std::cout << "\nFirst 100 transactions (sorted by date):" << std::endl;
-    std::cout << "Date, Customer ID, Product, Category, Price, Payment Method" << std::endl;
+    // Display the total and the first 100 transactions
+    printSortedTransactions(transactions.getSize(), [&transactions](int i) -> const T& { return transactions[i]; });
 
-    int displayCount = std::min(100, totalTransactions);
-    for (int i = 0; i < displayCount; i++) {
-        const Transaction& t = transactions[i];
-        std::cout << t.date << ", " 
-                  << t.customerId << ", "
-                  << t.product << ", "
-                  << t.category << ", "
-                  << t.price << ", "
-                  << t.paymentMethod << std::endl;
-    }
+    if (!options.rangeFrom.empty()) {
+        // Answered from the calendar-date index over the sorted array, no rescan
+        const TimeIndex& index = analyzer.buildTimeIndex(transactions);
+        int count = index.countBetween(options.rangeFrom, options.rangeTo);
+        std::cout << "\nTransactions from " << options.rangeFrom << " to " << options.rangeTo << ": " << count << std::endl;
+        std::cout << "Revenue: " << index.revenueBetween(options.rangeFrom, options.rangeTo)
+                  << ", average price: " << index.averageBetween(options.rangeFrom, options.rangeTo) << std::endl;
 
-    if (totalTransactions > 100) {
-        std::cout << "\n... and " << (totalTransactions - 100) << " more transactions" << std::endl;
+        RowRange first = index.firstRowsBetween(options.rangeFrom, options.rangeTo, 5);
+        std::cout << "First " << first.count() << " in range:" << std::endl;
+        for (int p = first.begin; p < first.end; p++) {
+            printTransaction(transactions[index.rowAt(p)]);
+        }
     }
 
     // 2. What percentage of purchases in the "Electronics" category were made using Credit Card payments?
     std::cout << "\n2. What percentage of purchases in the \"Electronics\" category were made using Credit Card payments?" << std::endl;
     
+    ScopedTimer scanTimer("scan.electronicsCreditCard");
     int totalElectronics = 0;
     int electronicsCreditCard = 0;
     
-    for (int i = 0; i < transactions.getSize(); i++) {
-        const Transaction& t = transactions[i];
-        if (t.category == "Electronics") {
+    if (options.useBitmapIndex) {
+        // Bitmap AND + popcount instead of comparing strings row by row
+        const TransactionBitmapIndex& index = analyzer.getFilterIndex();
+        totalElectronics = index.count(TransactionColumn::Category, "Electronics");
+        electronicsCreditCard = index.countAnd(TransactionColumn::Category, "Electronics",
+                                               TransactionColumn::PaymentMethod, "Credit Card");
+    } else {
+        for (int i = 0; i < transactions.getSize(); i++) {
+            const T& t = transactions[i];
+            if (t.category == "Electronics") {
+                totalElectronics++;
+                if (t.paymentMethod == "Credit Card") {
+                    electronicsCreditCard++;
+                }
+            }
+        }
+    }
+    scanTimer.addRows(transactions.getSize());
+    scanTimer.stop();
+    
+    printQuestion2(totalElectronics, electronicsCreditCard);
+}
+
+// Row number with its date key; --lazy sorts these instead of whole transactions
+struct DatedRow {
+    int key;
+    int row;
+
+    DatedRow(int k = 0, int r = 0) : key(k), row(r) {}
+};
+
+int compareDatedRows(const DatedRow& a, const DatedRow& b) {
+    return a.key - b.key;
+}
+
+// Questions 1 and 2 straight from the mapped transactions file. Question 1
+// decodes only the date column to sort and the 100 printed rows; Question 2
+// decodes only category and payment method.
+bool answerLazyTransactionQuestions(ArrayDataAnalyzer& analyzer, const std::string& path) {
+    LazyTable table;
+    std::string error;
+    if (!table.open(path, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
+    const char* names[6] = {"Customer ID", "Product", "Category", "Price", "Date", "Payment Method"};
+    int column[6];
+    for (int c = 0; c < 6; c++) {
+        column[c] = table.findColumn(names[c]);
+        if (column[c] < 0) {
+            std::cerr << "Error: " << path << " has no \"" << names[c] << "\" column" << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "1. How can you efficiently sort customer transactions by date and display the total number of transactions in both datasets?" << std::endl;
+
+    // Same comparisons as sorting the transactions themselves, so ties land the same way
+    ScopedTimer sortTimer("sort.transactionsByDate");
+    const Array<StringRef>& dates = table.text(column[4]);
+    Array<DatedRow> order(table.getRowCount() > 0 ? table.getRowCount() : 1);
+    for (int r = 0; r < table.getRowCount(); r++) {
+        order.push_back(DatedRow(dateSortKey(dates[r]), r));
+    }
+    analyzer.quickSort(order, compareDatedRows);
+    sortTimer.addRows(order.getSize());
+    sortTimer.stop();
+
+    printSortedTransactions(order.getSize(), [&](int i) {
+        int r = order[i].row;
+        return TransactionRef(table.textAt(r, column[0]), table.textAt(r, column[1]),
+                              table.textAt(r, column[2]), table.realAt(r, column[3]),
+                              table.textAt(r, column[4]), table.textAt(r, column[5]));
+    });
+
+    std::cout << "\n2. What percentage of purchases in the \"Electronics\" category were made using Credit Card payments?" << std::endl;
+    ScopedTimer scanTimer("scan.electronicsCreditCard");
+    const Array<StringRef>& categories = table.text(column[2]);
+    const Array<StringRef>& payments = table.text(column[5]);
+    int totalElectronics = 0;
+    int electronicsCreditCard = 0;
+    for (int r = 0; r < categories.getSize(); r++) {
+        if (categories[r] == "Electronics") {
             totalElectronics++;
-            if (t.paymentMethod == "Credit Card") {
+            if (payments[r] == "Credit Card") {
                 electronicsCreditCard++;
             }
         }
     }
+    scanTimer.addRows(categories.getSize());
+    scanTimer.stop();
+
+    printQuestion2(totalElectronics, electronicsCreditCard);
+    return true;
+}
+
+void countTransaction(TransactionCounters& counters, const Transaction& t) {
+    counters.add(t);
+}
+
+void countTransaction(TransactionCounters& counters, const TransactionRef& t) {
+    counters.add(t.category.str(), t.paymentMethod.str(), 1);
+}
+
+// Fill the --cache entry for the loaded transactions: where each line starts
+// in date order (lineOffsets[i] is the start of transaction i) and the
+// category/payment counts
+template <typename T>
+void collectTransactionResults(ArrayDataAnalyzer& analyzer, const Array<T>& transactions,
+                               const Array<long long>& lineOffsets, AnalysisResults& results) {
+    ScopedTimer timer("cache.collect");
+    int total = transactions.getSize();
+    Array<DatedRow> order(total > 0 ? total : 1);
+    for (int i = 0; i < total; i++) {
+        order.push_back(DatedRow(dateSortKey(transactions[i].date), i));
+    }
+    analyzer.quickSort(order, compareDatedRows);
+    results.sortedOffsets = Array<long long>(total > 0 ? total : 1);
+    for (int i = 0; i < total; i++) {
+        results.sortedOffsets.push_back(lineOffsets[order[i].row]);
+        countTransaction(results.counters, transactions[i]);
+    }
+    timer.addRows(total);
+}
+
+// All three answers from a --cache entry. Only the 100 listed transactions
+// are read back from the file.
+bool answerCachedQuestions(const AnalysisResults& results, const std::string& path) {
+    MappedFile file;
+    std::string error;
+    if (!file.open(path, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
+
+    std::cout << "1. How can you efficiently sort customer transactions by date and display the total number of transactions in both datasets?" << std::endl;
+    printSortedTransactions(results.sortedOffsets.getSize(), [&file, &results](int i) {
+        long long offset = results.sortedOffsets[i];
+        const char* begin = file.data() + offset;
+        const char* end = static_cast<const char*>(std::memchr(begin, '\n', file.size() - offset));
+        std::string line(begin, end ? end : file.data() + file.size());
+        Transaction t;
+        TransactionRow::parse(line, t);
+        return t;
+    });
+
+    std::cout << "\n2. What percentage of purchases in the \"Electronics\" category were made using Credit Card payments?" << std::endl;
+    printQuestion2(results.counters.category("Electronics"), results.counters.categoryPayment("Electronics", "Credit Card"));
+
+    std::cout << "\n3. Which words are most frequently used in product reviews rated 1-star?" << std::endl;
+    printTopWords(results.topWords);
+    return true;
+}
+
+// All three answers from the aggregates kept up to date in incremental mode
+void answerIncrementalQuestions(ArrayDataAnalyzer& analyzer) {
+    // Question 2 leaves the stream in fixed two-decimal mode; undo it for each round
+    std::cout << std::defaultfloat << std::setprecision(6);
+    std::cout << "1. How can you efficiently sort customer transactions by date and display the total number of transactions in both datasets?" << std::endl;
+    const Array<Transaction>& transactions = analyzer.getSortedTransactions();
+    printSortedTransactions(transactions.getSize(),
+                            [&transactions](int i) -> const Transaction& { return transactions[i]; });
+
+    std::cout << "\n2. What percentage of purchases in the \"Electronics\" category were made using Credit Card payments?" << std::endl;
+    const TransactionCounters& counters = analyzer.getTransactionCounters();
+    printQuestion2(counters.category("Electronics"), counters.categoryPayment("Electronics", "Credit Card"));
+
+    std::cout << "\n3. Which words are most frequently used in product reviews rated 1-star?" << std::endl;
+    printTopWords(analyzer.getTopFrequentWords(5));
+}
+
+// Incremental mode: load both files through append readers, answer, then
+// poll every intervalSeconds and re-answer whenever new rows have arrived
+void followFiles(ArrayDataAnalyzer& analyzer, int intervalSeconds) {
+    AppendReader transReader("transactions_cleaned.csv");
+    AppendReader reviewReader("reviews_cleaned.csv");
+    bool first = true;
+    while (true) {
+        Array<Transaction> newTransactions;
+        Array<Review> newReviews;
+        transReader.readNewLines([&newTransactions](std::string& line) {
+            Transaction trans;
+            if (TransactionRow::parse(line, trans)) newTransactions.push_back(trans);
+        });
+        reviewReader.readNewLines([&newReviews](std::string& line) {
+            Review review;
+            if (ReviewRow::parse(line, review)) newReviews.push_back(review);
+        });
+
+        if (first || newTransactions.getSize() > 0 || newReviews.getSize() > 0) {
+            analyzer.appendTransactions(newTransactions);
+            analyzer.appendReviews(newReviews);
+            if (!first) {
+                std::cout << "\n=== " << newTransactions.getSize() << " new transactions, "
+                          << newReviews.getSize() << " new reviews ===\n" << std::endl;
+            }
+            answerIncrementalQuestions(analyzer);
+            std::cout.flush();
+            first = false;
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(intervalSeconds));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Optional flags: --threads N, --counter sharded|thread-local, --metrics FILE, --perf, --arena,
+    // --range FROM TO (dates in the file's format), --bitmap, --count EXPR,
+    // --reviewer-spend RATING, --product-ratings K, --rfm K, --price-quantiles, --follow SECONDS, --query TEXT, --lazy,
+    // --cache DIR, --search QUERY, --search-rating N, --search-product ID, --review-index FILE,
+    // --transactions-input SOURCE, --reviews-input SOURCE ("-" for stdin, fd:N or a path)
+    int numThreads = 1;
+    QueryOptions options;
+    Array<std::string> filterExpressions;
+    Array<std::string> queries;
+    int reviewerRating = 0;
+    int productRankSize = 0;
+    int rfmTopSize = 0;
+    bool usePriceQuantiles = false;
+    Array<std::string> searches;
+    ReviewQuery searchFilter;       // Filters shared by every --search
+    std::string reviewIndexPath;
+    int followInterval = 0;
+    bool useArena = false;
+    bool useLazy = false;
+    std::string cacheDir;
+    std::string transSource, reviewSource;
+    std::string metricsPath;
+    bool usePerfCounters = false;
+    CounterMode counterMode = CounterMode::ThreadLocal;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            numThreads = std::atoi(argv[++i]);
+        } else if (arg == "--counter" && i + 1 < argc) {
+            if (!parseCounterMode(argv[++i], counterMode)) {
+                std::cerr << "Unknown counter mode: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else if (arg == "--perf") {
+            usePerfCounters = true;
+        } else if (arg == "--arena") {
+            useArena = true;
+        } else if (arg == "--range" && i + 2 < argc) {
+            options.rangeFrom = argv[++i];
+            options.rangeTo = argv[++i];
+        } else if (arg == "--lazy") {
+            useLazy = true;
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (arg == "--transactions-input" && i + 1 < argc) {
+            transSource = argv[++i];
+        } else if (arg == "--reviews-input" && i + 1 < argc) {
+            reviewSource = argv[++i];
+        } else if (arg == "--bitmap") {
+            options.useBitmapIndex = true;
+        } else if (arg == "--count" && i + 1 < argc) {
+            filterExpressions.push_back(argv[++i]);
+        } else if (arg == "--query" && i + 1 < argc) {
+            queries.push_back(argv[++i]);
+        } else if (arg == "--follow" && i + 1 < argc) {
+            followInterval = std::atoi(argv[++i]);
+            if (followInterval < 1) {
+                std::cerr << "Error: --follow expects a polling interval in seconds" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--reviewer-spend" && i + 1 < argc) {
+            reviewerRating = std::atoi(argv[++i]);
+            if (reviewerRating < 1 || reviewerRating > 5) {
+                std::cerr << "Error: --reviewer-spend expects a rating from 1 to 5" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--search" && i + 1 < argc) {
+            searches.push_back(argv[++i]);
+        } else if (arg == "--search-rating" && i + 1 < argc) {
+            searchFilter.rating = std::atoi(argv[++i]);
+            if (searchFilter.rating < 1 || searchFilter.rating > 5) {
+                std::cerr << "Error: --search-rating expects a rating from 1 to 5" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--search-product" && i + 1 < argc) {
+            searchFilter.productId = argv[++i];
+        } else if (arg == "--review-index" && i + 1 < argc) {
+            reviewIndexPath = argv[++i];
+        } else if (arg == "--price-quantiles") {
+            usePriceQuantiles = true;
+        } else if (arg == "--product-ratings" && i + 1 < argc) {
+            productRankSize = std::atoi(argv[++i]);
+            if (productRankSize < 1) {
+                std::cerr << "Error: --product-ratings expects the number of products to list" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--rfm" && i + 1 < argc) {
+            rfmTopSize = std::atoi(argv[++i]);
+            if (rfmTopSize < 1) {
+                std::cerr << "Error: --rfm expects the number of customers to list" << std::endl;
+                return 1;
+            }
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--threads N] [--counter sharded|thread-local] [--metrics FILE] [--perf] [--arena]"
+                      << " [--range FROM TO] [--bitmap] [--count column=value&...]"
+                      << " [--reviewer-spend RATING] [--product-ratings K] [--rfm K] [--price-quantiles] [--follow SECONDS] [--query TEXT] [--lazy] [--cache DIR]"
+                      << " [--search QUERY] [--search-rating N] [--search-product ID] [--review-index FILE]"
+                      << " [--transactions-input -|fd:N|FILE] [--reviews-input -|fd:N|FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (useLazy && (useArena || options.useBitmapIndex || !options.rangeFrom.empty() || reviewerRating > 0 ||
+                    rfmTopSize > 0 || usePriceQuantiles || filterExpressions.getSize() > 0 || queries.getSize() > 0)) {
+        std::cerr << "Error: --lazy does not load the transactions and cannot be combined with"
+                  << " --arena, --range, --bitmap, --count, --query, --reviewer-spend, --rfm or --price-quantiles" << std::endl;
+        return 1;
+    }
+
+    if (followInterval > 0 && (useLazy || useArena || options.useBitmapIndex || !options.rangeFrom.empty() ||
+                               reviewerRating > 0 || productRankSize > 0 || rfmTopSize > 0 || usePriceQuantiles ||
+                               filterExpressions.getSize() > 0 || queries.getSize() > 0 || searches.getSize() > 0 ||
+                               searchFilter.rating > 0 || !searchFilter.productId.empty() || !reviewIndexPath.empty() ||
+                               !metricsPath.empty())) {
+        std::cerr << "Error: --follow answers only the three standard questions and cannot be combined with"
+                  << " --lazy, --arena, --range, --bitmap, --count, --query, --reviewer-spend, --product-ratings,"
+                  << " --rfm, --price-quantiles, --search, --search-rating, --search-product, --review-index or --metrics"
+                  << std::endl;
+        return 1;
+    }
+
+    if (!cacheDir.empty() && (useLazy || followInterval > 0 || !options.rangeFrom.empty() || reviewerRating > 0 ||
+                              productRankSize > 0 || rfmTopSize > 0 || usePriceQuantiles || searches.getSize() > 0 ||
+                              filterExpressions.getSize() > 0 || queries.getSize() > 0)) {
+        std::cerr << "Error: --cache stores only the three standard answers and cannot be combined with"
+                  << " --lazy, --follow, --range, --count, --query, --reviewer-spend, --product-ratings,"
+                  << " --rfm, --price-quantiles or --search" << std::endl;
+        return 1;
+    }
+
+    bool streaming = !transSource.empty() || !reviewSource.empty();
+    if (streaming && (useLazy || followInterval > 0 || !cacheDir.empty() || !reviewIndexPath.empty())) {
+        std::cerr << "Error: --transactions-input and --reviews-input read each input once and cannot be combined with"
+                  << " --lazy, --follow, --cache or --review-index" << std::endl;
+        return 1;
+    }
+    if (transSource == "-" && reviewSource == "-") {
+        std::cerr << "Error: only one of --transactions-input and --reviews-input can read stdin" << std::endl;
+        return 1;
+    }
+
+    Array<ReviewQuery> reviewQueries;
+    for (int i = 0; i < searches.getSize(); i++) {
+        ReviewQuery query = searchFilter;
+        std::string queryError;
+        if (!parseReviewQuery(searches[i], query, queryError)) {
+            std::cerr << "Invalid search (" << queryError << "): " << searches[i] << std::endl;
+            return 1;
+        }
+        reviewQueries.push_back(query);
+    }
+
+    if (usePerfCounters && metricsPath.empty()) {
+        std::cerr << "Error: --perf adds hardware counters to the --metrics output and needs --metrics FILE" << std::endl;
+        return 1;
+    }
+    if (!metricsPath.empty()) {
+        Metrics::instance().enable("array_analysis");
+    }
+    std::string perfError;
+    if (usePerfCounters && !Metrics::instance().enablePerfCounters(perfError)) {
+        std::cerr << "Warning: hardware counters unavailable (" << perfError << "); reporting times only" << std::endl;
+    }
+
+    ArrayDataAnalyzer analyzer;
+
+    if (followInterval > 0) {
+        followFiles(analyzer, followInterval);
+        return 0;
+    }
+
+    // The key covers everything the cached answers depend on besides the inputs
+    ResultCache cache(cacheDir, "transactions_cleaned.csv", "reviews_cleaned.csv", "rating=1;top=5");
+    AnalysisResults results;
+    if (!cacheDir.empty()) {
+        if (cache.load(results)) {
+            countMetric("cache.hits", 1);
+            if (!answerCachedQuestions(results, "transactions_cleaned.csv")) return 1;
+            if (!metricsPath.empty() && !Metrics::instance().writeJson(metricsPath)) {
+                std::cerr << "Error: Could not write metrics to " << metricsPath << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+        countMetric("cache.misses", 1);
+    }
+
+    if (usePriceQuantiles) {
+        analyzer.enablePriceStatistics();
+    }
+
+    // Read transactions
+    ScopedTimer transIngestTimer("ingest.transactions");
+    LineInput transFile;
+    std::string inputError;
+    if (!transSource.empty()) {
+        if (!transFile.openStream(transSource, inputError)) {
+            std::cerr << "Error: --transactions-input: " << inputError << std::endl;
+            return 1;
+        }
+    } else if (!useLazy) {
+        // --lazy maps the file later instead; the unopened input reads nothing
+        transFile.openFile("transactions_cleaned.csv");
+    }
+    std::string line;
+    long long rows = 0, bytes = 0;
+    Array<long long> lineOffsets;   // Start of each accepted row, kept for --cache
     
-    if (totalElectronics > 0) {
-        double percentage = (static_cast<double>(electronicsCreditCard) / totalElectronics) * 100;
-        std::cout << "\nOut of " << totalElectronics << " Electronics purchases:" << std::endl;
-        std::cout << electronicsCreditCard << " were made with Credit Card (" << std::fixed << std::setprecision(2) << percentage << "%)" << std::endl;
+    // Skip header
+    transFile.next(line);
+    long long lineStart = line.size() + 1;
+    
+    while (transFile.next(line)) {
+        rows++;
+        bytes += line.size() + 1;
+        bool accepted;
+        if (useArena) {
+            // Field bytes are copied straight from the line into the arena
+            TransactionRef ref;
+            accepted = TransactionRefRow::parse(line, ref);
+            if (accepted) analyzer.addTransaction(ref);
+        } else {
+            Transaction trans;
+            accepted = TransactionRow::parse(line, trans);
+            if (accepted) analyzer.addTransaction(trans);
+        }
+        if (accepted && !cacheDir.empty()) lineOffsets.push_back(lineStart);
+        lineStart += line.size() + 1;
+    }
+
+    if (transFile.failed(inputError)) {
+        std::cerr << "Error: reading transactions failed: " << inputError << std::endl;
+        return 1;
+    }
+    transIngestTimer.addRows(rows);
+    transIngestTimer.stop();
+    countMetric("ingest.transactions.rows", rows);
+    countMetric("ingest.transactions.bytes", bytes);
+
+    // Read reviews
+    ScopedTimer reviewIngestTimer("ingest.reviews");
+    LineInput reviewFile;
+    if (!reviewSource.empty()) {
+        if (!reviewFile.openStream(reviewSource, inputError)) {
+            std::cerr << "Error: --reviews-input: " << inputError << std::endl;
+            return 1;
+        }
     } else {
-        std::cout << "\nNo Electronics purchases found in the dataset." << std::endl;
+        reviewFile.openFile("reviews_cleaned.csv");
+    }
+    rows = 0;
+    bytes = 0;
+    
+    // Skip header
+    reviewFile.next(line);
+    
+    while (reviewFile.next(line)) {
+        rows++;
+        bytes += line.size() + 1;
+        if (useArena) {
+            ReviewRef ref;
+            if (ReviewRefRow::parse(line, ref)) {
+                analyzer.addReview(ref);
+            }
+            continue;
+        }
+        Review review;
+        if (ReviewRow::parse(line, review)) {
+            analyzer.addReview(review);
+        }
+    }
+
+    if (reviewFile.failed(inputError)) {
+        std::cerr << "Error: reading reviews failed: " << inputError << std::endl;
+        return 1;
+    }
+    reviewIngestTimer.addRows(rows);
+    reviewIngestTimer.stop();
+    countMetric("ingest.reviews.rows", rows);
+    countMetric("ingest.reviews.bytes", bytes);
+
+    if (options.useBitmapIndex || filterExpressions.getSize() > 0) {
+        analyzer.buildFilterIndexes();
+    }
+
+    if (useLazy) {
+        if (!answerLazyTransactionQuestions(analyzer, "transactions_cleaned.csv")) return 1;
+    } else if (useArena) {
+        answerTransactionQuestions(analyzer, analyzer.getArenaTransactions(), options);
+    } else {
+        answerTransactionQuestions(analyzer, analyzer.getTransactions(), options);
+    }
+
+    if (usePriceQuantiles) {
+        printPriceStatistics(analyzer.getPriceStatistics());
+    }
+
+    for (int i = 0; i < filterExpressions.getSize(); i++) {
+        long long matches = countFilter(analyzer.getFilterIndex(), filterExpressions[i]);
+        if (matches < 0) {
+            std::cerr << "Invalid filter (expected column=value&... with columns category, payment, product): "
+                      << filterExpressions[i] << std::endl;
+            return 1;
+        }
+        std::cout << "\nRows matching " << filterExpressions[i] << ": " << matches << std::endl;
+    }
+
+    for (int i = 0; i < queries.getSize(); i++) {
+        bool valid = useArena
+            ? printQuery(queries[i], analyzer.getArenaTransactions(), analyzer.getArenaReviews())
+            : printQuery(queries[i], analyzer.getTransactions(), analyzer.getReviews());
+        if (!valid) return 1;
+    }
+
+    if (reviewerRating > 0) {
+        analyzer.buildCustomerIndex();
+        ReviewerSpend spend = analyzer.getSpendOfReviewers(reviewerRating);
+        std::cout << "\nCustomers who left a " << reviewerRating << "-star review: " << spend.reviewers
+                  << " (" << spend.buyers << " with purchases)" << std::endl;
+        std::cout << "Their purchases: " << spend.transactions << ", total spend: " << spend.totalSpend << std::endl;
+        std::cout << "Average spend per customer: " << spend.averagePerBuyer()
+                  << ", per purchase: " << spend.averagePerTransaction() << std::endl;
+    }
+
+    if (productRankSize > 0) {
+        printProductRankings(analyzer.buildProductRatings(), productRankSize);
+    }
+
+    if (rfmTopSize > 0) {
+        printRfm(analyzer.buildRfm(), rfmTopSize);
+    }
+
+    if (reviewQueries.getSize() > 0) {
+        // A saved index is used when it matches the reviews file, otherwise rebuilt
+        std::string indexError;
+        if (reviewIndexPath.empty() || !analyzer.loadReviewIndex(reviewIndexPath, "reviews_cleaned.csv", indexError)) {
+            analyzer.buildReviewIndex("reviews_cleaned.csv");
+            if (!reviewIndexPath.empty() && !analyzer.getReviewIndex().save(reviewIndexPath, indexError)) {
+                std::cerr << "Warning: review index not saved (" << indexError << ")" << std::endl;
+            }
+        }
+        for (int i = 0; i < reviewQueries.getSize(); i++) {
+            Array<int> rows = analyzer.getReviewIndex().search(reviewQueries[i]);
+            if (analyzer.usesArenaRecords()) {
+                printSearchResult(searches[i], reviewQueries[i], rows, analyzer.getArenaReviews());
+            } else {
+                printSearchResult(searches[i], reviewQueries[i], rows, analyzer.getReviews());
+            }
+        }
     }
 
     // 3. Which words are most frequently used in product reviews rated 1-star?
@@ -123,12 +791,32 @@ int main() {
 
     // Get all reviews and analyze negative reviews
     Array<Review> reviews = analyzer.getReviews();
-    analyzer.analyzeNegativeReviews();
-    Array<WordFrequency> topWords = analyzer.getTopFrequentWords(5);
+    if (numThreads > 1) {
+        analyzer.analyzeNegativeReviewsParallel(numThreads, counterMode);
+    } else {
+        analyzer.analyzeNegativeReviews();
+    }
+    printTopWords(analyzer.getTopFrequentWords(5));
 
-    std::cout << "\nTop 5 frequent words in negative reviews:\n";
-    for (int i = 0; i < topWords.getSize(); i++) {
-        std::cout << topWords[i].word << ": " << topWords[i].frequency << " occurrences\n";
+    if (!cacheDir.empty()) {
+        if (useArena) {
+            collectTransactionResults(analyzer, analyzer.getArenaTransactions(), lineOffsets, results);
+        } else {
+            collectTransactionResults(analyzer, analyzer.getTransactions(), lineOffsets, results);
+        }
+        results.topWords = analyzer.getTopFrequentWords(5);
+        std::string cacheError;
+        if (!cache.store(results, cacheError)) {
+            std::cerr << "Warning: results not cached (" << cacheError << ")" << std::endl;
+        }
+    }
+
+    if (!metricsPath.empty()) {
+        analyzer.reportMemoryUsage();
+    }
+    if (!metricsPath.empty() && !Metrics::instance().writeJson(metricsPath)) {
+        std::cerr << "Error: Could not write metrics to " << metricsPath << std::endl;
+        return 1;
     }
 
     return 0;
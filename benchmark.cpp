@@ -0,0 +1,453 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include "include/ArrayDataAnalyzer.h"
+#include "include/LinkedListDataAnalyzer.h"
+#include "include/DataGenerator.h"
+#include "include/RowSchema.h"
+#include "include/PerfCounters.h"
+
+// The phases timed for every backend, in run order
+enum BenchmarkPhase { PHASE_INGEST, PHASE_SORT, PHASE_SCAN, PHASE_NEGATIVE_REVIEWS, PHASE_COUNT };
+
+const char* const PHASE_NAMES[PHASE_COUNT] = {"ingest", "sortByDate", "electronicsCreditCard", "negativeReviews"};
+
+// Cleaned CSV lines held in one buffer; parsing happens in place
+struct BenchmarkTable {
+    std::string text;
+    Array<long long> lineStarts;    // One per row plus the end of the buffer
+
+    int getRowCount() const { return lineStarts.getSize() - 1; }
+
+    char* line(int row) { return &text[lineStarts[row]]; }
+    int lineLength(int row) const { return static_cast<int>(lineStarts[row + 1] - lineStarts[row] - 1); }
+};
+
+// A generated row that cleanData would keep: no empty field and no
+// NaN / Invalid placeholder
+bool isCleanRow(const char* row, int length) {
+    if (row[0] == ',' || row[length - 1] == ',') return false;
+    std::string text(row, length);
+    return text.find(",,") == std::string::npos && text.find("NaN") == std::string::npos &&
+           text.find("Invalid") == std::string::npos;
+}
+
+// Rows from the synthetic generator, keeping only clean ones until there are enough
+void generateCleanRows(BenchmarkTable& table, int rows, uint64_t seed, uint64_t tableId,
+                       GeneratedRowWriter writeRow, const GeneratedDates& dates) {
+    RowRandom random = blockRandom(seed, tableId, 0);
+    table.text.clear();
+    table.lineStarts = Array<long long>(rows + 1);
+    char row[MAX_GENERATED_ROW];
+    while (table.lineStarts.getSize() < rows) {
+        int length = static_cast<int>(writeRow(row, random, dates) - row) - 1;
+        if (isCleanRow(row, length)) {
+            table.lineStarts.push_back(table.text.size());
+            table.text.append(row, length + 1);
+        }
+    }
+    table.lineStarts.push_back(table.text.size());
+}
+
+// Opened by --perf; events that could not be opened read as zero
+PerfCounters hardwareCounters;
+
+// Wall time, heap activity and hardware counts of one phase run
+struct PhaseSample {
+    double seconds;
+    long long allocations;
+    long long allocatedBytes;
+    PerfSample perf;
+
+    PhaseSample() : seconds(0), allocations(0), allocatedBytes(0) {}
+};
+
+class PhaseClock {
+private:
+    std::chrono::steady_clock::time_point start;
+    AllocationStats startAllocations;
+    PerfSample startPerf;
+
+public:
+    PhaseClock() : startAllocations(AllocationTracker::snapshot()) {
+        hardwareCounters.read(startPerf);
+        start = std::chrono::steady_clock::now();
+    }
+
+    PhaseSample stop() const {
+        PhaseSample sample;
+        sample.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        hardwareCounters.read(sample.perf);
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            sample.perf.values[e] -= startPerf.values[e];
+        }
+        AllocationStats end = AllocationTracker::snapshot();
+        sample.allocations = end.allocations - startAllocations.allocations;
+        sample.allocatedBytes = end.bytesAllocated - startAllocations.bytesAllocated;
+        return sample;
+    }
+};
+
+// One pass over every phase with a fresh ArrayDataAnalyzer
+int runArrayPhases(BenchmarkTable& transactionLines, BenchmarkTable& reviewLines, PhaseSample* samples) {
+    ArrayDataAnalyzer analyzer;
+    PhaseClock ingest;
+    for (int r = 0; r < transactionLines.getRowCount(); r++) {
+        Transaction trans;
+        if (TransactionRow::parse(transactionLines.line(r), transactionLines.lineLength(r), trans)) {
+            analyzer.addTransaction(trans);
+        }
+    }
+    for (int r = 0; r < reviewLines.getRowCount(); r++) {
+        Review review;
+        if (ReviewRow::parse(reviewLines.line(r), reviewLines.lineLength(r), review)) {
+            analyzer.addReview(review);
+        }
+    }
+    samples[PHASE_INGEST] = ingest.stop();
+
+    // Same steps as the driver: copy the stored rows, then sort the copy
+    PhaseClock sort;
+    Array<Transaction> transactions = analyzer.getTransactions();
+    analyzer.quickSort(transactions, compareTransactionsByDate);
+    samples[PHASE_SORT] = sort.stop();
+
+    PhaseClock scan;
+    int electronicsCreditCard = 0;
+    for (int i = 0; i < transactions.getSize(); i++) {
+        if (transactions[i].category == "Electronics" && transactions[i].paymentMethod == "Credit Card") {
+            electronicsCreditCard++;
+        }
+    }
+    samples[PHASE_SCAN] = scan.stop();
+
+    PhaseClock negative;
+    analyzer.analyzeNegativeReviews();
+    samples[PHASE_NEGATIVE_REVIEWS] = negative.stop();
+    return electronicsCreditCard;
+}
+
+// Node-by-node copy of a list in O(n); the list's own copy is shallow
+template <typename T>
+void copyList(const LinkedList<T>& from, LinkedList<T>& to) {
+    Node<T>* head = nullptr;
+    Node<T>* tail = nullptr;
+    for (Node<T>* node = from.begin(); node; node = node->next) {
+        Node<T>* copy = new Node<T>(node->data);
+        if (tail) {
+            tail->next = copy;
+        } else {
+            head = copy;
+        }
+        tail = copy;
+    }
+    to.adopt(head);
+}
+
+// One pass over every phase with a fresh LinkedListDataAnalyzer
+int runListPhases(BenchmarkTable& transactionLines, BenchmarkTable& reviewLines, PhaseSample* samples) {
+    LinkedListDataAnalyzer analyzer;
+    PhaseClock ingest;
+    for (int r = 0; r < transactionLines.getRowCount(); r++) {
+        Transaction trans;
+        if (TransactionRow::parse(transactionLines.line(r), transactionLines.lineLength(r), trans)) {
+            analyzer.addTransaction(trans);
+        }
+    }
+    for (int r = 0; r < reviewLines.getRowCount(); r++) {
+        Review review;
+        if (ReviewRow::parse(reviewLines.line(r), reviewLines.lineLength(r), review)) {
+            analyzer.addReview(review);
+        }
+    }
+    samples[PHASE_INGEST] = ingest.stop();
+
+    PhaseClock sort;
+    LinkedList<Transaction> transactions;
+    copyList(analyzer.getTransactions(), transactions);
+    transactions.adopt(analyzer.mergeSort(transactions.release(), compareTransactionsByDate));
+    samples[PHASE_SORT] = sort.stop();
+
+    PhaseClock scan;
+    int electronicsCreditCard = 0;
+    for (Node<Transaction>* node = transactions.begin(); node; node = node->next) {
+        if (node->data.category == "Electronics" && node->data.paymentMethod == "Credit Card") {
+            electronicsCreditCard++;
+        }
+    }
+    samples[PHASE_SCAN] = scan.stop();
+
+    PhaseClock negative;
+    analyzer.analyzeNegativeReviews();
+    samples[PHASE_NEGATIVE_REVIEWS] = negative.stop();
+    return electronicsCreditCard;
+}
+
+// Two-sided 95% Student t quantiles for 1-30 degrees of freedom
+double studentT95(int degreesOfFreedom) {
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (degreesOfFreedom < 1) return 0;
+    return degreesOfFreedom <= 30 ? table[degreesOfFreedom - 1] : 1.96;
+}
+
+// Summary of one (backend, size, phase) cell over its repetitions
+struct BenchmarkResult {
+    std::string backend;
+    std::string phase;
+    int rows;                   // Rows per table
+    long long items;            // Records the phase touches
+    int repetitions;
+    double meanSeconds;
+    double stddevSeconds;
+    double ci95Seconds;         // Half-width of the 95% interval of the mean
+    double minSeconds;
+    double medianSeconds;
+    long long allocations;      // Per run; zero unless built with -DTRACK_ALLOCATIONS
+    long long allocatedBytes;
+    double perf[PERF_EVENT_COUNT];  // Mean per run, with --perf
+
+    double itemsPerSecond() const { return meanSeconds > 0 ? items / meanSeconds : 0; }
+
+    double ipc() const { return perf[PERF_CYCLES] > 0 ? perf[PERF_INSTRUCTIONS] / perf[PERF_CYCLES] : 0; }
+    double perItem(int event) const { return items > 0 ? perf[event] / items : 0; }
+};
+
+int compareDoubles(const double& a, const double& b) {
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+BenchmarkResult summarize(const std::string& backend, int phase, int rows, long long items,
+                          const Array<PhaseSample>& samples) {
+    BenchmarkResult result;
+    result.backend = backend;
+    result.phase = PHASE_NAMES[phase];
+    result.rows = rows;
+    result.items = items;
+    int n = samples.getSize();
+    result.repetitions = n;
+
+    Array<double> seconds(n > 0 ? n : 1);
+    double sum = 0;
+    for (int i = 0; i < n; i++) {
+        seconds.push_back(samples[i].seconds);
+        sum += samples[i].seconds;
+    }
+    result.meanSeconds = n > 0 ? sum / n : 0;
+    double squares = 0;
+    for (int i = 0; i < n; i++) {
+        squares += (seconds[i] - result.meanSeconds) * (seconds[i] - result.meanSeconds);
+    }
+    result.stddevSeconds = n > 1 ? std::sqrt(squares / (n - 1)) : 0;
+    result.ci95Seconds = n > 1 ? studentT95(n - 1) * result.stddevSeconds / std::sqrt(static_cast<double>(n)) : 0;
+
+    ArrayDataAnalyzer sorter;
+    sorter.quickSort(seconds, compareDoubles);
+    result.minSeconds = n > 0 ? seconds[0] : 0;
+    result.medianSeconds = n == 0 ? 0 : (n % 2 == 1 ? seconds[n / 2] : (seconds[n / 2 - 1] + seconds[n / 2]) / 2);
+    result.allocations = n > 0 ? samples[n - 1].allocations : 0;
+    result.allocatedBytes = n > 0 ? samples[n - 1].allocatedBytes : 0;
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        double total = 0;
+        for (int i = 0; i < n; i++) {
+            total += samples[i].perf.values[e];
+        }
+        result.perf[e] = n > 0 ? total / n : 0;
+    }
+    return result;
+}
+
+void writeCsv(std::ostream& out, const Array<BenchmarkResult>& results) {
+    out << "backend,phase,rows,items,repetitions,meanSeconds,stddevSeconds,ci95Seconds,"
+        << "minSeconds,medianSeconds,itemsPerSecond,allocations,allocatedBytes,"
+        << "ipc,cacheMissesPerItem,branchMissesPerItem,dtlbMissesPerItem\n";
+    for (int i = 0; i < results.getSize(); i++) {
+        const BenchmarkResult& r = results[i];
+        out << r.backend << "," << r.phase << "," << r.rows << "," << r.items << "," << r.repetitions << ","
+            << r.meanSeconds << "," << r.stddevSeconds << "," << r.ci95Seconds << ","
+            << r.minSeconds << "," << r.medianSeconds << "," << r.itemsPerSecond() << ","
+            << r.allocations << "," << r.allocatedBytes;
+        // Left empty when the counters are not available
+        out << ",";
+        if (hardwareCounters.isOpen(PERF_CYCLES) && hardwareCounters.isOpen(PERF_INSTRUCTIONS)) out << r.ipc();
+        for (int e = PERF_CACHE_MISSES; e < PERF_EVENT_COUNT; e++) {
+            out << ",";
+            if (hardwareCounters.isOpen(e)) out << r.perItem(e);
+        }
+        out << "\n";
+    }
+}
+
+void writeJson(std::ostream& out, const Array<BenchmarkResult>& results, uint64_t seed) {
+    out << "{\n";
+    out << "  \"seed\": " << seed << ",\n";
+    out << "  \"allocationsTracked\": " << (AllocationTracker::isCompiledIn() ? "true" : "false") << ",\n";
+    out << "  \"results\": [";
+    for (int i = 0; i < results.getSize(); i++) {
+        const BenchmarkResult& r = results[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"backend\": \"" << r.backend << "\", \"phase\": \"" << r.phase << "\", "
+            << "\"rows\": " << r.rows << ", \"items\": " << r.items << ", "
+            << "\"repetitions\": " << r.repetitions << ", "
+            << "\"meanSeconds\": " << r.meanSeconds << ", \"stddevSeconds\": " << r.stddevSeconds << ", "
+            << "\"ci95Seconds\": " << r.ci95Seconds << ", \"minSeconds\": " << r.minSeconds << ", "
+            << "\"medianSeconds\": " << r.medianSeconds << ", \"itemsPerSecond\": " << r.itemsPerSecond() << ", "
+            << "\"allocations\": " << r.allocations << ", \"allocatedBytes\": " << r.allocatedBytes;
+        if (hardwareCounters.isOpen(PERF_CYCLES) && hardwareCounters.isOpen(PERF_INSTRUCTIONS)) {
+            out << ", \"ipc\": " << r.ipc();
+        }
+        for (int e = PERF_CACHE_MISSES; e < PERF_EVENT_COUNT; e++) {
+            if (hardwareCounters.isOpen(e)) out << ", \"" << PERF_EVENT_NAMES[e] << "PerItem\": " << r.perItem(e);
+        }
+        out << "}";
+    }
+    out << (results.getSize() > 0 ? "\n  ]\n" : "]\n");
+    out << "}\n";
+}
+
+// Comma-separated row counts, each accepting K/M/G suffixes
+bool parseSizes(const std::string& text, Array<int>& sizes) {
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        long long rows = parseRowCount(item.c_str());
+        if (rows < 1 || rows > 100000000) return false;
+        sizes.push_back(static_cast<int>(rows));
+    }
+    return sizes.getSize() > 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Times both analyzers on synthetic cleaned data over a range of sizes
+    Array<int> sizes;
+    int repetitions = 5;
+    int warmups = 1;
+    bool runArray = true;
+    bool runList = true;
+    int maxListRows = 10000;
+    uint64_t seed = 42;
+    bool json = false;
+    std::string outputPath = "-";
+    bool usePerfCounters = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            if (!parseSizes(argv[++i], sizes)) {
+                std::cerr << "Invalid size list: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            repetitions = std::atoi(argv[++i]);
+            if (repetitions < 1) {
+                std::cerr << "Invalid repetition count: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            warmups = std::atoi(argv[++i]);
+        } else if (arg == "--backend" && i + 1 < argc) {
+            std::string backend = argv[++i];
+            runArray = backend == "array" || backend == "both";
+            runList = backend == "list" || backend == "both";
+            if (!runArray && !runList) {
+                std::cerr << "Unknown backend: " << backend << std::endl;
+                return 1;
+            }
+        } else if (arg == "--max-list-rows" && i + 1 < argc) {
+            maxListRows = static_cast<int>(parseRowCount(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format != "csv" && format != "json") {
+                std::cerr << "Unknown output format: " << format << std::endl;
+                return 1;
+            }
+            json = format == "json";
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--perf") {
+            usePerfCounters = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--sizes N,N,...] [--repetitions R] [--warmup W]"
+                      << " [--backend array|list|both] [--max-list-rows N] [--seed S]"
+                      << " [--format csv|json] [--output FILE|-] [--perf]" << std::endl;
+            return 1;
+        }
+    }
+    if (sizes.getSize() == 0) {
+        // 10^3 to 10^5: the array sort degrades on repeated dates, so larger
+        // sizes take minutes each and are only run when asked for
+        for (int rows = 1000; rows <= 100000; rows *= 10) {
+            sizes.push_back(rows);
+        }
+    }
+
+    std::string perfError;
+    if (usePerfCounters && !hardwareCounters.open(perfError)) {
+        std::cerr << "Warning: hardware counters unavailable (" << perfError << "); reporting times only" << std::endl;
+    }
+
+    GeneratedDates dates;
+    BenchmarkTable transactionLines, reviewLines;
+    Array<BenchmarkResult> results;
+    for (int s = 0; s < sizes.getSize(); s++) {
+        int rows = sizes[s];
+        generateCleanRows(transactionLines, rows, seed, 1, writeTransactionRow, dates);
+        generateCleanRows(reviewLines, rows, seed, 2, writeReviewRow, dates);
+        // Records each phase reads: both tables, then transactions, then reviews
+        long long items[PHASE_COUNT] = {2LL * rows, rows, rows, rows};
+
+        for (int backend = 0; backend < 2; backend++) {
+            bool isArray = backend == 0;
+            if (isArray ? !runArray : !runList) continue;
+            const char* name = isArray ? "array" : "list";
+            // LinkedList::add walks the whole list, so list ingest is quadratic
+            if (!isArray && rows > maxListRows) {
+                std::cerr << "Skipping list at " << rows << " rows (over --max-list-rows " << maxListRows << ")" << std::endl;
+                continue;
+            }
+            std::cerr << "Running " << name << " at " << rows << " rows" << std::endl;
+
+            Array<PhaseSample> samples[PHASE_COUNT];
+            for (int run = 0; run < warmups + repetitions; run++) {
+                PhaseSample runSamples[PHASE_COUNT];
+                if (isArray) {
+                    runArrayPhases(transactionLines, reviewLines, runSamples);
+                } else {
+                    runListPhases(transactionLines, reviewLines, runSamples);
+                }
+                if (run < warmups) continue;
+                for (int p = 0; p < PHASE_COUNT; p++) {
+                    samples[p].push_back(runSamples[p]);
+                }
+            }
+            for (int p = 0; p < PHASE_COUNT; p++) {
+                results.push_back(summarize(name, p, rows, items[p], samples[p]));
+            }
+        }
+    }
+
+    std::ofstream file;
+    if (outputPath != "-") {
+        file.open(outputPath.c_str());
+        if (!file) {
+            std::cerr << "Error: Could not open " << outputPath << " for writing" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = outputPath == "-" ? std::cout : file;
+    if (json) {
+        writeJson(out, results, seed);
+    } else {
+        writeCsv(out, results);
+    }
+    return out.good() ? 0 : 1;
+}
@@ -1,6 +1,11 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <string>
+#include <cstdlib>
+#include "include/Metrics.h"
+#include "include/Deduplicator.h"
+#include "include/StreamReader.h"
 
 // Constants
 const int MAX_POSSIBLE_FIELDS = 20;
@@ -294,26 +299,80 @@ bool isValidTransactionLine(const Fields& fields, std::string& failReason) {
     return true;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Optional flags: --metrics FILE, --dedup-transactions KEY, --dedup-reviews KEY,
+    // --dedup-memory MB (KEY is "line" or a comma-separated list of header columns),
+    // --transactions-input SOURCE, --reviews-input SOURCE ("-" for stdin, fd:N or a path)
+    std::string metricsPath;
+    std::string transSource, reviewSource;
+    std::string transDedupKey, reviewDedupKey;
+    long long dedupMemoryMb = 256;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else if (strcmp(argv[i], "--dedup-transactions") == 0 && i + 1 < argc) {
+            transDedupKey = argv[++i];
+        } else if (strcmp(argv[i], "--dedup-reviews") == 0 && i + 1 < argc) {
+            reviewDedupKey = argv[++i];
+        } else if (strcmp(argv[i], "--dedup-memory") == 0 && i + 1 < argc) {
+            dedupMemoryMb = atoll(argv[++i]);
+            if (dedupMemoryMb < 1) {
+                std::cerr << "Error: --dedup-memory expects a size in MB" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--transactions-input") == 0 && i + 1 < argc) {
+            transSource = argv[++i];
+        } else if (strcmp(argv[i], "--reviews-input") == 0 && i + 1 < argc) {
+            reviewSource = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--metrics FILE] [--dedup-transactions line|COLUMNS]"
+                      << " [--dedup-reviews line|COLUMNS] [--dedup-memory MB]"
+                      << " [--transactions-input -|fd:N|FILE] [--reviews-input -|fd:N|FILE]" << std::endl;
+            return 1;
+        }
+    }
+    if (transSource == "-" && reviewSource == "-") {
+        std::cerr << "Error: only one of --transactions-input and --reviews-input can read stdin" << std::endl;
+        return 1;
+    }
+    if (!metricsPath.empty()) {
+        Metrics::instance().enable("clean_data");
+    }
+
     // Process transactions
-    std::ifstream transIn("transactions.csv");
-    std::ofstream transOut("transactions_cleaned.csv");
-    char line[MAX_LINE_LENGTH];
-    
-    if (!transIn.is_open()) {
+    ScopedTimer transTimer("clean.transactions");
+    LineInput transIn;
+    std::string inputError;
+    if (transSource.empty() && !transIn.openFile("transactions.csv")) {
         std::cerr << "Error: Could not open transactions.csv" << std::endl;
         return 1;
     }
+    if (!transSource.empty() && !transIn.openStream(transSource, inputError)) {
+        std::cerr << "Error: --transactions-input: " << inputError << std::endl;
+        return 1;
+    }
+    std::ofstream transOut("transactions_cleaned.csv");
+    char line[MAX_LINE_LENGTH];
     
     // Copy header
-    transIn.getline(line, MAX_LINE_LENGTH);
+    if (!transIn.next(line, MAX_LINE_LENGTH)) line[0] = '\0';
     transOut << line << std::endl;
+
+    Deduplicator transDedup(dedupMemoryMb << 20, "transactions_cleaned.csv.dedup",
+                            transSource.empty() ? "transactions.csv" : transSource);
+    std::string dedupError;
+    if (!transDedupKey.empty() && !transDedup.configure(transDedupKey, line, dedupError)) {
+        std::cerr << "Error: --dedup-transactions: " << dedupError << std::endl;
+        return 1;
+    }
     
     int totalTrans = 0, validTrans = 0;
+    long long bytesIn = 0;
     Fields fields;
     std::string failReason;
-    while (transIn.getline(line, MAX_LINE_LENGTH)) {
+    while (transIn.next(line, MAX_LINE_LENGTH)) {
         totalTrans++;
+        bytesIn += transIn.lastLineBytes();
         if (!parseCSVLine(line, fields, 6)) {
             continue;
         }
@@ -324,31 +383,65 @@ int main() {
         failReason = "";
         if (hasQuotes || isValidTransactionLine(fields, failReason)) {
             validTrans++;
-            transOut << line << std::endl;
+            if (!transDedup.isEnabled()) {
+                transOut << line << std::endl;
+            } else if (!transDedup.accept(line, strlen(line), transOut, dedupError)) {
+                std::cerr << "Error: " << dedupError << std::endl;
+                return 1;
+            }
         } else {
             continue;
         }
     }
+    if (transIn.failed(inputError)) {
+        std::cerr << "Error: reading transactions failed: " << inputError << std::endl;
+        return 1;
+    }
+    if (!transDedup.finish(transOut, dedupError)) {
+        std::cerr << "Error: " << dedupError << std::endl;
+        return 1;
+    }
     
-    transIn.close();
     transOut.close();
+    transTimer.stop();
+    countMetric("clean.transactions.rowsIn", totalTrans);
+    // Rows written: duplicates are only known after finish(), spilled ones included
+    countMetric("clean.transactions.rowsOut", validTrans - transDedup.getDuplicates());
+    countMetric("clean.transactions.bytesIn", bytesIn);
+    if (transDedup.isEnabled()) {
+        countMetric("clean.transactions.duplicates", transDedup.getDuplicates());
+        countMetric("clean.transactions.spilledRows", transDedup.getSpilledRows());
+    }
     
     // Process reviews
-    std::ifstream reviewIn("reviews.csv");
-    std::ofstream reviewOut("reviews_cleaned.csv");
-    
-    if (!reviewIn.is_open()) {
+    ScopedTimer reviewTimer("clean.reviews");
+    LineInput reviewIn;
+    if (reviewSource.empty() && !reviewIn.openFile("reviews.csv")) {
         std::cerr << "Error: Could not open reviews.csv" << std::endl;
         return 1;
     }
+    if (!reviewSource.empty() && !reviewIn.openStream(reviewSource, inputError)) {
+        std::cerr << "Error: --reviews-input: " << inputError << std::endl;
+        return 1;
+    }
+    std::ofstream reviewOut("reviews_cleaned.csv");
     
     // Copy header
-    reviewIn.getline(line, MAX_LINE_LENGTH);
+    if (!reviewIn.next(line, MAX_LINE_LENGTH)) line[0] = '\0';
     reviewOut << line << std::endl;
+
+    Deduplicator reviewDedup(dedupMemoryMb << 20, "reviews_cleaned.csv.dedup",
+                             reviewSource.empty() ? "reviews.csv" : reviewSource);
+    if (!reviewDedupKey.empty() && !reviewDedup.configure(reviewDedupKey, line, dedupError)) {
+        std::cerr << "Error: --dedup-reviews: " << dedupError << std::endl;
+        return 1;
+    }
     
     int totalReviews = 0, validReviews = 0;
-    while (reviewIn.getline(line, MAX_LINE_LENGTH)) {
+    bytesIn = 0;
+    while (reviewIn.next(line, MAX_LINE_LENGTH)) {
         totalReviews++;
+        bytesIn += reviewIn.lastLineBytes();
         
         // Manual check for valid review format
         char lineCopy[MAX_LINE_LENGTH];
@@ -431,20 +524,51 @@ int main() {
         
         // If we get here, the review is valid
         validReviews++;
-        reviewOut << line << std::endl;
+        if (!reviewDedup.isEnabled()) {
+            reviewOut << line << std::endl;
+        } else if (!reviewDedup.accept(line, strlen(line), reviewOut, dedupError)) {
+            std::cerr << "Error: " << dedupError << std::endl;
+            return 1;
+        }
+    }
+    if (reviewIn.failed(inputError)) {
+        std::cerr << "Error: reading reviews failed: " << inputError << std::endl;
+        return 1;
+    }
+    if (!reviewDedup.finish(reviewOut, dedupError)) {
+        std::cerr << "Error: " << dedupError << std::endl;
+        return 1;
     }
     
-    reviewIn.close();
     reviewOut.close();
+    reviewTimer.stop();
+    countMetric("clean.reviews.rowsIn", totalReviews);
+    countMetric("clean.reviews.rowsOut", validReviews - reviewDedup.getDuplicates());
+    countMetric("clean.reviews.bytesIn", bytesIn);
+    if (reviewDedup.isEnabled()) {
+        countMetric("clean.reviews.duplicates", reviewDedup.getDuplicates());
+        countMetric("clean.reviews.spilledRows", reviewDedup.getSpilledRows());
+    }
     
     // Print statistics
     std::cout << "Transactions processed: " << totalTrans << std::endl;
     std::cout << "Valid transactions: " << validTrans << std::endl;
     std::cout << "Invalid transactions removed: " << (totalTrans - validTrans) << std::endl;
+    if (transDedup.isEnabled()) {
+        std::cout << "Duplicate transactions removed: " << transDedup.getDuplicates() << std::endl;
+    }
     
     std::cout << "\nReviews processed: " << totalReviews << std::endl;
     std::cout << "Valid reviews: " << validReviews << std::endl;
     std::cout << "Invalid reviews removed: " << (totalReviews - validReviews) << std::endl;
+    if (reviewDedup.isEnabled()) {
+        std::cout << "Duplicate reviews removed: " << reviewDedup.getDuplicates() << std::endl;
+    }
+    
+    if (!metricsPath.empty() && !Metrics::instance().writeJson(metricsPath)) {
+        std::cerr << "Error: Could not write metrics to " << metricsPath << std::endl;
+        return 1;
+    }
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "include/ExternalSort.h"
+
+// Parse a size such as 512K, 64M or 1G (plain numbers are megabytes)
+long long parseMemorySize(const char* text) {
+    char* end = nullptr;
+    double value = std::strtod(text, &end);
+    if (end == text || value <= 0) return -1;
+    switch (*end) {
+        case 'k': case 'K': return static_cast<long long>(value * 1024);
+        case 'g': case 'G': return static_cast<long long>(value * 1024 * 1024 * 1024);
+        default: return static_cast<long long>(value * 1024 * 1024);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Sorts transactions_cleaned.csv by date without holding it in memory
+    std::string inputPath = "transactions_cleaned.csv";
+    std::string outputPath = "transactions_sorted.csv";
+    std::string metricsPath;
+    ExternalSortOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            inputPath = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            options.memoryBudget = parseMemorySize(argv[++i]);
+            if (options.memoryBudget < 0) {
+                std::cerr << "Invalid memory size: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--temp-dir") == 0 && i + 1 < argc) {
+            options.tempDir = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            ++i;
+            if (strcmp(argv[i], "csv") == 0) {
+                options.format = SortOutputFormat::Csv;
+            } else if (strcmp(argv[i], "binary") == 0) {
+                options.format = SortOutputFormat::Binary;
+            } else {
+                std::cerr << "Unknown output format: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--input FILE] [--output FILE|-] [--memory SIZE]"
+                      << " [--temp-dir DIR] [--format csv|binary] [--metrics FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (!metricsPath.empty()) {
+        Metrics::instance().enable("external_sort");
+    }
+
+    bool toStdout = outputPath == "-";
+    std::FILE* output = toStdout ? stdout : std::fopen(outputPath.c_str(), "wb");
+    if (!output) {
+        std::cerr << "Error: Could not open " << outputPath << " for writing" << std::endl;
+        return 1;
+    }
+
+    ExternalSorter sorter(options);
+    bool ok = sorter.sort(inputPath, output);
+    if (!toStdout && std::fclose(output) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        std::cerr << "Error: " << (sorter.getError().empty() ? "could not write " + outputPath : sorter.getError()) << std::endl;
+        return 1;
+    }
+
+    const ExternalSortStats& stats = sorter.getStats();
+    std::cerr << "Sorted " << stats.rows << " transactions in " << stats.runs << " run(s), "
+              << stats.mergePasses << " merge pass(es)";
+    if (stats.rejectedRows > 0) {
+        std::cerr << "; skipped " << stats.rejectedRows << " malformed row(s)";
+    }
+    std::cerr << std::endl;
+
+    if (!metricsPath.empty() && !Metrics::instance().writeJson(metricsPath)) {
+        std::cerr << "Error: Could not write metrics to " << metricsPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
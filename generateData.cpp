@@ -0,0 +1,106 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include "include/DataGenerator.h"
+
+void printTableSummary(const std::string& path, const GeneratedTable& table) {
+    double megabytes = table.bytes / (1024.0 * 1024.0);
+    std::cerr << "Wrote " << table.rows << " rows (" << std::fixed << std::setprecision(1)
+              << megabytes << " MB) to " << path << " in " << std::setprecision(2) << table.seconds
+              << "s, " << std::setprecision(0) << (table.seconds > 0 ? megabytes / table.seconds : 0)
+              << " MB/s" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    // Writes transactions.csv and reviews.csv in the raw input format, to a
+    // separate directory so the bundled samples are never overwritten
+    GeneratorOptions options;
+    unsigned hardwareThreads = std::thread::hardware_concurrency();
+    options.threads = hardwareThreads > 0 ? static_cast<int>(hardwareThreads) : 1;
+    std::string outputDir = "generated";
+    std::string metricsPath;
+    bool reviewRowsGiven = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--rows" || arg == "--review-rows") && i + 1 < argc) {
+            long long rows = parseRowCount(argv[++i]);
+            if (rows < 0) {
+                std::cerr << "Invalid row count: " << argv[i] << std::endl;
+                return 1;
+            }
+            if (arg == "--rows") {
+                options.transactionRows = rows;
+            } else {
+                options.reviewRows = rows;
+                reviewRowsGiven = true;
+            }
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::atoi(argv[++i]);
+            if (options.threads < 1) {
+                std::cerr << "Invalid thread count: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--output-dir" && i + 1 < argc) {
+            outputDir = argv[++i];
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--rows N] [--review-rows N] [--seed S]"
+                      << " [--threads T] [--output-dir DIR] [--metrics FILE]" << std::endl;
+            return 1;
+        }
+    }
+    if (!reviewRowsGiven) {
+        options.reviewRows = options.transactionRows;
+    }
+
+    if (!metricsPath.empty()) {
+        Metrics::instance().enable("generate_data");
+    }
+
+    if (mkdir(outputDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Error: Could not create " << outputDir << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    GeneratedDates dates;
+    TableGenerator generator(options, dates);
+    std::string error;
+    GeneratedTable transactions, reviews;
+    std::string transactionsPath = outputDir + "/transactions.csv";
+    std::string reviewsPath = outputDir + "/reviews.csv";
+    {
+        ScopedTimer timer("generate.transactions");
+        if (!generator.generate(transactionsPath, "Customer ID,Product,Category,Price,Date,Payment Method",
+                                options.transactionRows, 1, writeTransactionRow, transactions, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+    }
+    {
+        ScopedTimer timer("generate.reviews");
+        if (!generator.generate(reviewsPath, "Product ID,Customer ID,Rating,Review Text",
+                                options.reviewRows, 2, writeReviewRow, reviews, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+    }
+    countMetric("generate.rows", transactions.rows + reviews.rows);
+    countMetric("generate.bytes", transactions.bytes + reviews.bytes);
+
+    printTableSummary(transactionsPath, transactions);
+    printTableSummary(reviewsPath, reviews);
+
+    if (!metricsPath.empty() && !Metrics::instance().writeJson(metricsPath)) {
+        std::cerr << "Error: Could not write metrics to " << metricsPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
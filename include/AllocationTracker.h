@@ -0,0 +1,135 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Snapshot of the global allocation counters
+struct AllocationStats {
+    long long allocations;
+    long long frees;
+    long long bytesAllocated;
+    long long liveBytes;
+    long long peakLiveBytes;
+
+    AllocationStats() : allocations(0), frees(0), bytesAllocated(0), liveBytes(0), peakLiveBytes(0) {}
+};
+
+// Counting hooks for the global operator new/delete.
+// The hooks are only installed when compiled with -DTRACK_ALLOCATIONS; without
+// it isCompiledIn() is false and every snapshot reads zero.
+class AllocationTracker {
+private:
+    struct Counters {
+        std::atomic<long long> allocations;
+        std::atomic<long long> frees;
+        std::atomic<long long> bytesAllocated;
+        std::atomic<long long> liveBytes;
+        std::atomic<long long> peakLiveBytes;
+    };
+
+    // Static storage is zero-initialized before any allocation can happen
+    static Counters& counters() {
+        static Counters instance;
+        return instance;
+    }
+
+public:
+    static bool isCompiledIn() {
+#ifdef TRACK_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static void recordAllocation(size_t bytes) {
+        Counters& c = counters();
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+        c.bytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+        long long live = c.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        long long peak = c.peakLiveBytes.load(std::memory_order_relaxed);
+        while (live > peak && !c.peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+    }
+
+    static void recordFree(size_t bytes) {
+        Counters& c = counters();
+        c.frees.fetch_add(1, std::memory_order_relaxed);
+        c.liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    static AllocationStats snapshot() {
+        Counters& c = counters();
+        AllocationStats stats;
+        stats.allocations = c.allocations.load(std::memory_order_relaxed);
+        stats.frees = c.frees.load(std::memory_order_relaxed);
+        stats.bytesAllocated = c.bytesAllocated.load(std::memory_order_relaxed);
+        stats.liveBytes = c.liveBytes.load(std::memory_order_relaxed);
+        stats.peakLiveBytes = c.peakLiveBytes.load(std::memory_order_relaxed);
+        return stats;
+    }
+};
+
+#ifdef TRACK_ALLOCATIONS
+// Replacement global allocation functions. Each block carries a 16-byte header
+// holding the requested size so frees can be accounted. Every program in this
+// project is a single translation unit, so defining them here is safe; include
+// this header from only one .cpp file when building anything larger.
+static const size_t ALLOCATION_HEADER_SIZE = 16;
+
+inline void* trackedAllocate(size_t size) {
+    void* block = std::malloc(size + ALLOCATION_HEADER_SIZE);
+    if (!block) return nullptr;
+    *static_cast<size_t*>(block) = size;
+    AllocationTracker::recordAllocation(size);
+    return static_cast<char*>(block) + ALLOCATION_HEADER_SIZE;
+}
+
+inline void trackedFree(void* ptr) {
+    if (!ptr) return;
+    void* block = static_cast<char*>(ptr) - ALLOCATION_HEADER_SIZE;
+    AllocationTracker::recordFree(*static_cast<size_t*>(block));
+    std::free(block);
+}
+
+void* operator new(size_t size) {
+    void* ptr = trackedAllocate(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    void* ptr = trackedAllocate(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return trackedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return trackedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    trackedFree(ptr);
+}
+#endif
+
+#endif
@@ -37,7 +37,7 @@ public:
 
     void push_back(const T& element) {
         if (size == capacity) {
-            resize(capacity * 2);
+            resize(capacity > 0 ? capacity * 2 : 1);
         }
         data[size++] = element;
     }
@@ -57,6 +57,11 @@ public:
     }
 
     int getSize() const { return size; }
+    int getCapacity() const { return capacity; }
+
+    // Raw element storage, for tight loops that should skip bounds checks
+    T* getData() { return data; }
+    const T* getData() const { return data; }
 
     // Copy assignment operator
     Array& operator=(const Array& other) {
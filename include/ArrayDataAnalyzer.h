@@ -6,8 +6,20 @@
 #include <algorithm>
 #include <cctype>
 #include <stack>
+#include <thread>
 #include "Array.h"
 #include "DataStructures.h"
+#include "ConcurrentWordCounter.h"
+#include "Metrics.h"
+#include "MemoryAccounting.h"
+#include "TimeIndex.h"
+#include "BitmapIndex.h"
+#include "CustomerIndex.h"
+#include "ProductRatings.h"
+#include "PriceSketch.h"
+#include "ReviewIndex.h"
+#include "CustomerRfm.h"
+#include "IncrementalState.h"
 
 class ArrayDataAnalyzer {
 private:
@@ -15,6 +27,27 @@ private:
     Array<Review> reviews;
     Array<WordFrequency> wordFrequencies;
 
+    // Arena-backed records: string bytes live in stringArena
+    StringArena stringArena;
+    Array<TransactionRef> arenaTransactions;
+    Array<ReviewRef> arenaReviews;
+
+    TimeIndex timeIndex;
+    TransactionBitmapIndex filterIndex;
+    CustomerIndex customerIndex;
+    ProductRatingTable productRatings;
+    RfmTable rfm;
+    ReviewIndex reviewIndex;
+
+    // Price sketches filled as transactions are added, once enabled
+    PriceStatistics priceStatistics;
+    bool collectPrices;
+
+    // Incremental mode: aggregates maintained as batches are appended
+    Array<Transaction> sortedTransactions;
+    TransactionCounters transactionCounters;
+    IncrementalWordTable negativeWords;
+
     // Helper function to convert string to lowercase
     std::string toLowerCase(const std::string& str) {
         std::string result = str;
@@ -38,7 +71,45 @@ private:
         return words;
     }
 
+    // Count the words of 1-star reviews with numThreads workers
+    Array<WordCountEntry> countNegativeWordsParallel(int numThreads, CounterMode mode) {
+        ScopedTimer timer("analysis.countWords");
+        ConcurrentWordCounter counter(mode, numThreads);
+        // Arena-backed reviews are numbered after the owned ones
+        int ownedCount = reviews.getSize();
+        int reviewCount = ownedCount + arenaReviews.getSize();
+        timer.addRows(reviewCount);
+        int chunk = (reviewCount + numThreads - 1) / numThreads;
+
+        std::thread* workers = new std::thread[numThreads];
+        for (int t = 0; t < numThreads; t++) {
+            workers[t] = std::thread([this, &counter, t, chunk, ownedCount, reviewCount]() {
+                int end = std::min(reviewCount, (t + 1) * chunk);
+                for (int i = t * chunk; i < end; i++) {
+                    int rating = i < ownedCount ? reviews[i].rating : arenaReviews[i - ownedCount].rating;
+                    if (rating == 1) {
+                        Array<std::string> words = i < ownedCount
+                            ? splitIntoWords(reviews[i].reviewText)
+                            : splitIntoWords(arenaReviews[i - ownedCount].reviewText.str());
+                        for (int j = 0; j < words.getSize(); j++) {
+                            counter.addWord(t, words[j], wordPosition(i, j));
+                        }
+                    }
+                }
+                counter.finishThread(t);
+            });
+        }
+        for (int t = 0; t < numThreads; t++) {
+            workers[t].join();
+        }
+        delete[] workers;
+
+        return counter.collect();
+    }
+
 public:
+    ArrayDataAnalyzer() : collectPrices(false) {}
+
     // Quick sort implementation
     template<typename T>
     void quickSort(Array<T>& array, int (*compare)(const T&, const T&)) {
@@ -76,6 +147,7 @@ public:
     // Add transaction to the array
     void addTransaction(const Transaction& transaction) {
         transactions.push_back(transaction);
+        if (collectPrices) priceStatistics.add(transaction);
     }
 
     // Add review to the array
@@ -83,6 +155,28 @@ public:
         reviews.push_back(review);
     }
 
+    // Add a transaction whose fields point at caller-owned characters (e.g. the
+    // current CSV line); the bytes are copied into the analyzer's string arena
+    void addTransaction(const TransactionRef& transaction) {
+        arenaTransactions.push_back(TransactionRef(
+            stringArena.store(transaction.customerId),
+            stringArena.store(transaction.product),
+            stringArena.store(transaction.category),
+            transaction.price,
+            stringArena.store(transaction.date),
+            stringArena.store(transaction.paymentMethod)));
+        if (collectPrices) priceStatistics.add(transaction);
+    }
+
+    // Add a review whose fields point at caller-owned characters
+    void addReview(const ReviewRef& review) {
+        arenaReviews.push_back(ReviewRef(
+            stringArena.store(review.productId),
+            stringArena.store(review.customerId),
+            review.rating,
+            stringArena.store(review.reviewText)));
+    }
+
     // Linear search for word frequency counting
     void linearSearch(const Array<std::string>& words, Array<WordFrequency>& frequencies) {
         for (int j = 0; j < words.getSize(); j++) {
@@ -103,17 +197,80 @@ public:
     // Analyze negative reviews (1-star ratings)
     void analyzeNegativeReviews() {
         // Process each review
-        for (int i = 0; i < reviews.getSize(); i++) {
-            if (reviews[i].rating == 1) {
-                Array<std::string> words = splitIntoWords(reviews[i].reviewText);
-                linearSearch(words, wordFrequencies);
+        {
+            ScopedTimer timer("analysis.countWords");
+            int negativeReviews = 0;
+            long long tokens = 0;
+            for (int i = 0; i < reviews.getSize(); i++) {
+                if (reviews[i].rating == 1) {
+                    Array<std::string> words = splitIntoWords(reviews[i].reviewText);
+                    linearSearch(words, wordFrequencies);
+                    negativeReviews++;
+                    tokens += words.getSize();
+                }
+            }
+            for (int i = 0; i < arenaReviews.getSize(); i++) {
+                if (arenaReviews[i].rating == 1) {
+                    Array<std::string> words = splitIntoWords(arenaReviews[i].reviewText.str());
+                    linearSearch(words, wordFrequencies);
+                    negativeReviews++;
+                    tokens += words.getSize();
+                }
             }
+            timer.addRows(reviews.getSize() + arenaReviews.getSize());
+            countMetric("analysis.negativeReviews", negativeReviews);
+            countMetric("analysis.tokens", tokens);
         }
 
         // Sort word frequencies
+        ScopedTimer timer("analysis.sortWords");
         quickSort(wordFrequencies, compareWordFrequency);
     }
 
+    // Multi-threaded analyzeNegativeReviews. Reviews are split into one contiguous
+    // chunk per thread and counted in a ConcurrentWordCounter; the result replaces
+    // the current word table and matches the single-threaded ranking exactly.
+    void analyzeNegativeReviewsParallel(int numThreads, CounterMode mode) {
+        if (numThreads < 1) numThreads = 1;
+
+        // Replay words in first-occurrence order, then rank as usual
+        Array<WordCountEntry> entries = countNegativeWordsParallel(numThreads, mode);
+        wordFrequencies = Array<WordFrequency>();
+        for (int i = 0; i < entries.getSize(); i++) {
+            wordFrequencies.push_back(WordFrequency(entries[i].word, entries[i].frequency));
+        }
+
+        ScopedTimer sortTimer("analysis.sortWords");
+        quickSort(wordFrequencies, compareWordFrequency);
+    }
+
+    // Word ranking for the reviews with any rating (1-5), most frequent first.
+    // Words are counted through a hash table in first-seen order and ranked
+    // with the same quickSort, so rating 1 gives the analyzeNegativeReviews
+    // ranking. The analyzer's own word table is not touched.
+    Array<WordFrequency> rankWordsForRating(int rating) {
+        IncrementalWordTable table;
+        for (int i = 0; i < reviews.getSize(); i++) {
+            if (reviews[i].rating == rating) {
+                Array<std::string> words = splitIntoWords(reviews[i].reviewText);
+                for (int j = 0; j < words.getSize(); j++) {
+                    table.addWord(words[j]);
+                }
+            }
+        }
+        for (int i = 0; i < arenaReviews.getSize(); i++) {
+            if (arenaReviews[i].rating == rating) {
+                Array<std::string> words = splitIntoWords(arenaReviews[i].reviewText.str());
+                for (int j = 0; j < words.getSize(); j++) {
+                    table.addWord(words[j]);
+                }
+            }
+        }
+        Array<WordFrequency> ranked = table.getEntries();
+        quickSort(ranked, compareWordFrequency);
+        return ranked;
+    }
+
     // Get top N frequent words
     Array<WordFrequency> getTopFrequentWords(int n) {
         Array<WordFrequency> result;
@@ -123,9 +280,197 @@ public:
         return result;
     }
 
+    // Incremental mode: store a batch of new transactions, update the counters
+    // and fold the batch into the date order. The batch is sorted on its own
+    // and merged; when it starts no earlier than the current last date (the
+    // usual case for daily appends) it is simply placed after it.
+    void appendTransactions(const Array<Transaction>& batch) {
+        ScopedTimer timer("incremental.transactions");
+        for (int i = 0; i < batch.getSize(); i++) {
+            transactions.push_back(batch[i]);
+            transactionCounters.add(batch[i]);
+            if (collectPrices) priceStatistics.add(batch[i]);
+        }
+        if (batch.getSize() == 0) return;
+
+        Array<Transaction> sortedBatch = batch;
+        quickSort(sortedBatch, compareTransactionsByDate);
+
+        int oldSize = sortedTransactions.getSize();
+        if (oldSize == 0 || compareTransactionsByDate(sortedTransactions[oldSize - 1], sortedBatch[0]) <= 0) {
+            for (int i = 0; i < sortedBatch.getSize(); i++) {
+                sortedTransactions.push_back(sortedBatch[i]);
+            }
+            return;
+        }
+
+        // Ties keep existing rows first
+        Array<Transaction> merged(oldSize + sortedBatch.getSize());
+        int i = 0, j = 0;
+        while (i < oldSize && j < sortedBatch.getSize()) {
+            if (compareTransactionsByDate(sortedTransactions[i], sortedBatch[j]) <= 0) {
+                merged.push_back(sortedTransactions[i++]);
+            } else {
+                merged.push_back(sortedBatch[j++]);
+            }
+        }
+        while (i < oldSize) merged.push_back(sortedTransactions[i++]);
+        while (j < sortedBatch.getSize()) merged.push_back(sortedBatch[j++]);
+        sortedTransactions = merged;
+    }
+
+    // Incremental mode: store a batch of new reviews and count the words of the
+    // 1-star ones into the running table, then re-rank it. Only the new
+    // reviews are tokenized; ranking costs O(distinct words log distinct words).
+    void appendReviews(const Array<Review>& batch) {
+        ScopedTimer timer("incremental.reviews");
+        for (int i = 0; i < batch.getSize(); i++) {
+            reviews.push_back(batch[i]);
+            if (batch[i].rating == 1) {
+                Array<std::string> words = splitIntoWords(batch[i].reviewText);
+                for (int j = 0; j < words.getSize(); j++) {
+                    negativeWords.addWord(words[j]);
+                }
+            }
+        }
+        if (batch.getSize() == 0) return;
+
+        wordFrequencies = negativeWords.getEntries();
+        quickSort(wordFrequencies, compareWordFrequency);
+    }
+
+    // Transactions appended in incremental mode, in date order
+    const Array<Transaction>& getSortedTransactions() const { return sortedTransactions; }
+    const TransactionCounters& getTransactionCounters() const { return transactionCounters; }
+
+    // Build the calendar-date index over a copy of the transactions (the
+    // driver passes its Question 1 sorted copy). Index positions map to rows
+    // of that array through TimeIndex::rowAt.
+    template<typename T>
+    const TimeIndex& buildTimeIndex(const Array<T>& transactions) {
+        ScopedTimer timer("index.time");
+        timeIndex.build(transactions);
+        return timeIndex;
+    }
+
+    const TimeIndex& getTimeIndex() const { return timeIndex; }
+
+    // Build bitmap indexes on category, payment method and product. Rows are
+    // numbered in load order, owned transactions first, then arena-backed ones.
+    const TransactionBitmapIndex& buildFilterIndexes() {
+        ScopedTimer timer("index.bitmap");
+        filterIndex.clear();
+        for (int i = 0; i < transactions.getSize(); i++) {
+            filterIndex.addRow(transactions[i]);
+        }
+        for (int i = 0; i < arenaTransactions.getSize(); i++) {
+            filterIndex.addRow(arenaTransactions[i]);
+        }
+        return filterIndex;
+    }
+
+    const TransactionBitmapIndex& getFilterIndex() const { return filterIndex; }
+
+    // Build the customer index over the arena-backed records if any were
+    // loaded, otherwise over the owned ones (row numbers refer to that pair)
+    const CustomerIndex& buildCustomerIndex() {
+        ScopedTimer timer("index.customer");
+        if (usesArenaRecords()) {
+            customerIndex.build(arenaTransactions, arenaReviews);
+        } else {
+            customerIndex.build(transactions, reviews);
+        }
+        return customerIndex;
+    }
+
+    const CustomerIndex& getCustomerIndex() const { return customerIndex; }
+
+    // Purchases of customers who left a review with this rating (call
+    // buildCustomerIndex first)
+    ReviewerSpend getSpendOfReviewers(int rating) const {
+        if (usesArenaRecords()) {
+            return spendOfReviewers(customerIndex, arenaTransactions, arenaReviews, rating);
+        }
+        return spendOfReviewers(customerIndex, transactions, reviews, rating);
+    }
+
+    // Aggregate ratings per product over the arena-backed reviews if any
+    // were loaded, otherwise over the owned ones
+    const ProductRatingTable& buildProductRatings() {
+        ScopedTimer timer("aggregate.productRatings");
+        if (usesArenaRecords()) {
+            productRatings.build(arenaReviews);
+        } else {
+            productRatings.build(reviews);
+        }
+        timer.addRows(productRatings.getReviewCount());
+        return productRatings;
+    }
+
+    const ProductRatingTable& getProductRatings() const { return productRatings; }
+
+    // Recency, frequency and spend per customer over the arena-backed
+    // transactions if any were loaded, otherwise over the owned ones
+    const RfmTable& buildRfm() {
+        ScopedTimer timer("aggregate.rfm");
+        if (usesArenaRecords()) {
+            rfm.build(arenaTransactions);
+            timer.addRows(arenaTransactions.getSize());
+        } else {
+            rfm.build(transactions);
+            timer.addRows(transactions.getSize());
+        }
+        return rfm;
+    }
+
+    const RfmTable& getRfm() const { return rfm; }
+
+    // Build the inverted index over the review text (arena-backed reviews if
+    // any were loaded, otherwise the owned ones); sourcePath is the file they
+    // came from, recorded for saved copies of the index
+    const ReviewIndex& buildReviewIndex(const std::string& sourcePath) {
+        if (usesArenaRecords()) {
+            reviewIndex.build(arenaReviews, sourcePath);
+        } else {
+            reviewIndex.build(reviews, sourcePath);
+        }
+        return reviewIndex;
+    }
+
+    // Use a saved index instead; false if it does not match sourcePath
+    bool loadReviewIndex(const std::string& path, const std::string& sourcePath, std::string& error) {
+        return reviewIndex.load(path, sourcePath, error);
+    }
+
+    const ReviewIndex& getReviewIndex() const { return reviewIndex; }
+
+    // Sketch the price of every transaction added from now on, per category
+    // and per payment method
+    void enablePriceStatistics() { collectPrices = true; }
+
+    PriceStatistics& getPriceStatistics() { return priceStatistics; }
+
+    // Publish byte accounting for the stored containers as metric counters
+    void reportMemoryUsage() const {
+        reportContainerMemory("transactions", containerMemory(transactions));
+        reportContainerMemory("reviews", containerMemory(reviews));
+        reportContainerMemory("wordFrequencies", containerMemory(wordFrequencies));
+        if (stringArena.getBlockCount() > 0) {
+            reportContainerMemory("arenaTransactions", containerMemory(arenaTransactions));
+            reportContainerMemory("arenaReviews", containerMemory(arenaReviews));
+            reportArenaMemory("stringArena", stringArena);
+        }
+    }
+
+    bool usesArenaRecords() const {
+        return arenaTransactions.getSize() > 0 || arenaReviews.getSize() > 0;
+    }
+
     // Getters for the arrays
     const Array<Transaction>& getTransactions() const { return transactions; }
     const Array<Review>& getReviews() const { return reviews; }
+    const Array<TransactionRef>& getArenaTransactions() const { return arenaTransactions; }
+    const Array<ReviewRef>& getArenaReviews() const { return arenaReviews; }
 };
 
 #endif
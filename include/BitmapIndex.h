@@ -0,0 +1,311 @@
+#ifndef BITMAP_INDEX_H
+#define BITMAP_INDEX_H
+
+#include <string>
+#include <cstdint>
+#include "Array.h"
+#include "HashMap.h"
+#include "DataStructures.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Popcount of (a AND b) over n 64-bit words. Uses the AVX2 nibble-lookup
+// popcount when compiled with -mavx2, otherwise the scalar builtin (which
+// becomes the POPCNT instruction with -mpopcnt).
+inline long long andPopcount(const uint64_t* a, const uint64_t* b, int n) {
+    long long total = 0;
+    int i = 0;
+#ifdef __AVX2__
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowMask = _mm256_set1_epi8(0x0f);
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                     _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        __m256i low = _mm256_and_si256(v, lowMask);
+        __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+        __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+    }
+    total += _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+             _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+#endif
+    for (; i < n; i++) {
+        total += __builtin_popcountll(a[i] & b[i]);
+    }
+    return total;
+}
+
+// Compressed bitmap in the style of Roaring: values are split by their high
+// 16 bits into containers, each either a sorted array of low halves (sparse)
+// or a 65536-bit bitmap (dense, more than 4096 values).
+class RoaringBitmap {
+private:
+    static const int ARRAY_LIMIT = 4096;
+    static const int BITMAP_WORDS = 1024;
+
+    struct Container {
+        int key;
+        int cardinality;
+        Array<unsigned short> values;  // Used while sparse
+        Array<uint64_t> words;         // Used once dense
+
+        Container(int k = 0) : key(k), cardinality(0), values(4), words(1) {}
+
+        bool isBitmap() const { return words.getSize() > 0; }
+
+        bool contains(unsigned short low) const {
+            if (isBitmap()) {
+                return (words.getData()[low >> 6] >> (low & 63)) & 1;
+            }
+            int lo = 0, hi = values.getSize();
+            const unsigned short* data = values.getData();
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (data[mid] < low) lo = mid + 1; else hi = mid;
+            }
+            return lo < values.getSize() && data[lo] == low;
+        }
+
+        void toBitmap() {
+            words = Array<uint64_t>(BITMAP_WORDS);
+            for (int i = 0; i < BITMAP_WORDS; i++) {
+                words.push_back(0);
+            }
+            for (int i = 0; i < values.getSize(); i++) {
+                words[values[i] >> 6] |= 1ULL << (values[i] & 63);
+            }
+            values = Array<unsigned short>(1);
+        }
+    };
+
+    Array<Container> containers;
+
+    // Count of low halves present in both containers
+    static int intersectionSize(const Container& a, const Container& b) {
+        if (a.isBitmap() && b.isBitmap()) {
+            return static_cast<int>(andPopcount(a.words.getData(), b.words.getData(), BITMAP_WORDS));
+        }
+        if (a.isBitmap() || b.isBitmap()) {
+            const Container& sparse = a.isBitmap() ? b : a;
+            const Container& dense = a.isBitmap() ? a : b;
+            int count = 0;
+            for (int i = 0; i < sparse.values.getSize(); i++) {
+                count += dense.contains(sparse.values.getData()[i]);
+            }
+            return count;
+        }
+        const unsigned short* x = a.values.getData();
+        const unsigned short* y = b.values.getData();
+        int i = 0, j = 0, count = 0;
+        while (i < a.values.getSize() && j < b.values.getSize()) {
+            if (x[i] < y[j]) i++;
+            else if (x[i] > y[j]) j++;
+            else { count++; i++; j++; }
+        }
+        return count;
+    }
+
+    static Container intersectContainers(const Container& a, const Container& b) {
+        Container result(a.key);
+        if (a.isBitmap() && b.isBitmap()) {
+            result.toBitmap();
+            const uint64_t* x = a.words.getData();
+            const uint64_t* y = b.words.getData();
+            uint64_t* out = result.words.getData();
+            for (int i = 0; i < BITMAP_WORDS; i++) {
+                out[i] = x[i] & y[i];
+                result.cardinality += __builtin_popcountll(out[i]);
+            }
+            return result;
+        }
+        const Container& sparse = a.isBitmap() ? b : a;
+        const Container& other = a.isBitmap() ? a : b;
+        for (int i = 0; i < sparse.values.getSize(); i++) {
+            unsigned short low = sparse.values.getData()[i];
+            if (other.contains(low)) {
+                result.values.push_back(low);
+                result.cardinality++;
+            }
+        }
+        return result;
+    }
+
+public:
+    // Values must be added in increasing order (row numbers during a load)
+    void add(unsigned int value) {
+        int key = static_cast<int>(value >> 16);
+        unsigned short low = static_cast<unsigned short>(value & 0xFFFF);
+        if (containers.getSize() == 0 || containers[containers.getSize() - 1].key != key) {
+            containers.push_back(Container(key));
+        }
+        Container& container = containers[containers.getSize() - 1];
+        if (container.isBitmap()) {
+            uint64_t bit = 1ULL << (low & 63);
+            if (!(container.words[low >> 6] & bit)) {
+                container.words[low >> 6] |= bit;
+                container.cardinality++;
+            }
+            return;
+        }
+        int n = container.values.getSize();
+        if (n > 0 && container.values[n - 1] == low) return;
+        container.values.push_back(low);
+        container.cardinality++;
+        if (container.cardinality > ARRAY_LIMIT) {
+            container.toBitmap();
+        }
+    }
+
+    bool contains(unsigned int value) const {
+        int key = static_cast<int>(value >> 16);
+        for (int i = 0; i < containers.getSize(); i++) {
+            if (containers[i].key == key) {
+                return containers[i].contains(static_cast<unsigned short>(value & 0xFFFF));
+            }
+        }
+        return false;
+    }
+
+    long long cardinality() const {
+        long long total = 0;
+        for (int i = 0; i < containers.getSize(); i++) {
+            total += containers[i].cardinality;
+        }
+        return total;
+    }
+
+    // |a AND b| without materializing the intersection
+    static long long andCardinality(const RoaringBitmap& a, const RoaringBitmap& b) {
+        long long total = 0;
+        int i = 0, j = 0;
+        while (i < a.containers.getSize() && j < b.containers.getSize()) {
+            int ka = a.containers[i].key, kb = b.containers[j].key;
+            if (ka < kb) i++;
+            else if (ka > kb) j++;
+            else total += intersectionSize(a.containers[i++], b.containers[j++]);
+        }
+        return total;
+    }
+
+    static RoaringBitmap intersect(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap result;
+        int i = 0, j = 0;
+        while (i < a.containers.getSize() && j < b.containers.getSize()) {
+            int ka = a.containers[i].key, kb = b.containers[j].key;
+            if (ka < kb) i++;
+            else if (ka > kb) j++;
+            else {
+                Container c = intersectContainers(a.containers[i++], b.containers[j++]);
+                if (c.cardinality > 0) result.containers.push_back(c);
+            }
+        }
+        return result;
+    }
+};
+
+// Columns of Transaction covered by TransactionBitmapIndex
+enum class TransactionColumn {
+    Category = 0,
+    PaymentMethod = 1,
+    Product = 2
+};
+
+// One RoaringBitmap of row numbers per distinct category, payment method and
+// product. Conjunctive filters become bitmap ANDs plus popcounts.
+class TransactionBitmapIndex {
+private:
+    static const int COLUMN_COUNT = 3;
+    HashMap<std::string, int> valueIds[COLUMN_COUNT];
+    Array<RoaringBitmap> bitmaps;
+    int rowCount;
+
+    static const std::string& columnValue(const Transaction& t, TransactionColumn column) {
+        switch (column) {
+            case TransactionColumn::Category: return t.category;
+            case TransactionColumn::PaymentMethod: return t.paymentMethod;
+            default: return t.product;
+        }
+    }
+
+    static std::string columnValue(const TransactionRef& t, TransactionColumn column) {
+        switch (column) {
+            case TransactionColumn::Category: return t.category.str();
+            case TransactionColumn::PaymentMethod: return t.paymentMethod.str();
+            default: return t.product.str();
+        }
+    }
+
+public:
+    TransactionBitmapIndex() : rowCount(0) {}
+
+    void clear() {
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            valueIds[c].clear();
+        }
+        bitmaps = Array<RoaringBitmap>();
+        rowCount = 0;
+    }
+
+    // Index the next row (rows are numbered in the order they are added)
+    template <typename T>
+    void addRow(const T& transaction) {
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            int& id = valueIds[c].getOrInsert(columnValue(transaction, static_cast<TransactionColumn>(c)), -1);
+            if (id < 0) {
+                id = bitmaps.getSize();
+                bitmaps.push_back(RoaringBitmap());
+            }
+            bitmaps[id].add(static_cast<unsigned int>(rowCount));
+        }
+        rowCount++;
+    }
+
+    // Bitmap of rows where column == value, nullptr if the value never occurs
+    const RoaringBitmap* find(TransactionColumn column, const std::string& value) const {
+        const int* id = valueIds[static_cast<int>(column)].find(value);
+        return id ? &bitmaps[*id] : nullptr;
+    }
+
+    long long count(TransactionColumn column, const std::string& value) const {
+        const RoaringBitmap* bitmap = find(column, value);
+        return bitmap ? bitmap->cardinality() : 0;
+    }
+
+    long long countAnd(TransactionColumn column1, const std::string& value1,
+                       TransactionColumn column2, const std::string& value2) const {
+        const RoaringBitmap* a = find(column1, value1);
+        const RoaringBitmap* b = find(column2, value2);
+        return (a && b) ? RoaringBitmap::andCardinality(*a, *b) : 0;
+    }
+
+    long long countAnd(TransactionColumn column1, const std::string& value1,
+                       TransactionColumn column2, const std::string& value2,
+                       TransactionColumn column3, const std::string& value3) const {
+        const RoaringBitmap* a = find(column1, value1);
+        const RoaringBitmap* b = find(column2, value2);
+        const RoaringBitmap* c = find(column3, value3);
+        if (!a || !b || !c) return 0;
+        return RoaringBitmap::andCardinality(RoaringBitmap::intersect(*a, *b), *c);
+    }
+
+    int getRowCount() const { return rowCount; }
+};
+
+// Parses "category" / "payment" / "product"; returns false for anything else
+inline bool parseTransactionColumn(const std::string& name, TransactionColumn& column) {
+    if (name == "category") {
+        column = TransactionColumn::Category;
+    } else if (name == "payment") {
+        column = TransactionColumn::PaymentMethod;
+    } else if (name == "product") {
+        column = TransactionColumn::Product;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef CONCURRENT_WORD_COUNTER_H
+#define CONCURRENT_WORD_COUNTER_H
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+#include <new>
+#include <cstdint>
+#include "Array.h"
+#include "HashMap.h"
+
+// How worker threads share the word table
+enum class CounterMode {
+    Sharded,      // Hash-sharded global table, one lock per shard
+    ThreadLocal   // Private table per thread, merged without locks at the end
+};
+
+// Count plus the position of the first occurrence (review index, token index).
+// Replaying words in first-occurrence order reproduces the insertion order of
+// the single-threaded linear search, so the final sort gives identical output.
+struct WordCount {
+    int frequency;
+    long long firstSeen;
+
+    WordCount(int f = 0, long long pos = 0) : frequency(f), firstSeen(pos) {}
+};
+
+struct WordCountEntry {
+    std::string word;
+    int frequency;
+    long long firstSeen;
+
+    WordCountEntry(const std::string& w = "", int f = 0, long long pos = 0)
+        : word(w), frequency(f), firstSeen(pos) {}
+};
+
+inline int compareWordCountByFirstSeen(const WordCountEntry& a, const WordCountEntry& b) {
+    if (a.firstSeen < b.firstSeen) return -1;
+    if (a.firstSeen > b.firstSeen) return 1;
+    return 0;
+}
+
+// Builds the position key used for WordCount::firstSeen
+inline long long wordPosition(int reviewIndex, int tokenIndex) {
+    return (static_cast<long long>(reviewIndex) << 20) | tokenIndex;
+}
+
+class ConcurrentWordCounter {
+private:
+    typedef HashMap<std::string, WordCount> WordTable;
+
+    // Padded so neighbouring shard locks do not share a cache line
+    struct Shard {
+        std::mutex lock;
+        WordTable table;
+        char padding[64];
+    };
+
+    // One worker's private table and staged-word count. Slots start on
+    // their own cache line so workers never write to a shared line.
+    struct alignas(64) ThreadSlot {
+        WordTable table;
+        int stagedWords;
+
+        ThreadSlot() : stagedWords(0) {}
+    };
+
+    // Words staged by a sharded-mode thread before taking shard locks
+    static const int FLUSH_THRESHOLD = 4096;
+
+    CounterMode mode;
+    int numThreads;
+    int numShards;
+    Shard* shards;
+    char* slotStorage;      // Raw block; new[] does not honour alignas(64) before C++17
+    ThreadSlot* slots;
+
+    static void mergeInto(WordTable& table, const std::string& word, uint64_t hash, const WordCount& count) {
+        WordCount& target = table.getOrInsert(word, hash, WordCount(0, count.firstSeen));
+        target.frequency += count.frequency;
+        if (count.firstSeen < target.firstSeen) {
+            target.firstSeen = count.firstSeen;
+        }
+    }
+
+    int shardOf(uint64_t hash) const {
+        return static_cast<int>((hash >> 40) % numShards);
+    }
+
+    // Push a sharded-mode thread's staged counts into the shared shards. The
+    // entries are grouped by shard first (a counting sort of their slots), so
+    // each shard is locked once per flush rather than once per word.
+    void flush(int threadId) {
+        WordTable& staged = slots[threadId].table;
+        Array<int> shardStart(numShards + 1);
+        for (int s = 0; s <= numShards; s++) shardStart.push_back(0);
+        int total = 0;
+        for (int i = 0; i < staged.getCapacity(); i++) {
+            if (staged.isOccupied(i)) {
+                shardStart[shardOf(staged.hashAt(i)) + 1]++;
+                total++;
+            }
+        }
+        for (int s = 0; s < numShards; s++) shardStart[s + 1] += shardStart[s];
+
+        Array<int> fill(numShards);
+        for (int s = 0; s < numShards; s++) fill.push_back(shardStart[s]);
+        Array<int> order(total > 0 ? total : 1);
+        for (int i = 0; i < total; i++) order.push_back(0);
+        for (int i = 0; i < staged.getCapacity(); i++) {
+            if (staged.isOccupied(i)) order[fill[shardOf(staged.hashAt(i))]++] = i;
+        }
+
+        for (int s = 0; s < numShards; s++) {
+            if (shardStart[s] == shardStart[s + 1]) continue;
+            std::lock_guard<std::mutex> guard(shards[s].lock);
+            for (int k = shardStart[s]; k < shardStart[s + 1]; k++) {
+                int i = order[k];
+                mergeInto(shards[s].table, staged.keyAt(i), staged.hashAt(i), staged.valueAt(i));
+            }
+        }
+        staged.clear();
+        slots[threadId].stagedWords = 0;
+    }
+
+    static void appendEntries(const WordTable& table, Array<WordCountEntry>& result) {
+        for (int i = 0; i < table.getCapacity(); i++) {
+            if (table.isOccupied(i)) {
+                const WordCount& count = table.valueAt(i);
+                result.push_back(WordCountEntry(table.keyAt(i), count.frequency, count.firstSeen));
+            }
+        }
+    }
+
+public:
+    ConcurrentWordCounter(CounterMode mode, int numThreads, int numShards = 64)
+        : mode(mode), numThreads(numThreads < 1 ? 1 : numThreads), numShards(numShards < 1 ? 1 : numShards) {
+        shards = (mode == CounterMode::Sharded) ? new Shard[this->numShards] : nullptr;
+        slotStorage = new char[this->numThreads * sizeof(ThreadSlot) + alignof(ThreadSlot)];
+        uintptr_t address = reinterpret_cast<uintptr_t>(slotStorage);
+        uintptr_t aligned = (address + alignof(ThreadSlot) - 1) & ~static_cast<uintptr_t>(alignof(ThreadSlot) - 1);
+        slots = reinterpret_cast<ThreadSlot*>(aligned);
+        for (int t = 0; t < this->numThreads; t++) {
+            new (&slots[t]) ThreadSlot();
+        }
+    }
+
+    ~ConcurrentWordCounter() {
+        delete[] shards;
+        for (int t = 0; t < numThreads; t++) {
+            slots[t].~ThreadSlot();
+        }
+        delete[] slotStorage;
+    }
+
+    // Not copyable, the shards own mutexes
+    ConcurrentWordCounter(const ConcurrentWordCounter&) = delete;
+    ConcurrentWordCounter& operator=(const ConcurrentWordCounter&) = delete;
+
+    // Record one occurrence; each thread must only pass its own threadId
+    void addWord(int threadId, const std::string& word, long long position) {
+        ThreadSlot& slot = slots[threadId];
+        mergeInto(slot.table, word, hashKey(word), WordCount(1, position));
+        if (mode == CounterMode::Sharded && ++slot.stagedWords >= FLUSH_THRESHOLD) {
+            flush(threadId);
+        }
+    }
+
+    // Called by each worker once it has no more words to add
+    void finishThread(int threadId) {
+        if (mode == CounterMode::Sharded) {
+            flush(threadId);
+        }
+    }
+
+    // Bottom-up merge sort on firstSeen (positions are unique)
+    static void sortByFirstSeen(Array<WordCountEntry>& entries) {
+        int n = entries.getSize();
+        Array<WordCountEntry> buffer(n > 0 ? n : 1);
+        for (int i = 0; i < n; i++) {
+            buffer.push_back(entries[i]);
+        }
+        for (int width = 1; width < n; width *= 2) {
+            for (int low = 0; low < n; low += 2 * width) {
+                int mid = std::min(low + width, n);
+                int high = std::min(low + 2 * width, n);
+                int i = low, j = mid, k = low;
+                while (i < mid && j < high) {
+                    if (compareWordCountByFirstSeen(entries[i], entries[j]) <= 0) {
+                        buffer[k++] = entries[i++];
+                    } else {
+                        buffer[k++] = entries[j++];
+                    }
+                }
+                while (i < mid) buffer[k++] = entries[i++];
+                while (j < high) buffer[k++] = entries[j++];
+            }
+            for (int i = 0; i < n; i++) {
+                entries[i] = buffer[i];
+            }
+        }
+    }
+
+    // Final counts in first-occurrence order; call after all workers are joined
+    Array<WordCountEntry> collect() {
+        Array<WordCountEntry> result;
+
+        if (mode == CounterMode::Sharded) {
+            for (int s = 0; s < numShards; s++) {
+                appendEntries(shards[s].table, result);
+            }
+            sortByFirstSeen(result);
+            return result;
+        }
+
+        // Thread-local mode: merger m owns the words whose shard is m, so the
+        // partial tables are merged in parallel without any locking
+        WordTable* merged = new WordTable[numThreads];
+        std::thread* mergers = new std::thread[numThreads];
+        for (int m = 0; m < numThreads; m++) {
+            mergers[m] = std::thread([this, merged, m]() {
+                for (int t = 0; t < numThreads; t++) {
+                    const WordTable& local = slots[t].table;
+                    for (int i = 0; i < local.getCapacity(); i++) {
+                        if (local.isOccupied(i) && static_cast<int>((local.hashAt(i) >> 40) % numThreads) == m) {
+                            mergeInto(merged[m], local.keyAt(i), local.hashAt(i), local.valueAt(i));
+                        }
+                    }
+                }
+            });
+        }
+        for (int m = 0; m < numThreads; m++) {
+            mergers[m].join();
+        }
+        for (int m = 0; m < numThreads; m++) {
+            appendEntries(merged[m], result);
+        }
+
+        delete[] mergers;
+        delete[] merged;
+        sortByFirstSeen(result);
+        return result;
+    }
+};
+
+// Parses "sharded" / "thread-local"; returns false for anything else
+inline bool parseCounterMode(const std::string& name, CounterMode& mode) {
+    if (name == "sharded") {
+        mode = CounterMode::Sharded;
+        return true;
+    }
+    if (name == "thread-local") {
+        mode = CounterMode::ThreadLocal;
+        return true;
+    }
+    return false;
+}
+
+#endif
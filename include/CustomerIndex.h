@@ -0,0 +1,185 @@
+#ifndef CUSTOMER_INDEX_H
+#define CUSTOMER_INDEX_H
+
+#include <string>
+#include "Array.h"
+#include "HashMap.h"
+#include "DataStructures.h"
+
+// Customer IDs as hash map keys; arena-backed IDs are copied into a reused buffer
+inline const std::string& customerKey(const std::string& id, std::string&) {
+    return id;
+}
+
+inline const std::string& customerKey(const StringRef& id, std::string& buffer) {
+    buffer.assign(id.data, id.length);
+    return buffer;
+}
+
+// Contiguous run of row numbers inside a posting array
+struct PostingList {
+    const int* rows;
+    int count;
+
+    PostingList() : rows(nullptr), count(0) {}
+    PostingList(const int* r, int c) : rows(r), count(c) {}
+};
+
+// Customer ID -> transaction rows and review rows, stored CSR-style: every
+// customer's rows sit next to each other in one array, so a customer lookup
+// is one hash probe plus two offset reads. Empty IDs are not indexed.
+class CustomerIndex {
+private:
+    HashMap<std::string, int> customerIds;
+    Array<std::string> customers;       // Dense id -> customer ID
+    Array<int> transactionStart;        // Offsets into transactionRows, plus a sentinel
+    Array<int> transactionRows;
+    Array<int> reviewStart;             // Offsets into reviewRows, plus a sentinel
+    Array<int> reviewRows;
+
+    // Dense id of each row's customer (-1 for an empty ID); new customers are added
+    template <typename T>
+    Array<int> assignCustomers(const Array<T>& rows) {
+        Array<int> ids(rows.getSize() > 0 ? rows.getSize() : 1);
+        std::string buffer;
+        for (int i = 0; i < rows.getSize(); i++) {
+            const std::string& key = customerKey(rows[i].customerId, buffer);
+            if (key.empty()) {
+                ids.push_back(-1);
+                continue;
+            }
+            int& id = customerIds.getOrInsert(key, -1);
+            if (id < 0) {
+                id = customers.getSize();
+                customers.push_back(key);
+            }
+            ids.push_back(id);
+        }
+        return ids;
+    }
+
+    // Counting sort of row numbers by customer into start/rows
+    void fillPostings(const Array<int>& rowCustomers, Array<int>& start, Array<int>& rows) const {
+        int customerCount = customers.getSize();
+        start = Array<int>(customerCount + 1);
+        for (int c = 0; c <= customerCount; c++) {
+            start.push_back(0);
+        }
+        for (int i = 0; i < rowCustomers.getSize(); i++) {
+            if (rowCustomers[i] >= 0) start[rowCustomers[i] + 1]++;
+        }
+        for (int c = 0; c < customerCount; c++) {
+            start[c + 1] += start[c];
+        }
+
+        rows = Array<int>(start[customerCount] > 0 ? start[customerCount] : 1);
+        for (int i = 0; i < start[customerCount]; i++) {
+            rows.push_back(0);
+        }
+        Array<int> next = start;
+        for (int i = 0; i < rowCustomers.getSize(); i++) {
+            if (rowCustomers[i] >= 0) rows[next[rowCustomers[i]]++] = i;
+        }
+    }
+
+public:
+    // Index both datasets; row numbers refer to the arrays passed in
+    template <typename TR, typename RV>
+    void build(const Array<TR>& transactions, const Array<RV>& reviews) {
+        customerIds.clear();
+        customers = Array<std::string>();
+        Array<int> transactionCustomers = assignCustomers(transactions);
+        Array<int> reviewCustomers = assignCustomers(reviews);
+        fillPostings(transactionCustomers, transactionStart, transactionRows);
+        fillPostings(reviewCustomers, reviewStart, reviewRows);
+    }
+
+    // Dense customer id, or -1 if the customer never occurs
+    int find(const std::string& customerId) const {
+        const int* id = customerIds.find(customerId);
+        return id ? *id : -1;
+    }
+
+    PostingList transactionsOf(int customer) const {
+        return PostingList(transactionRows.getData() + transactionStart[customer],
+                           transactionStart[customer + 1] - transactionStart[customer]);
+    }
+
+    PostingList reviewsOf(int customer) const {
+        return PostingList(reviewRows.getData() + reviewStart[customer],
+                           reviewStart[customer + 1] - reviewStart[customer]);
+    }
+
+    const std::string& customerAt(int customer) const { return customers[customer]; }
+    int getCustomerCount() const { return customers.getSize(); }
+};
+
+// Purchases of the customers who left at least one review with a given rating
+struct ReviewerSpend {
+    int reviewers;          // Distinct customers with such a review
+    int buyers;             // ... of which made at least one purchase
+    int transactions;       // Purchases made by those customers
+    double totalSpend;
+
+    ReviewerSpend() : reviewers(0), buyers(0), transactions(0), totalSpend(0) {}
+
+    // Average total spend per reviewer who bought something
+    double averagePerBuyer() const { return buyers > 0 ? totalSpend / buyers : 0; }
+    double averagePerTransaction() const { return transactions > 0 ? totalSpend / transactions : 0; }
+};
+
+// One pass over the customers of an index built from these arrays
+template <typename TR, typename RV>
+ReviewerSpend spendOfReviewers(const CustomerIndex& index, const Array<TR>& transactions,
+                               const Array<RV>& reviews, int rating) {
+    ReviewerSpend spend;
+    for (int c = 0; c < index.getCustomerCount(); c++) {
+        PostingList reviewed = index.reviewsOf(c);
+        bool matches = false;
+        for (int i = 0; i < reviewed.count && !matches; i++) {
+            matches = reviews[reviewed.rows[i]].rating == rating;
+        }
+        if (!matches) continue;
+
+        spend.reviewers++;
+        PostingList bought = index.transactionsOf(c);
+        if (bought.count > 0) spend.buyers++;
+        spend.transactions += bought.count;
+        for (int i = 0; i < bought.count; i++) {
+            spend.totalSpend += transactions[bought.rows[i]].price;
+        }
+    }
+    return spend;
+}
+
+// Inner hash join of transactions and reviews on customer ID. The reviews
+// accepted by keepReview form the build side (one chain of rows per
+// customer); each transaction then probes it once, and onMatch(transaction,
+// review) runs for every matching pair. O(T + R + matches).
+template <typename TR, typename RV, typename Filter, typename Callback>
+void hashJoinByCustomer(const Array<TR>& transactions, const Array<RV>& reviews,
+                        Filter keepReview, Callback onMatch) {
+    HashMap<std::string, int> firstReview;  // Customer ID -> head of its review chain
+    Array<int> nextReview(reviews.getSize() > 0 ? reviews.getSize() : 1);
+    std::string buffer;
+
+    for (int i = 0; i < reviews.getSize(); i++) {
+        nextReview.push_back(-1);
+        const std::string& key = customerKey(reviews[i].customerId, buffer);
+        if (key.empty() || !keepReview(reviews[i])) continue;
+        int& head = firstReview.getOrInsert(key, -1);
+        nextReview[i] = head;
+        head = i;
+    }
+
+    for (int i = 0; i < transactions.getSize(); i++) {
+        const std::string& key = customerKey(transactions[i].customerId, buffer);
+        if (key.empty()) continue;
+        const int* head = firstReview.find(key);
+        for (int r = head ? *head : -1; r >= 0; r = nextReview[r]) {
+            onMatch(transactions[i], reviews[r]);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef CUSTOMER_RFM_H
+#define CUSTOMER_RFM_H
+
+#include <string>
+#include <algorithm>
+#include "Array.h"
+#include "HashMap.h"
+#include "DataStructures.h"
+#include "CustomerIndex.h"
+
+// Days since 1970-01-01 of a dateSortKey, for day differences. Dates are
+// DD/MM/YYYY, so the key holds year, day and month in that order; invalid
+// dates give 0.
+inline int dayNumber(int dateKey) {
+    int year = dateKey / 10000;
+    int day = dateKey / 100 % 100;
+    int month = dateKey % 100;
+    if (year < 1970 || month < 1 || month > 12 || day < 1 || day > 31) return 0;
+    // Count years from March so the leap day is the last day of a year
+    year -= month <= 2;
+    int era = year / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// Named groups of customers by their R and F scores
+enum RfmSegment {
+    RFM_CHAMPIONS,      // Bought recently and often
+    RFM_LOYAL,          // Buy often, not in the last while
+    RFM_PROMISING,      // Bought recently, not often yet
+    RFM_AT_RISK,        // Used to buy often, not recently
+    RFM_LOST,           // Neither recent nor frequent
+    RFM_OTHER,
+    RFM_SEGMENT_COUNT
+};
+
+const char* const RFM_SEGMENT_NAMES[RFM_SEGMENT_COUNT] = {
+    "Champions", "Loyal", "Promising", "At risk", "Lost", "Other"
+};
+
+inline RfmSegment rfmSegment(int recency, int frequency) {
+    if (recency >= 4 && frequency >= 4) return RFM_CHAMPIONS;
+    if (recency >= 4) return RFM_PROMISING;
+    if (recency <= 2 && frequency >= 4) return RFM_AT_RISK;
+    if (frequency >= 4) return RFM_LOYAL;
+    if (recency <= 2 && frequency <= 2) return RFM_LOST;
+    return RFM_OTHER;
+}
+
+// Recency, frequency and monetary value per customer from one pass over the
+// transactions in any order: each row is one hash probe to a dense customer
+// id and three updates to parallel arrays, so there is no per-customer scan
+// and no sort of the transactions. Each customer costs a fixed 24 bytes
+// (last day, purchases, spend, three scores) plus its ID in the hash map.
+// Scores are quintiles 1-5 (5 = best: most recent, most purchases, highest
+// spend); customers with equal values get the same score.
+class RfmTable {
+private:
+    HashMap<std::string, int> customerIds;
+    Array<std::string> customers;
+    Array<int> lastDay;             // dayNumber of the latest purchase, 0 if none is dated
+    Array<int> purchases;
+    Array<double> spend;
+    Array<unsigned char> recencyScore;
+    Array<unsigned char> frequencyScore;
+    Array<unsigned char> monetaryScore;
+    int referenceDay;
+
+    // Quintile of each customer's value, ties sharing the lowest rank's score.
+    // Customers are ranked by sorting their ids on the value array.
+    template <typename V>
+    void scoreQuintiles(const Array<V>& values, Array<unsigned char>& scores) const {
+        int n = customers.getSize();
+        Array<int> order(n > 0 ? n : 1);
+        for (int c = 0; c < n; c++) order.push_back(c);
+        std::sort(order.getData(), order.getData() + n, [&values](int a, int b) { return values[a] < values[b]; });
+        scores = Array<unsigned char>(n > 0 ? n : 1);
+        for (int c = 0; c < n; c++) scores.push_back(0);
+        int tieStart = 0;
+        for (int rank = 0; rank < n; rank++) {
+            if (rank > 0 && values[order[rank]] != values[order[rank - 1]]) tieStart = rank;
+            scores[order[rank]] = static_cast<unsigned char>(1 + static_cast<long long>(tieStart) * 5 / n);
+        }
+    }
+
+public:
+    RfmTable() : referenceDay(0) {}
+
+    // Aggregate the transactions (owned or arena-backed). Recency is measured
+    // from referenceDateKey (a dateSortKey), or from the latest purchase in
+    // the data when it is 0. Rows with an unreadable date still count toward
+    // purchases and spend.
+    template <typename T>
+    void build(const Array<T>& transactions, int referenceDateKey = 0) {
+        customerIds.clear();
+        customers = Array<std::string>();
+        lastDay = Array<int>();
+        purchases = Array<int>();
+        spend = Array<double>();
+
+        int latestDay = 0;
+        std::string buffer;
+        for (int i = 0; i < transactions.getSize(); i++) {
+            const T& t = transactions[i];
+            const std::string& key = customerKey(t.customerId, buffer);
+            if (key.empty()) continue;
+            int& id = customerIds.getOrInsert(key, -1);
+            if (id < 0) {
+                id = customers.getSize();
+                customers.push_back(key);
+                lastDay.push_back(0);
+                purchases.push_back(0);
+                spend.push_back(0);
+            }
+            int day = dayNumber(dateSortKey(t.date));
+            if (day > 0) {
+                if (day > lastDay[id]) lastDay[id] = day;
+                if (day > latestDay) latestDay = day;
+            }
+            purchases[id]++;
+            spend[id] += t.price;
+        }
+        referenceDay = referenceDateKey > 0 ? dayNumber(referenceDateKey) : latestDay;
+
+        // More recent is better, and a later last day is a larger value
+        scoreQuintiles(lastDay, recencyScore);
+        scoreQuintiles(purchases, frequencyScore);
+        scoreQuintiles(spend, monetaryScore);
+    }
+
+    int getCustomerCount() const { return customers.getSize(); }
+    const std::string& customerAt(int c) const { return customers[c]; }
+    // Days since the last purchase, or -1 if no purchase has a date
+    int recencyDays(int c) const { return lastDay[c] > 0 ? referenceDay - lastDay[c] : -1; }
+    int purchasesOf(int c) const { return purchases[c]; }
+    double spendOf(int c) const { return spend[c]; }
+    int recencyScoreOf(int c) const { return recencyScore[c]; }
+    int frequencyScoreOf(int c) const { return frequencyScore[c]; }
+    int monetaryScoreOf(int c) const { return monetaryScore[c]; }
+    RfmSegment segmentOf(int c) const { return rfmSegment(recencyScore[c], frequencyScore[c]); }
+
+    // Dense id of a customer, or -1
+    int find(const std::string& customerId) const {
+        const int* id = customerIds.find(customerId);
+        return id ? *id : -1;
+    }
+
+    void countSegments(int counts[RFM_SEGMENT_COUNT]) const {
+        for (int s = 0; s < RFM_SEGMENT_COUNT; s++) counts[s] = 0;
+        for (int c = 0; c < customers.getSize(); c++) counts[segmentOf(c)]++;
+    }
+
+    // The k customers with the highest R+F+M score, ties by higher spend
+    Array<int> topCustomers(int k) const {
+        int n = customers.getSize();
+        Array<int> order(n > 0 ? n : 1);
+        for (int c = 0; c < n; c++) order.push_back(c);
+        if (k > n) k = n;
+        std::partial_sort(order.getData(), order.getData() + k, order.getData() + n, [this](int a, int b) {
+            int scoreA = recencyScore[a] + frequencyScore[a] + monetaryScore[a];
+            int scoreB = recencyScore[b] + frequencyScore[b] + monetaryScore[b];
+            if (scoreA != scoreB) return scoreA > scoreB;
+            if (spend[a] != spend[b]) return spend[a] > spend[b];
+            return customers[a] < customers[b];
+        });
+        Array<int> top(k > 0 ? k : 1);
+        for (int i = 0; i < k; i++) top.push_back(order[i]);
+        return top;
+    }
+};
+
+#endif
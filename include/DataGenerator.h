@@ -0,0 +1,372 @@
+#ifndef DATA_GENERATOR_H
+#define DATA_GENERATOR_H
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <thread>
+#include <chrono>
+#include "Metrics.h"
+
+// Synthetic transactions.csv / reviews.csv in the layout of the bundled raw
+// files, with their value distributions and dirty-row patterns (measured on
+// the 5,000-row samples):
+//   transactions: 17.4% of rows are dirty; a dirty row has an empty customer
+//     ID (73%), NaN price (55%), "Invalid Date" (54%) and/or an empty payment
+//     method (75%). Products, categories and payment methods are uniform,
+//     prices uniform in 10.00-1999.99, dates uniform from 01/01/2022 to
+//     01/01/2024 (DD/MM/YYYY), customers CUST1000-CUST9999.
+//   reviews: 32.6% of rows are dirty; a dirty row has an empty product ID
+//     (75%), empty customer ID (76%), "Invalid Rating" (57%) and/or empty
+//     text (29%). Ratings 1-5 and the 20 review texts are uniform; texts with
+//     a comma are quoted. Products PROD100-PROD999.
+//
+// Rows are produced in fixed-size blocks, each with its own random stream
+// derived from (seed, table, block number), so the output depends only on
+// the seed and row counts, never on the thread count.
+
+const int GENERATOR_BLOCK_ROWS = 8192;
+const int MAX_GENERATED_ROW = 128;      // Longest possible row, with newline
+
+const char* const GENERATED_PRODUCTS[] = {
+    "Mouse", "Keyboard", "Smartwatch", "Laptop", "Smartphone",
+    "Tablet", "Gaming Console", "Monitor", "Camera", "Headphones"
+};
+
+const char* const GENERATED_CATEGORIES[] = {
+    "Groceries", "Automotive", "Furniture", "Fashion", "Home Appliances",
+    "Beauty", "Books", "Electronics", "Sports", "Toys"
+};
+
+const char* const GENERATED_PAYMENT_METHODS[] = {
+    "Bank Transfer", "Debit Card", "Cash on Delivery", "Credit Card", "PayPal"
+};
+
+const char* const GENERATED_REVIEW_TEXTS[] = {
+    "Better than expected, great performance.",
+    "Too expensive for the quality provided.",
+    "Customer service was unhelpful.",
+    "Product does not match the description.",
+    "Sound quality is below average.",
+    "Shipping took too long, not satisfied.",
+    "Amazing value for money!",
+    "Perfect gift for my friend, they loved it!",
+    "Great product, works as expected!",
+    "Arrived damaged, had to request a replacement.",
+    "Battery life is very short, not as advertised.",
+    "Highly recommended for anyone looking for this.",
+    "Would definitely buy again.",
+    "Fantastic build quality, feels premium.",
+    "Not satisfied, poor quality.",
+    "Very easy to use, beginner-friendly.",
+    "The item stopped working after a week.",
+    "Fast delivery and excellent packaging.",
+    "The instructions were unclear, difficult to set up.",
+    "Not what I ordered, very disappointed."
+};
+
+// SplitMix64: one multiply-xorshift step per draw, plenty for synthetic data
+class RowRandom {
+private:
+    uint64_t state;
+
+public:
+    explicit RowRandom(uint64_t seed) : state(seed) {}
+
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t next() {
+        state += 0x9e3779b97f4a7c15ULL;
+        return mix(state);
+    }
+
+    // Uniform in [0, n)
+    uint32_t below(uint32_t n) {
+        return static_cast<uint32_t>(((next() >> 32) * n) >> 32);
+    }
+
+    // True with probability perTenThousand / 10000
+    bool chance(uint32_t perTenThousand) {
+        return below(10000) < perTenThousand;
+    }
+};
+
+// Independent stream for one block of one table
+inline RowRandom blockRandom(uint64_t seed, uint64_t table, uint64_t block) {
+    return RowRandom(RowRandom::mix(seed ^ RowRandom::mix(table * 0x100000001b3ULL + block)));
+}
+
+inline char* appendText(char* out, const char* text) {
+    size_t length = std::strlen(text);
+    std::memcpy(out, text, length);
+    return out + length;
+}
+
+// Fixed-width decimal digits
+inline char* appendDigits(char* out, uint32_t value, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+// Price in cents, written the way the sample files do: "141.5", "763", "443.26"
+inline char* appendPrice(char* out, uint32_t cents) {
+    uint32_t whole = cents / 100;
+    uint32_t fraction = cents % 100;
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + whole % 10);
+        whole /= 10;
+    } while (whole > 0);
+    while (count > 0) *out++ = digits[--count];
+    if (fraction != 0) {
+        *out++ = '.';
+        *out++ = static_cast<char>('0' + fraction / 10);
+        if (fraction % 10 != 0) *out++ = static_cast<char>('0' + fraction % 10);
+    }
+    return out;
+}
+
+// Days 0..730 from 01/01/2022, as DD/MM/YYYY
+class GeneratedDates {
+private:
+    char dates[731][10];
+
+public:
+    GeneratedDates() {
+        static const int monthDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        int year = 2022, month = 0, day = 1;
+        for (int i = 0; i < 731; i++) {
+            char* out = dates[i];
+            out = appendDigits(out, day, 2);
+            *out++ = '/';
+            out = appendDigits(out, month + 1, 2);
+            *out++ = '/';
+            appendDigits(out, year, 4);
+            int length = monthDays[month] + (month == 1 && year % 4 == 0 ? 1 : 0);
+            if (++day > length) {
+                day = 1;
+                if (++month == 12) {
+                    month = 0;
+                    year++;
+                }
+            }
+        }
+    }
+
+    int getCount() const { return 731; }
+    const char* at(int i) const { return dates[i]; }
+};
+
+// Decide which fields of a dirty row are broken; at least one always is
+inline unsigned dirtyFields(RowRandom& random, const uint32_t* fieldOdds, int fields) {
+    unsigned mask = 0;
+    for (int f = 0; f < fields; f++) {
+        if (random.chance(fieldOdds[f])) mask |= 1u << f;
+    }
+    return mask != 0 ? mask : 1u << random.below(fields);
+}
+
+inline char* writeTransactionRow(char* out, RowRandom& random, const GeneratedDates& dates) {
+    static const uint32_t fieldOdds[4] = {7350, 5470, 5450, 7530};  // Customer, price, date, payment
+    unsigned dirty = random.chance(1744) ? dirtyFields(random, fieldOdds, 4) : 0;
+
+    if (!(dirty & 1)) {
+        out = appendText(out, "CUST");
+        out = appendDigits(out, 1000 + random.below(9000), 4);
+    }
+    *out++ = ',';
+    out = appendText(out, GENERATED_PRODUCTS[random.below(10)]);
+    *out++ = ',';
+    out = appendText(out, GENERATED_CATEGORIES[random.below(10)]);
+    *out++ = ',';
+    out = dirty & 2 ? appendText(out, "NaN") : appendPrice(out, 1000 + random.below(199000));
+    *out++ = ',';
+    if (dirty & 4) {
+        out = appendText(out, "Invalid Date");
+    } else {
+        std::memcpy(out, dates.at(random.below(dates.getCount())), 10);
+        out += 10;
+    }
+    *out++ = ',';
+    if (!(dirty & 8)) out = appendText(out, GENERATED_PAYMENT_METHODS[random.below(5)]);
+    *out++ = '\n';
+    return out;
+}
+
+inline char* writeReviewRow(char* out, RowRandom& random, const GeneratedDates&) {
+    static const uint32_t fieldOdds[4] = {7450, 7640, 5720, 2890};  // Product, customer, rating, text
+    unsigned dirty = random.chance(3256) ? dirtyFields(random, fieldOdds, 4) : 0;
+
+    if (!(dirty & 1)) {
+        out = appendText(out, "PROD");
+        out = appendDigits(out, 100 + random.below(900), 3);
+    }
+    *out++ = ',';
+    if (!(dirty & 2)) {
+        out = appendText(out, "CUST");
+        out = appendDigits(out, 1000 + random.below(9000), 4);
+    }
+    *out++ = ',';
+    if (dirty & 4) {
+        out = appendText(out, "Invalid Rating");
+    } else {
+        *out++ = static_cast<char>('1' + random.below(5));
+    }
+    *out++ = ',';
+    if (!(dirty & 8)) {
+        const char* text = GENERATED_REVIEW_TEXTS[random.below(20)];
+        bool quoted = std::strchr(text, ',') != nullptr;
+        if (quoted) *out++ = '"';
+        out = appendText(out, text);
+        if (quoted) *out++ = '"';
+    }
+    *out++ = '\n';
+    return out;
+}
+
+// Parse a row count such as 250000, 500K, 10M or 1G
+inline long long parseRowCount(const char* text) {
+    char* end = nullptr;
+    double value = std::strtod(text, &end);
+    if (end == text || value < 0) return -1;
+    switch (*end) {
+        case 'k': case 'K': return static_cast<long long>(value * 1000);
+        case 'm': case 'M': return static_cast<long long>(value * 1000000);
+        case 'g': case 'G': return static_cast<long long>(value * 1000000000);
+        case '\0': return static_cast<long long>(value);
+        default: return -1;
+    }
+}
+
+// Formats one row (with its newline) at out and returns the new end
+typedef char* (*GeneratedRowWriter)(char* out, RowRandom& random, const GeneratedDates& dates);
+
+struct GeneratorOptions {
+    long long transactionRows;
+    long long reviewRows;
+    uint64_t seed;
+    int threads;
+
+    GeneratorOptions() : transactionRows(100000), reviewRows(100000), seed(42), threads(1) {}
+};
+
+struct GeneratedTable {
+    long long rows;
+    long long bytes;
+    double seconds;
+
+    GeneratedTable() : rows(0), bytes(0), seconds(0) {}
+};
+
+// Writes one table. Blocks are generated a batch at a time by the worker
+// threads into one of two buffer sets while the calling thread writes the
+// previous batch out in order, so formatting and I/O overlap.
+class TableGenerator {
+private:
+    const GeneratorOptions& options;
+    const GeneratedDates& dates;
+
+    void fillBlocks(char** buffers, long long* lengths, long long firstBlock, int blockCount,
+                    long long rows, uint64_t table, GeneratedRowWriter writeRow) const {
+        int threads = options.threads;
+        std::thread* workers = new std::thread[threads];
+        for (int t = 0; t < threads; t++) {
+            workers[t] = std::thread([=]() {
+                for (int b = t; b < blockCount; b += threads) {
+                    long long block = firstBlock + b;
+                    long long begin = block * GENERATOR_BLOCK_ROWS;
+                    long long end = begin + GENERATOR_BLOCK_ROWS < rows ? begin + GENERATOR_BLOCK_ROWS : rows;
+                    RowRandom random = blockRandom(options.seed, table, block);
+                    char* out = buffers[b];
+                    for (long long r = begin; r < end; r++) {
+                        out = writeRow(out, random, dates);
+                    }
+                    lengths[b] = out - buffers[b];
+                }
+            });
+        }
+        for (int t = 0; t < threads; t++) {
+            workers[t].join();
+        }
+        delete[] workers;
+    }
+
+public:
+    TableGenerator(const GeneratorOptions& opts, const GeneratedDates& d) : options(opts), dates(d) {}
+
+    bool generate(const std::string& path, const char* header, long long rows, uint64_t table,
+                  GeneratedRowWriter writeRow, GeneratedTable& stats, std::string& error) const {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            error = "could not open " + path + " for writing: " + std::strerror(errno);
+            return false;
+        }
+        bool ok = std::fputs(header, file) >= 0 && std::fputc('\n', file) != EOF;
+        stats.bytes = std::strlen(header) + 1;
+
+        int batch = options.threads * 2;
+        long long blocks = (rows + GENERATOR_BLOCK_ROWS - 1) / GENERATOR_BLOCK_ROWS;
+        char** buffers[2];
+        long long* lengths[2];
+        for (int set = 0; set < 2; set++) {
+            buffers[set] = new char*[batch];
+            lengths[set] = new long long[batch];
+            for (int b = 0; b < batch; b++) {
+                buffers[set][b] = new char[static_cast<size_t>(GENERATOR_BLOCK_ROWS) * MAX_GENERATED_ROW];
+            }
+        }
+
+        int pendingSet = -1, pendingCount = 0;
+        for (long long first = 0, round = 0; first < blocks && ok; first += batch, round++) {
+            int set = static_cast<int>(round % 2);
+            int count = static_cast<int>(blocks - first < batch ? blocks - first : batch);
+            std::thread filler([&, set, first, count]() {
+                fillBlocks(buffers[set], lengths[set], first, count, rows, table, writeRow);
+            });
+            // Write the previous batch while this one is being generated
+            for (int b = 0; b < pendingCount && ok; b++) {
+                ok = std::fwrite(buffers[pendingSet][b], 1, lengths[pendingSet][b], file) ==
+                     static_cast<size_t>(lengths[pendingSet][b]);
+                stats.bytes += lengths[pendingSet][b];
+            }
+            filler.join();
+            pendingSet = set;
+            pendingCount = count;
+        }
+        for (int b = 0; b < pendingCount && ok; b++) {
+            ok = std::fwrite(buffers[pendingSet][b], 1, lengths[pendingSet][b], file) ==
+                 static_cast<size_t>(lengths[pendingSet][b]);
+            stats.bytes += lengths[pendingSet][b];
+        }
+
+        for (int set = 0; set < 2; set++) {
+            for (int b = 0; b < batch; b++) {
+                delete[] buffers[set][b];
+            }
+            delete[] buffers[set];
+            delete[] lengths[set];
+        }
+        if (std::fclose(file) != 0) ok = false;
+        if (!ok) {
+            error = "could not write " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        stats.rows = rows;
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+};
+
+#endif
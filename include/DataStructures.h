@@ -2,6 +2,8 @@
 #define DATA_STRUCTURES_H
 
 #include <string>
+#include <cstring>
+#include "StringArena.h"
 
 struct Review {
     std::string productId;
@@ -36,6 +38,78 @@ inline int compareTransactionsByDate(const Transaction& a, const Transaction& b)
     return aDate.compare(bDate);
 }
 
+// Integer form of the compareTransactionsByDate ordering:
+// YYYY * 10000 + characters 0-1 * 100 + characters 3-4
+inline int dateSortKey(const char* date, int length) {
+    if (length < 10) return 0;
+    int year = (date[6] - '0') * 1000 + (date[7] - '0') * 100 + (date[8] - '0') * 10 + (date[9] - '0');
+    int first = (date[0] - '0') * 10 + (date[1] - '0');
+    int second = (date[3] - '0') * 10 + (date[4] - '0');
+    return year * 10000 + first * 100 + second;
+}
+
+inline int dateSortKey(const std::string& date) {
+    return dateSortKey(date.data(), static_cast<int>(date.size()));
+}
+
+inline int dateSortKey(const StringRef& date) {
+    return dateSortKey(date.data, date.length);
+}
+
+// Calendar order of a DD/MM/YYYY date: year * 10000 + month * 100 + day.
+// dateSortKey keeps the Question 1 display order, which puts a year's days
+// before its months; date ranges and date comparisons use this key instead.
+inline int calendarDateKey(const char* date, int length) {
+    int key = dateSortKey(date, length);
+    return key / 10000 * 10000 + key % 100 * 100 + key / 100 % 100;
+}
+
+inline int calendarDateKey(const std::string& date) {
+    return calendarDateKey(date.data(), static_cast<int>(date.size()));
+}
+
+inline int calendarDateKey(const StringRef& date) {
+    return calendarDateKey(date.data, date.length);
+}
+
+// Arena-backed variants of Review and Transaction: the string fields point into
+// a StringArena owned by the analyzer instead of owning heap buffers
+struct ReviewRef {
+    StringRef productId;
+    StringRef customerId;
+    int rating;
+    StringRef reviewText;
+
+    ReviewRef() : rating(0) {}
+    ReviewRef(const StringRef& pid, const StringRef& cid, int r, const StringRef& text)
+        : productId(pid), customerId(cid), rating(r), reviewText(text) {}
+};
+
+struct TransactionRef {
+    StringRef customerId;
+    StringRef product;
+    StringRef category;
+    double price;
+    StringRef date;
+    StringRef paymentMethod;
+
+    TransactionRef() : price(0) {}
+    TransactionRef(const StringRef& cid, const StringRef& prod, const StringRef& cat,
+                   double p, const StringRef& d, const StringRef& pm)
+        : customerId(cid), product(prod), category(cat), price(p), date(d), paymentMethod(pm) {}
+};
+
+// Same ordering as compareTransactionsByDate, without building temporary strings
+inline int compareTransactionsByDate(const TransactionRef& a, const TransactionRef& b) {
+    char aDate[8] = {0}, bDate[8] = {0};
+    const int from[8] = {6, 7, 8, 9, 0, 1, 3, 4};
+    for (int i = 0; i < 8; i++) {
+        if (from[i] < a.date.length) aDate[i] = a.date.data[from[i]];
+        if (from[i] < b.date.length) bDate[i] = b.date.data[from[i]];
+    }
+    return std::memcmp(aDate, bDate, 8);
+}
+
 // Word frequency counter for review analysis
 struct WordFrequency {
     std::string word;
@@ -0,0 +1,377 @@
+#ifndef DEDUPLICATOR_H
+#define DEDUPLICATOR_H
+
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <sys/stat.h>
+#include "FastHash.h"
+
+// Open addressing set of 64-bit hashes with linear probing. A slot holding 0
+// is empty, so a hash of 0 is stored as 1.
+class HashSet64 {
+private:
+    uint64_t* slots;
+    size_t capacity;    // Power of two
+    size_t size;
+
+    static uint64_t stored(uint64_t hash) { return hash == 0 ? 1 : hash; }
+
+    size_t find(uint64_t hash) const {
+        size_t mask = capacity - 1;
+        size_t slot = static_cast<size_t>(hash) & mask;
+        while (slots[slot] != 0 && slots[slot] != hash) slot = (slot + 1) & mask;
+        return slot;
+    }
+
+public:
+    HashSet64(size_t initialCapacity = 1 << 16) : capacity(initialCapacity), size(0) {
+        slots = new uint64_t[capacity]();
+    }
+
+    ~HashSet64() {
+        delete[] slots;
+    }
+
+    // False if the hash was already present
+    bool insert(uint64_t hash) {
+        hash = stored(hash);
+        size_t slot = find(hash);
+        if (slots[slot] == hash) return false;
+        slots[slot] = hash;
+        size++;
+        return true;
+    }
+
+    bool contains(uint64_t hash) const {
+        hash = stored(hash);
+        return slots[find(hash)] == hash;
+    }
+
+    // At the 3/4 load factor where probing starts to degrade
+    bool isFull() const { return size * 4 >= capacity * 3; }
+
+    void grow() {
+        uint64_t* old = slots;
+        size_t oldCapacity = capacity;
+        capacity *= 2;
+        slots = new uint64_t[capacity]();
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (old[i] != 0) slots[find(old[i])] = old[i];
+        }
+        delete[] old;
+    }
+
+    void clear() {
+        std::memset(slots, 0, capacity * sizeof(uint64_t));
+        size = 0;
+    }
+
+    size_t getSize() const { return size; }
+    size_t memoryBytes() const { return capacity * sizeof(uint64_t); }
+
+    HashSet64(const HashSet64&) = delete;
+    HashSet64& operator=(const HashSet64&) = delete;
+};
+
+const int DEDUP_MAX_COLUMNS = 32;
+const int DEDUP_MAX_PARTITIONS = 256;
+
+// Which part of a row identifies it: the whole line, or a list of columns
+// in the order given
+struct DedupKey {
+    bool wholeLine;
+    int columns[DEDUP_MAX_COLUMNS];
+    int columnCount;
+
+    DedupKey() : wholeLine(true), columnCount(0) {}
+};
+
+// Parse "line" or a comma-separated list of header column names
+inline bool parseDedupKey(const std::string& spec, const std::string& header, DedupKey& key, std::string& error) {
+    key = DedupKey();
+    if (spec == "line") return true;
+    key.wholeLine = false;
+
+    std::string names[DEDUP_MAX_COLUMNS];
+    int nameCount = 0;
+    size_t start = 0;
+    while (start <= header.size() && nameCount < DEDUP_MAX_COLUMNS) {
+        size_t end = header.find(',', start);
+        if (end == std::string::npos) end = header.size();
+        names[nameCount++] = header.substr(start, end - start);
+        start = end + 1;
+    }
+    // A header saved with CRLF line endings
+    if (nameCount > 0 && !names[nameCount - 1].empty() && names[nameCount - 1].back() == '\r') {
+        names[nameCount - 1].pop_back();
+    }
+
+    start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string name = spec.substr(start, end - start);
+        int column = -1;
+        for (int c = 0; c < nameCount; c++) {
+            if (names[c] == name) column = c;
+        }
+        if (column < 0) {
+            error = "no column \"" + name + "\" (columns are " + header + ")";
+            return false;
+        }
+        if (key.columnCount == DEDUP_MAX_COLUMNS) {
+            error = "too many key columns";
+            return false;
+        }
+        key.columns[key.columnCount++] = column;
+        start = end + 1;
+    }
+    return true;
+}
+
+// Streaming duplicate filter for one CSV file. Each row is reduced to a
+// 64-bit hash of its key and checked against a set of the hashes seen so far,
+// so the first occurrence is written and later ones are dropped. Two
+// different keys with the same hash also count as duplicates; at a billion
+// rows that happens with a probability of a few percent.
+//
+// The set grows up to the memory budget. If the input has more distinct keys
+// than fit, the filter spills: hashes already in the set keep being dropped
+// straight away, and the remaining rows go to a temporary file while their
+// (hash, row number) pairs are appended to partition files by hash. finish()
+// then deduplicates each partition on its own and appends the surviving
+// spilled rows to the output in their original order.
+class Deduplicator {
+private:
+    struct SpillRecord {
+        uint64_t hash;
+        long long row;
+    };
+
+    DedupKey key;
+    size_t memoryBudget;
+    std::string spillPrefix;
+    long long inputBytes;
+    HashSet64 seen;
+    std::string keyBuffer;
+    bool enabled;
+
+    long long rowsSeen;
+    long long bytesSeen;
+    long long duplicates;
+
+    bool spilling;
+    int partitionCount;
+    std::ofstream* partitionFiles;
+    std::ofstream spillRows;
+    long long spilledRows;
+
+    uint64_t hashRow(const char* line, int length) {
+        if (key.wholeLine) return fastHash64(line, length);
+
+        // Field bounds up to the last key column, splitting on commas outside quotes
+        const char* begin[DEDUP_MAX_COLUMNS];
+        const char* end[DEDUP_MAX_COLUMNS];
+        int fields = 0;
+        const char* p = line;
+        const char* lineEnd = line + length;
+        while (fields < DEDUP_MAX_COLUMNS) {
+            begin[fields] = p;
+            bool inQuotes = false;
+            while (p < lineEnd && (inQuotes || *p != ',')) {
+                if (*p == '"') inQuotes = !inQuotes;
+                p++;
+            }
+            end[fields++] = p;
+            if (p == lineEnd) break;
+            p++;
+        }
+
+        keyBuffer.clear();
+        for (int k = 0; k < key.columnCount; k++) {
+            int c = key.columns[k];
+            if (c < fields) {
+                // Compare field values without surrounding blanks or quotes
+                const char* b = begin[c];
+                const char* e = end[c];
+                while (b < e && (*b == ' ' || *b == '\t')) b++;
+                while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r')) e--;
+                if (e - b >= 2 && *b == '"' && e[-1] == '"') {
+                    b++;
+                    e--;
+                }
+                keyBuffer.append(b, e - b);
+            }
+            keyBuffer.push_back('\x1f');
+        }
+        return fastHash64(keyBuffer.data(), keyBuffer.size());
+    }
+
+    // High hash bits pick the partition; the set indexes with the low ones
+    int partitionOf(uint64_t hash) const {
+        return static_cast<int>((hash >> 40) % static_cast<uint64_t>(partitionCount));
+    }
+
+    std::string partitionPath(int p, const char* kind) const {
+        return spillPrefix + "." + kind + "-" + std::to_string(p) + ".tmp";
+    }
+
+    bool startSpill(std::string& error) {
+        // Enough partitions that each one's distinct keys fit the set, going
+        // by the average row length so far and the input still unread
+        long long averageRow = bytesSeen / (rowsSeen > 0 ? rowsSeen : 1) + 1;
+        long long remainingRows = inputBytes > bytesSeen ? (inputBytes - bytesSeen) / averageRow + 1 : rowsSeen;
+        long long perPartition = static_cast<long long>(seen.memoryBytes() / sizeof(uint64_t) / 2);
+        long long partitions = remainingRows / perPartition + 1;
+        partitionCount = static_cast<int>(partitions < DEDUP_MAX_PARTITIONS ? partitions : DEDUP_MAX_PARTITIONS);
+
+        partitionFiles = new std::ofstream[partitionCount];
+        for (int p = 0; p < partitionCount; p++) {
+            partitionFiles[p].open(partitionPath(p, "hashes").c_str(), std::ios::binary | std::ios::trunc);
+            if (!partitionFiles[p]) {
+                error = "could not create " + partitionPath(p, "hashes");
+                return false;
+            }
+        }
+        spillRows.open((spillPrefix + ".rows.tmp").c_str(), std::ios::binary | std::ios::trunc);
+        if (!spillRows) {
+            error = "could not create " + spillPrefix + ".rows.tmp";
+            return false;
+        }
+        spilling = true;
+        return true;
+    }
+
+    void removeSpillFiles() {
+        for (int p = 0; p < partitionCount; p++) {
+            std::remove(partitionPath(p, "hashes").c_str());
+            std::remove(partitionPath(p, "dropped").c_str());
+        }
+        std::remove((spillPrefix + ".rows.tmp").c_str());
+    }
+
+public:
+    // memoryBytes bounds the hash set; spill files are named after spillPrefix
+    Deduplicator(size_t memoryBytes, const std::string& prefix, const std::string& inputPath)
+        : memoryBudget(memoryBytes), spillPrefix(prefix), inputBytes(-1), seen(1 << 12), enabled(false),
+          rowsSeen(0), bytesSeen(0), duplicates(0),
+          spilling(false), partitionCount(0), partitionFiles(nullptr), spilledRows(0) {
+        struct stat info;
+        if (stat(inputPath.c_str(), &info) == 0) inputBytes = info.st_size;
+    }
+
+    ~Deduplicator() {
+        delete[] partitionFiles;
+        if (spilling) removeSpillFiles();
+    }
+
+    // Turn the filter on with a key spec ("line" or column names) resolved
+    // against the file's header line
+    bool configure(const std::string& spec, const std::string& header, std::string& error) {
+        if (!parseDedupKey(spec, header, key, error)) return false;
+        enabled = true;
+        return true;
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    // Write the row to out unless it repeats an earlier one. While spilling,
+    // rows not known to be duplicates are held back until finish().
+    bool accept(const char* line, int length, std::ostream& out, std::string& error) {
+        rowsSeen++;
+        bytesSeen += length + 1;
+        uint64_t hash = hashRow(line, length);
+        if (seen.contains(hash)) {
+            duplicates++;
+            return true;
+        }
+        if (!spilling && seen.isFull()) {
+            if (seen.memoryBytes() * 2 <= memoryBudget) {
+                seen.grow();
+            } else if (!startSpill(error)) {
+                return false;
+            }
+        }
+        if (!spilling) {
+            seen.insert(hash);
+            out.write(line, length);
+            out.put('\n');
+            return true;
+        }
+
+        SpillRecord record = {hash, spilledRows++};
+        partitionFiles[partitionOf(hash)].write(reinterpret_cast<const char*>(&record), sizeof(record));
+        spillRows.write(line, length);
+        spillRows.put('\n');
+        return true;
+    }
+
+    // Resolve the spilled rows and append the survivors to out
+    bool finish(std::ostream& out, std::string& error) {
+        if (!spilling) return true;
+        for (int p = 0; p < partitionCount; p++) partitionFiles[p].close();
+        spillRows.close();
+
+        // Each key lands in one partition, so partitions are deduplicated
+        // separately. Records are in row order, so the first occurrence is
+        // kept and the dropped row numbers come out sorted.
+        const int BATCH = 4096;
+        SpillRecord* batch = new SpillRecord[BATCH];
+        for (int p = 0; p < partitionCount; p++) {
+            seen.clear();
+            std::ifstream hashes(partitionPath(p, "hashes").c_str(), std::ios::binary);
+            std::ofstream dropped(partitionPath(p, "dropped").c_str(), std::ios::binary | std::ios::trunc);
+            while (hashes) {
+                hashes.read(reinterpret_cast<char*>(batch), sizeof(SpillRecord) * BATCH);
+                long long count = hashes.gcount() / static_cast<long long>(sizeof(SpillRecord));
+                for (long long i = 0; i < count; i++) {
+                    // Past the budget only if the partition estimate was too low
+                    if (seen.isFull()) seen.grow();
+                    if (!seen.insert(batch[i].hash)) {
+                        duplicates++;
+                        dropped.write(reinterpret_cast<const char*>(&batch[i].row), sizeof(long long));
+                    }
+                }
+            }
+            if (!dropped) {
+                error = "could not write " + partitionPath(p, "dropped");
+                delete[] batch;
+                return false;
+            }
+        }
+        delete[] batch;
+
+        // Replay the held-back rows, skipping each partition's dropped rows
+        std::ifstream* droppedFiles = new std::ifstream[partitionCount];
+        long long* nextDropped = new long long[partitionCount];
+        for (int p = 0; p < partitionCount; p++) {
+            droppedFiles[p].open(partitionPath(p, "dropped").c_str(), std::ios::binary);
+            if (!droppedFiles[p].read(reinterpret_cast<char*>(&nextDropped[p]), sizeof(long long))) nextDropped[p] = -1;
+        }
+        std::ifstream rows((spillPrefix + ".rows.tmp").c_str(), std::ios::binary);
+        std::string line;
+        for (long long row = 0; std::getline(rows, line); row++) {
+            int p = partitionOf(hashRow(line.data(), static_cast<int>(line.size())));
+            if (nextDropped[p] == row) {
+                if (!droppedFiles[p].read(reinterpret_cast<char*>(&nextDropped[p]), sizeof(long long))) nextDropped[p] = -1;
+                continue;
+            }
+            out << line << '\n';
+        }
+        delete[] droppedFiles;
+        delete[] nextDropped;
+        return true;
+    }
+
+    long long getDuplicates() const { return duplicates; }
+    long long getSpilledRows() const { return spilledRows; }
+    int getPartitionCount() const { return partitionCount; }
+
+    Deduplicator(const Deduplicator&) = delete;
+    Deduplicator& operator=(const Deduplicator&) = delete;
+};
+
+#endif
@@ -0,0 +1,599 @@
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <unistd.h>
+#include "Array.h"
+#include "DataStructures.h"
+#include "Metrics.h"
+#include "RowSchema.h"
+
+// Sorts a transactions CSV by date in bounded memory:
+//   1. rows are encoded into a run buffer until the memory budget is used,
+//      the run is sorted by (date key, input row) and spilled to a temp file;
+//   2. runs are merged k at a time through a loser tree with large buffered
+//      reads, in as many passes as the budget's fan-in requires;
+//   3. the final merge streams to CSV (the input rows, with quotes only on
+//      fields that need them) or to the binary record format below.
+//
+// Rows are split with the quote-aware scanner of the in-memory ingest
+// (nextCsvField), so fields are stored without their quotes.
+//
+// Binary record (native byte order), used for runs and binary output:
+//   int32 date key (dateSortKey), uint64 input row number,
+//   6 x (uint16 length, bytes): customer ID, product, category, price text,
+//   date, payment method
+
+const int SORT_FIELD_COUNT = 6;
+const int MAX_SORT_FIELD_LENGTH = 4095;
+const int MAX_SORT_RECORD_BYTES = 4 + 8 + SORT_FIELD_COUNT * (2 + MAX_SORT_FIELD_LENGTH);
+const int MIN_SORT_BUFFER_BYTES = 64 * 1024;
+const char BINARY_SORT_MAGIC[8] = {'T', 'X', 'N', 'S', 'O', 'R', 'T', '1'};
+
+// One decoded record; fields point into a reader's or run's buffer
+struct SortRecord {
+    int key;
+    uint64_t row;
+    StringRef fields[SORT_FIELD_COUNT];
+
+    SortRecord() : key(0), row(0) {}
+
+    Transaction toTransaction() const {
+        return Transaction(fields[0].str(), fields[1].str(), fields[2].str(),
+                           fields[3].toDouble(), fields[4].str(), fields[5].str());
+    }
+};
+
+// Order of the external sort: date key, then input position (so it is stable)
+inline bool sortRecordLess(int keyA, uint64_t rowA, int keyB, uint64_t rowB) {
+    return keyA != keyB ? keyA < keyB : rowA < rowB;
+}
+
+// Encode into dest, which has room for MAX_SORT_RECORD_BYTES; returns the size
+inline int encodeSortRecord(int key, uint64_t row, const StringRef* fields, char* dest) {
+    std::memcpy(dest, &key, 4);
+    std::memcpy(dest + 4, &row, 8);
+    int pos = 4 + 8;
+    for (int f = 0; f < SORT_FIELD_COUNT; f++) {
+        uint16_t length = static_cast<uint16_t>(fields[f].length);
+        std::memcpy(dest + pos, &length, 2);
+        std::memcpy(dest + pos + 2, fields[f].data, length);
+        pos += 2 + length;
+    }
+    return pos;
+}
+
+// Decode the record at data (at most available bytes); returns its size, or 0
+// if the record is not complete within the available bytes
+inline int decodeSortRecord(const char* data, int available, SortRecord& record) {
+    int pos = 4 + 8;
+    if (available < pos) return 0;
+    std::memcpy(&record.key, data, 4);
+    std::memcpy(&record.row, data + 4, 8);
+    for (int f = 0; f < SORT_FIELD_COUNT; f++) {
+        if (available < pos + 2) return 0;
+        uint16_t length;
+        std::memcpy(&length, data + pos, 2);
+        pos += 2;
+        if (available < pos + length) return 0;
+        record.fields[f] = StringRef(data + pos, length);
+        pos += length;
+    }
+    return pos;
+}
+
+// Write-behind buffer over a FILE*; bytes reach the file in bufferSize blocks
+class BufferedWriter {
+private:
+    std::FILE* file;
+    char* buffer;
+    int capacity;
+    int used;
+    long long written;
+    bool failed;
+
+public:
+    BufferedWriter(std::FILE* f, int bufferSize)
+        : file(f), buffer(new char[bufferSize]), capacity(bufferSize), used(0), written(0), failed(false) {}
+
+    ~BufferedWriter() {
+        flush();
+        delete[] buffer;
+    }
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    void write(const char* data, int length) {
+        while (length > 0) {
+            if (used == capacity) flush();
+            int chunk = length < capacity - used ? length : capacity - used;
+            std::memcpy(buffer + used, data, chunk);
+            used += chunk;
+            data += chunk;
+            length -= chunk;
+        }
+    }
+
+    void put(char c) {
+        if (used == capacity) flush();
+        buffer[used++] = c;
+    }
+
+    void flush() {
+        if (used > 0 && std::fwrite(buffer, 1, used, file) != static_cast<size_t>(used)) {
+            failed = true;
+        }
+        written += used;
+        used = 0;
+    }
+
+    long long getBytesWritten() const { return written + used; }
+    bool hasFailed() const { return failed; }
+};
+
+// Read-ahead buffer over a FILE* of binary records. The buffer must hold at
+// least one whole record; a record split by a refill is moved to the front.
+class SortRunReader {
+private:
+    std::FILE* file;
+    char* buffer;
+    int capacity;
+    int begin;
+    int end;
+    bool atEof;
+
+    void refill() {
+        if (begin > 0) {
+            std::memmove(buffer, buffer + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        size_t got = std::fread(buffer + end, 1, capacity - end, file);
+        end += static_cast<int>(got);
+        if (got == 0) atEof = true;
+    }
+
+public:
+    SortRunReader(std::FILE* f, int bufferSize)
+        : file(f), buffer(new char[bufferSize]), capacity(bufferSize), begin(0), end(0), atEof(false) {}
+
+    ~SortRunReader() {
+        delete[] buffer;
+    }
+
+    SortRunReader(const SortRunReader&) = delete;
+    SortRunReader& operator=(const SortRunReader&) = delete;
+
+    // Decode the next record; it stays valid until the following call
+    bool next(SortRecord& record) {
+        while (true) {
+            int size = decodeSortRecord(buffer + begin, end - begin, record);
+            if (size > 0) {
+                begin += size;
+                return true;
+            }
+            if (atEof) return false;
+            refill();
+        }
+    }
+};
+
+// Tournament tree of losers over k sorted sources. Each internal node keeps
+// the source that lost the match played there and the overall winner sits on
+// top, so replacing the winner replays only its leaf-to-root path:
+// log2(k) comparisons per record.
+class LoserTree {
+private:
+    int k;
+    Array<int> losers;          // losers[0] is the winner
+    Array<int> keys;            // Current head of each source
+    Array<uint64_t> rows;
+    Array<char> exhausted;
+
+    bool beats(int a, int b) const {
+        if (exhausted[a]) return false;
+        if (exhausted[b]) return true;
+        return sortRecordLess(keys[a], rows[a], keys[b], rows[b]);
+    }
+
+    // Play source up from its leaf; returns the winner of the path
+    int replay(int source) {
+        int winner = source;
+        for (int node = (source + k) / 2; node > 0; node /= 2) {
+            if (losers[node] >= 0 && beats(losers[node], winner)) {
+                int loser = winner;
+                winner = losers[node];
+                losers[node] = loser;
+            }
+        }
+        return winner;
+    }
+
+public:
+    explicit LoserTree(int sourceCount) : k(sourceCount) {
+        for (int i = 0; i < k; i++) {
+            losers.push_back(-1);
+            keys.push_back(0);
+            rows.push_back(0);
+            exhausted.push_back(1);
+        }
+    }
+
+    // Set every source's first record (or mark it empty), then build the tree
+    void setHead(int source, bool hasRecord, int key, uint64_t row) {
+        keys[source] = key;
+        rows[source] = row;
+        exhausted[source] = hasRecord ? 0 : 1;
+    }
+
+    void build() {
+        for (int i = 0; i < k; i++) losers[i] = -1;
+        // Insert sources one by one; an empty slot takes the climbing source
+        for (int source = 0; source < k; source++) {
+            int winner = source;
+            int node = (source + k) / 2;
+            for (; node > 0; node /= 2) {
+                if (losers[node] < 0) {
+                    losers[node] = winner;
+                    winner = -1;
+                    break;
+                }
+                if (beats(losers[node], winner)) {
+                    int loser = winner;
+                    winner = losers[node];
+                    losers[node] = loser;
+                }
+            }
+            if (winner >= 0) losers[0] = winner;
+        }
+    }
+
+    // Source holding the smallest head; -1 once every source is exhausted
+    int winner() const {
+        int w = losers[0];
+        return (w >= 0 && !exhausted[w]) ? w : -1;
+    }
+
+    // Replace the winner's head with its next record (or mark it exhausted)
+    void advance(bool hasRecord, int key, uint64_t row) {
+        int source = losers[0];
+        keys[source] = key;
+        rows[source] = row;
+        exhausted[source] = hasRecord ? 0 : 1;
+        losers[0] = replay(source);
+    }
+};
+
+enum class SortOutputFormat {
+    Csv,
+    Binary
+};
+
+struct ExternalSortOptions {
+    long long memoryBudget;     // Bytes for the run buffer and for merge buffers (256 KiB to 1 GiB)
+    std::string tempDir;
+    SortOutputFormat format;
+
+    ExternalSortOptions() : memoryBudget(64LL << 20), tempDir("."), format(SortOutputFormat::Csv) {}
+};
+
+struct ExternalSortStats {
+    long long rows;
+    long long rejectedRows;     // Wrong field count or oversized field
+    int runs;
+    int mergePasses;
+    long long bytesSpilled;
+
+    ExternalSortStats() : rows(0), rejectedRows(0), runs(0), mergePasses(0), bytesSpilled(0) {}
+};
+
+class ExternalSorter {
+private:
+    struct RunEntry {
+        int key;
+        int offset;             // Into the run buffer
+        uint64_t row;
+    };
+
+    ExternalSortOptions options;
+    ExternalSortStats stats;
+    std::string error;
+    std::string header;
+    Array<std::string> runPaths;
+    int nextRunId;
+
+    std::string tempPath() {
+        char name[64];
+        std::snprintf(name, sizeof(name), "/extsort-%d-%d.run", static_cast<int>(getpid()), nextRunId++);
+        return options.tempDir + name;
+    }
+
+    // Stable bottom-up merge sort of a run's entries by (key, row)
+    static void sortEntries(RunEntry* entries, RunEntry* scratch, int n) {
+        RunEntry* from = entries;
+        RunEntry* to = scratch;
+        for (int width = 1; width < n; width *= 2) {
+            for (int lo = 0; lo < n; lo += 2 * width) {
+                int mid = lo + width < n ? lo + width : n;
+                int hi = lo + 2 * width < n ? lo + 2 * width : n;
+                int i = lo, j = mid, out = lo;
+                while (i < mid && j < hi) {
+                    to[out++] = sortRecordLess(from[j].key, from[j].row, from[i].key, from[i].row) ? from[j++] : from[i++];
+                }
+                while (i < mid) to[out++] = from[i++];
+                while (j < hi) to[out++] = from[j++];
+            }
+            RunEntry* swap = from;
+            from = to;
+            to = swap;
+        }
+        if (from != entries) std::memcpy(entries, from, sizeof(RunEntry) * n);
+    }
+
+    // Sort the buffered records and write them out as one run file
+    bool spillRun(const char* buffer, RunEntry* entries, RunEntry* scratch, int count) {
+        if (count == 0) return true;
+        ScopedTimer timer("extsort.spill");
+        sortEntries(entries, scratch, count);
+
+        std::string path = tempPath();
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            error = "could not create run file " + path;
+            return false;
+        }
+        runPaths.push_back(path);
+        bool ok;
+        {
+            BufferedWriter writer(file, MIN_SORT_BUFFER_BYTES * 16);
+            for (int i = 0; i < count; i++) {
+                SortRecord record;
+                const char* data = buffer + entries[i].offset;
+                writer.write(data, decodeSortRecord(data, MAX_SORT_RECORD_BYTES, record));
+            }
+            writer.flush();
+            stats.bytesSpilled += writer.getBytesWritten();
+            ok = !writer.hasFailed();
+        }
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) error = "could not write run file " + path;
+        stats.runs++;
+        return ok;
+    }
+
+    // Phase 1: read the CSV and spill sorted runs. Three quarters of the
+    // budget hold encoded records, the rest their sort entries.
+    bool generateRuns(const std::string& inputPath) {
+        ScopedTimer timer("extsort.runs");
+        const int readBufferSize = 1 << 20;
+        char* readBuffer = new char[readBufferSize];
+        std::ifstream input;
+        input.rdbuf()->pubsetbuf(readBuffer, readBufferSize);
+        input.open(inputPath.c_str());
+
+        bool ok = true;
+        if (!input) {
+            error = "could not open " + inputPath;
+            ok = false;
+        } else if (!std::getline(input, header)) {
+            error = inputPath + " is empty";
+            ok = false;
+        }
+
+        int bufferCapacity = static_cast<int>(options.memoryBudget / 4 * 3);
+        int entryCapacity = static_cast<int>(options.memoryBudget / 4 / (2 * sizeof(RunEntry)));
+        char* buffer = new char[bufferCapacity];
+        RunEntry* entries = new RunEntry[entryCapacity];
+        RunEntry* scratch = new RunEntry[entryCapacity];
+        int used = 0;
+        int count = 0;
+
+        std::string line;
+        uint64_t row = 0;
+        while (ok && std::getline(input, line)) {
+            StringRef fields[SORT_FIELD_COUNT];
+            int fieldCount = 0;
+            char* cursor = &line[0];
+            char* end = cursor + line.size();
+            const char* data;
+            int length;
+            bool valid = true;
+            while (nextCsvField(cursor, end, data, length)) {
+                if (fieldCount == SORT_FIELD_COUNT || length > MAX_SORT_FIELD_LENGTH) {
+                    valid = false;
+                    break;
+                }
+                fields[fieldCount++] = StringRef(data, length);
+            }
+            // cursor stays set when a quote is left open
+            if (!valid || cursor != nullptr || fieldCount != SORT_FIELD_COUNT) {
+                stats.rejectedRows++;
+                continue;
+            }
+
+            if (used + MAX_SORT_RECORD_BYTES > bufferCapacity || count == entryCapacity) {
+                ok = spillRun(buffer, entries, scratch, count);
+                used = 0;
+                count = 0;
+            }
+            RunEntry& entry = entries[count++];
+            entry.key = dateSortKey(fields[4]);
+            entry.row = row++;
+            entry.offset = used;
+            used += encodeSortRecord(entry.key, entry.row, fields, buffer + used);
+            stats.rows++;
+        }
+        ok = ok && spillRun(buffer, entries, scratch, count);
+
+        delete[] buffer;
+        delete[] entries;
+        delete[] scratch;
+        input.close();
+        delete[] readBuffer;
+        return ok;
+    }
+
+    // A field holding a comma or quote is quoted again, inner quotes doubled
+    void writeCsvField(BufferedWriter& writer, const StringRef& field) {
+        bool needsQuotes = std::memchr(field.data, ',', field.length) || std::memchr(field.data, '"', field.length);
+        if (!needsQuotes) {
+            writer.write(field.data, field.length);
+            return;
+        }
+        writer.put('"');
+        for (int i = 0; i < field.length; i++) {
+            if (field.data[i] == '"') writer.put('"');
+            writer.put(field.data[i]);
+        }
+        writer.put('"');
+    }
+
+    void writeCsv(BufferedWriter& writer, const SortRecord& record) {
+        for (int f = 0; f < SORT_FIELD_COUNT; f++) {
+            if (f > 0) writer.put(',');
+            writeCsvField(writer, record.fields[f]);
+        }
+        writer.put('\n');
+    }
+
+    // Merge runs [first, first + count) into out through a loser tree
+    bool mergeRuns(int first, int count, std::FILE* out, bool finalPass) {
+        int readerBuffer = static_cast<int>(options.memoryBudget / (count + 1));
+        if (readerBuffer < MIN_SORT_BUFFER_BYTES) readerBuffer = MIN_SORT_BUFFER_BYTES;
+
+        Array<std::FILE*> files;
+        Array<SortRunReader*> readers;
+        LoserTree tree(count);
+        bool ok = true;
+        for (int i = 0; i < count; i++) {
+            std::FILE* file = std::fopen(runPaths[first + i].c_str(), "rb");
+            if (!file) {
+                error = "could not reopen run file " + runPaths[first + i];
+                ok = false;
+            }
+            files.push_back(file);
+            readers.push_back(file ? new SortRunReader(file, readerBuffer) : nullptr);
+        }
+
+        if (ok) {
+            Array<SortRecord> heads(count);
+            for (int i = 0; i < count; i++) {
+                SortRecord record;
+                bool has = readers[i]->next(record);
+                heads.push_back(record);
+                tree.setHead(i, has, record.key, record.row);
+            }
+            tree.build();
+
+            BufferedWriter writer(out, readerBuffer);
+            if (finalPass && options.format == SortOutputFormat::Csv) {
+                writer.write(header.data(), static_cast<int>(header.size()));
+                writer.put('\n');
+            } else if (finalPass) {
+                writer.write(BINARY_SORT_MAGIC, sizeof(BINARY_SORT_MAGIC));
+            }
+
+            char* encoded = new char[MAX_SORT_RECORD_BYTES];
+            for (int source = tree.winner(); source >= 0; source = tree.winner()) {
+                const SortRecord& record = heads[source];
+                if (finalPass && options.format == SortOutputFormat::Csv) {
+                    writeCsv(writer, record);
+                } else {
+                    writer.write(encoded, encodeSortRecord(record.key, record.row, record.fields, encoded));
+                }
+                bool has = readers[source]->next(heads[source]);
+                tree.advance(has, heads[source].key, heads[source].row);
+            }
+            delete[] encoded;
+            writer.flush();
+            if (!finalPass) stats.bytesSpilled += writer.getBytesWritten();
+            if (writer.hasFailed()) {
+                error = "write failed during merge";
+                ok = false;
+            }
+        }
+
+        for (int i = 0; i < count; i++) {
+            delete readers[i];
+            if (files[i]) std::fclose(files[i]);
+            std::remove(runPaths[first + i].c_str());
+        }
+        return ok;
+    }
+
+    // Phase 2: merge passes until at most fanIn runs remain, then the final merge
+    bool mergeAll(std::FILE* out) {
+        ScopedTimer timer("extsort.merge");
+        int fanIn = static_cast<int>(options.memoryBudget / MIN_SORT_BUFFER_BYTES) - 1;
+        if (fanIn < 2) fanIn = 2;
+
+        int first = 0;
+        while (runPaths.getSize() - first > fanIn) {
+            int end = runPaths.getSize();
+            for (int group = first; group < end; group += fanIn) {
+                int count = end - group < fanIn ? end - group : fanIn;
+                std::string path = tempPath();
+                std::FILE* file = std::fopen(path.c_str(), "wb");
+                if (!file) {
+                    error = "could not create run file " + path;
+                    return false;
+                }
+                bool ok = mergeRuns(group, count, file, false);
+                ok = std::fclose(file) == 0 && ok;
+                runPaths.push_back(path);
+                if (!ok) return false;
+            }
+            first = end;
+            stats.mergePasses++;
+        }
+
+        stats.mergePasses++;
+        return mergeRuns(first, runPaths.getSize() - first, out, true);
+    }
+
+public:
+    explicit ExternalSorter(const ExternalSortOptions& opts) : options(opts), nextRunId(0) {
+        // Buffers are indexed with int, so the budget is capped at 1 GiB
+        if (options.memoryBudget < 4 * MIN_SORT_BUFFER_BYTES) {
+            options.memoryBudget = 4 * MIN_SORT_BUFFER_BYTES;
+        }
+        if (options.memoryBudget > (1LL << 30)) {
+            options.memoryBudget = 1LL << 30;
+        }
+    }
+
+    // Sort inputPath into out; on failure getError() says why and the temp
+    // files are removed
+    bool sort(const std::string& inputPath, std::FILE* out) {
+        bool ok = generateRuns(inputPath);
+        if (ok && runPaths.getSize() == 0) {
+            // Header only: nothing to merge, still emit a valid empty output
+            std::string path = tempPath();
+            std::FILE* empty = std::fopen(path.c_str(), "wb");
+            if (empty) {
+                std::fclose(empty);
+                runPaths.push_back(path);
+            }
+        }
+        ok = ok && mergeAll(out);
+        for (int i = 0; i < runPaths.getSize(); i++) {
+            std::remove(runPaths[i].c_str());
+        }
+        countMetric("extsort.rows", stats.rows);
+        countMetric("extsort.rejectedRows", stats.rejectedRows);
+        countMetric("extsort.runs", stats.runs);
+        countMetric("extsort.mergePasses", stats.mergePasses);
+        countMetric("extsort.bytesSpilled", stats.bytesSpilled);
+        return ok;
+    }
+
+    const ExternalSortStats& getStats() const { return stats; }
+    const std::string& getError() const { return error; }
+};
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef HASH_MAP_H
+#define HASH_MAP_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// FNV-1a hash for short keys such as words, IDs and category names
+inline uint64_t hashBytes(const char* data, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline uint64_t hashKey(const std::string& key) {
+    return hashBytes(key.data(), key.size());
+}
+
+inline uint64_t hashKey(int key) {
+    uint64_t x = static_cast<uint64_t>(static_cast<unsigned int>(key));
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Open addressing hash map with linear probing.
+// Slots can be walked with getCapacity()/isOccupied()/keyAt()/valueAt().
+template <typename K, typename V>
+class HashMap {
+private:
+    K* keys;
+    V* values;
+    uint64_t* hashes;
+    bool* occupied;
+    int capacity;
+    int size;
+
+    void allocate(int newCapacity) {
+        capacity = newCapacity;
+        keys = new K[capacity];
+        values = new V[capacity];
+        hashes = new uint64_t[capacity];
+        occupied = new bool[capacity];
+        for (int i = 0; i < capacity; i++) {
+            occupied[i] = false;
+        }
+    }
+
+    void release() {
+        delete[] keys;
+        delete[] values;
+        delete[] hashes;
+        delete[] occupied;
+    }
+
+    int findSlot(const K& key, uint64_t hash) const {
+        int mask = capacity - 1;
+        int slot = static_cast<int>(hash & mask);
+        while (occupied[slot]) {
+            if (hashes[slot] == hash && keys[slot] == key) {
+                return slot;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void rehash(int newCapacity) {
+        K* oldKeys = keys;
+        V* oldValues = values;
+        uint64_t* oldHashes = hashes;
+        bool* oldOccupied = occupied;
+        int oldCapacity = capacity;
+
+        allocate(newCapacity);
+        for (int i = 0; i < oldCapacity; i++) {
+            if (oldOccupied[i]) {
+                int slot = findSlot(oldKeys[i], oldHashes[i]);
+                keys[slot] = oldKeys[i];
+                values[slot] = oldValues[i];
+                hashes[slot] = oldHashes[i];
+                occupied[slot] = true;
+            }
+        }
+
+        delete[] oldKeys;
+        delete[] oldValues;
+        delete[] oldHashes;
+        delete[] oldOccupied;
+    }
+
+public:
+    // Capacity is rounded up to a power of two
+    HashMap(int initialCapacity = 16) : size(0) {
+        int cap = 16;
+        while (cap < initialCapacity) cap *= 2;
+        allocate(cap);
+    }
+
+    // Copy constructor
+    HashMap(const HashMap& other) : size(other.size) {
+        allocate(other.capacity);
+        for (int i = 0; i < capacity; i++) {
+            if (other.occupied[i]) {
+                keys[i] = other.keys[i];
+                values[i] = other.values[i];
+                hashes[i] = other.hashes[i];
+                occupied[i] = true;
+            }
+        }
+    }
+
+    ~HashMap() {
+        release();
+    }
+
+    // Copy assignment operator
+    HashMap& operator=(const HashMap& other) {
+        if (this != &other) {
+            release();
+            size = other.size;
+            allocate(other.capacity);
+            for (int i = 0; i < capacity; i++) {
+                if (other.occupied[i]) {
+                    keys[i] = other.keys[i];
+                    values[i] = other.values[i];
+                    hashes[i] = other.hashes[i];
+                    occupied[i] = true;
+                }
+            }
+        }
+        return *this;
+    }
+
+    // Returns nullptr when the key is absent
+    V* find(const K& key, uint64_t hash) {
+        int slot = findSlot(key, hash);
+        return occupied[slot] ? &values[slot] : nullptr;
+    }
+
+    V* find(const K& key) {
+        return find(key, hashKey(key));
+    }
+
+    const V* find(const K& key) const {
+        uint64_t hash = hashKey(key);
+        int slot = findSlot(key, hash);
+        return occupied[slot] ? &values[slot] : nullptr;
+    }
+
+    // Inserts defaultValue when the key is absent, returns the stored value
+    V& getOrInsert(const K& key, uint64_t hash, const V& defaultValue) {
+        // Keep the load factor below 0.7
+        if ((size + 1) * 10 > capacity * 7) {
+            rehash(capacity * 2);
+        }
+        int slot = findSlot(key, hash);
+        if (!occupied[slot]) {
+            keys[slot] = key;
+            values[slot] = defaultValue;
+            hashes[slot] = hash;
+            occupied[slot] = true;
+            size++;
+        }
+        return values[slot];
+    }
+
+    V& getOrInsert(const K& key, const V& defaultValue = V()) {
+        return getOrInsert(key, hashKey(key), defaultValue);
+    }
+
+    void clear() {
+        for (int i = 0; i < capacity; i++) {
+            occupied[i] = false;
+        }
+        size = 0;
+    }
+
+    int getSize() const { return size; }
+    int getCapacity() const { return capacity; }
+    bool isOccupied(int slot) const { return occupied[slot]; }
+    const K& keyAt(int slot) const { return keys[slot]; }
+    uint64_t hashAt(int slot) const { return hashes[slot]; }
+    V& valueAt(int slot) { return values[slot]; }
+    const V& valueAt(int slot) const { return values[slot]; }
+};
+
+#endif
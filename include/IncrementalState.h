@@ -0,0 +1,123 @@
+#ifndef INCREMENTAL_STATE_H
+#define INCREMENTAL_STATE_H
+
+#include <string>
+#include <fstream>
+#include "Array.h"
+#include "HashMap.h"
+#include "DataStructures.h"
+
+// Reads a CSV file that only ever grows. The byte offset after the last
+// complete line is remembered, so each call hands out just the rows appended
+// since the previous one. A trailing line without its newline is still being
+// written and is left for the next call.
+class AppendReader {
+private:
+    std::string path;
+    long long offset;
+
+public:
+    AppendReader(const std::string& path = "") : path(path), offset(0) {}
+
+    // Calls onLine(line) for every new complete row (the header is skipped)
+    // and returns how many rows were delivered, or -1 if the file can't be
+    // opened. The callback may modify the line.
+    template <typename Callback>
+    int readNewLines(Callback onLine) {
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (!file) return -1;
+        file.seekg(offset);
+
+        int rows = 0;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (file.eof()) break;  // No newline yet: partial row
+            bool isHeader = offset == 0;
+            offset += static_cast<long long>(line.size()) + 1;
+            if (!isHeader) {
+                onLine(line);
+                rows++;
+            }
+        }
+        return rows;
+    }
+
+    long long getOffset() const { return offset; }
+    const std::string& getPath() const { return path; }
+};
+
+// Running per-category, per-payment-method and per-pair transaction counts
+class TransactionCounters {
+private:
+    HashMap<std::string, int> categories;
+    HashMap<std::string, int> paymentMethods;
+    HashMap<std::string, int> categoryPayments;  // Key: category '\x1f' payment method
+    int total;
+
+    static std::string pairKey(const std::string& category, const std::string& paymentMethod) {
+        return category + '\x1f' + paymentMethod;
+    }
+
+    static int lookup(const HashMap<std::string, int>& counts, const std::string& key) {
+        const int* count = counts.find(key);
+        return count ? *count : 0;
+    }
+
+public:
+    TransactionCounters() : total(0) {}
+
+    void add(const Transaction& t) {
+        add(t.category, t.paymentMethod, 1);
+    }
+
+    // Count several purchases of one category/payment pair at once
+    void add(const std::string& category, const std::string& paymentMethod, int count) {
+        categories.getOrInsert(category, 0) += count;
+        paymentMethods.getOrInsert(paymentMethod, 0) += count;
+        categoryPayments.getOrInsert(pairKey(category, paymentMethod), 0) += count;
+        total += count;
+    }
+
+    // Call visit(category, paymentMethod, count) for every pair seen
+    template <typename F>
+    void forEachPair(F visit) const {
+        for (int slot = 0; slot < categoryPayments.getCapacity(); slot++) {
+            if (!categoryPayments.isOccupied(slot)) continue;
+            const std::string& key = categoryPayments.keyAt(slot);
+            size_t separator = key.find('\x1f');
+            visit(key.substr(0, separator), key.substr(separator + 1), categoryPayments.valueAt(slot));
+        }
+    }
+
+    int category(const std::string& name) const { return lookup(categories, name); }
+    int paymentMethod(const std::string& name) const { return lookup(paymentMethods, name); }
+
+    int categoryPayment(const std::string& category, const std::string& paymentMethod) const {
+        return lookup(categoryPayments, pairKey(category, paymentMethod));
+    }
+
+    int getTotal() const { return total; }
+};
+
+// Word counts kept in first-occurrence order, the order the linear-search
+// table of a full recompute would hold, so ranking a copy of the entries
+// gives the same top words as reprocessing every review
+class IncrementalWordTable {
+private:
+    HashMap<std::string, int> slots;    // Word -> index into entries
+    Array<WordFrequency> entries;
+
+public:
+    void addWord(const std::string& word) {
+        int& slot = slots.getOrInsert(word, -1);
+        if (slot < 0) {
+            slot = entries.getSize();
+            entries.push_back(WordFrequency(word, 0));
+        }
+        entries[slot].frequency++;
+    }
+
+    const Array<WordFrequency>& getEntries() const { return entries; }
+};
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef LAZY_TABLE_H
+#define LAZY_TABLE_H
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Array.h"
+#include "StringArena.h"
+#include "Metrics.h"
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+private:
+    const char* bytes;
+    long long length;
+
+public:
+    MappedFile() : bytes(nullptr), length(0) {}
+
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const std::string& path, std::string& error) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "could not open " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) < 0) {
+            error = "could not stat " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        length = info.st_size;
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                error = "could not map " + path + ": " + std::strerror(errno);
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            bytes = static_cast<const char*>(mapped);
+            madvise(mapped, length, MADV_SEQUENTIAL);
+        }
+        ::close(fd);    // The mapping stays valid
+        return true;
+    }
+
+    void close() {
+        if (bytes) munmap(const_cast<char*>(bytes), length);
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const char* data() const { return bytes; }
+    long long size() const { return length; }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+// Byte offset just past the CSV field starting at begin (at its separator,
+// or at end). A field opening with a quote runs to the closing quote.
+inline const char* csvFieldEnd(const char* begin, const char* end) {
+    const char* p = begin;
+    if (p < end && *p == '"') {
+        p++;
+        while (p < end) {
+            if (*p == '"') {
+                if (p + 1 < end && p[1] == '"') {
+                    p += 2;
+                    continue;
+                }
+                p++;
+                break;
+            }
+            p++;
+        }
+    }
+    const char* comma = static_cast<const char*>(std::memchr(p, ',', end - p));
+    return comma ? comma : end;
+}
+
+// A CSV file mapped into memory with rows recorded only as field offsets.
+// Nothing is decoded up front: the first access to a column decodes and
+// converts that column for every row and caches it, so a question pays only
+// for the columns it reads. Single fields can also be read uncached, which
+// suits printing a handful of rows. Rows with fewer fields than the header
+// are skipped. Not thread-safe.
+class LazyTable {
+private:
+    struct LazyColumn {
+        bool hasText, hasReal, hasInteger;
+        Array<StringRef> text;
+        Array<double> real;
+        Array<int> integer;
+
+        LazyColumn() : hasText(false), hasReal(false), hasInteger(false), text(1), real(1), integer(1) {}
+    };
+
+    MappedFile file;
+    Array<std::string> columnNames;     // From the header line
+    int columnCount;
+    Array<long long> fieldStarts;       // Per row: columnCount field starts plus an end
+    int rowCount;
+    LazyColumn* columns;
+    StringArena unescaped;              // Quoted fields containing doubled quotes
+
+    const long long* rowOffsets(int row) const {
+        return fieldStarts.getData() + static_cast<long long>(row) * (columnCount + 1);
+    }
+
+    // Record the field starts of one line; false if it has too few fields
+    bool indexLine(const char* begin, const char* end) {
+        const char* base = file.data();
+        const char* p = begin;
+        long long starts[64];
+        for (int c = 0; c < columnCount; c++) {
+            if (p > end) return false;
+            starts[c] = p - base;
+            p = csvFieldEnd(p, end) + 1;
+        }
+        for (int c = 0; c < columnCount; c++) {
+            fieldStarts.push_back(starts[c]);
+        }
+        // End of the last used field (where its separator or the line end is)
+        fieldStarts.push_back((p - 1) - base);
+        return true;
+    }
+
+public:
+    LazyTable() : columnCount(0), rowCount(0), columns(nullptr) {}
+
+    ~LazyTable() {
+        delete[] columns;
+    }
+
+    // Map the file and record field offsets; the header names the columns
+    bool open(const std::string& path, std::string& error) {
+        ScopedTimer timer("lazy.index");
+        if (!file.open(path, error)) return false;
+        const char* data = file.data();
+        const char* end = data + file.size();
+
+        const char* lineEnd = data ? static_cast<const char*>(std::memchr(data, '\n', end - data)) : nullptr;
+        if (!lineEnd) lineEnd = end;
+        for (const char* p = data; p < lineEnd; ) {
+            const char* fieldEnd = csvFieldEnd(p, lineEnd);
+            columnNames.push_back(std::string(p, fieldEnd - p));
+            p = fieldEnd + 1;
+        }
+        columnCount = columnNames.getSize();
+        if (columnCount == 0 || columnCount > 64) {
+            error = path + ": expected a header with 1 to 64 columns";
+            return false;
+        }
+
+        // Sized from the file length so the offsets array rarely regrows
+        fieldStarts = Array<long long>(static_cast<int>(file.size() / 8) + 16);
+        for (const char* line = lineEnd + 1; line < end; ) {
+            const char* next = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            if (!next) next = end;
+            if (indexLine(line, next)) rowCount++;
+            line = next + 1;
+        }
+        columns = new LazyColumn[columnCount];
+        countMetric("lazy.rows", rowCount);
+        return true;
+    }
+
+    int getRowCount() const { return rowCount; }
+    int getColumnCount() const { return columnCount; }
+
+    // Index of the column with this header name, or -1
+    int findColumn(const std::string& name) const {
+        for (int c = 0; c < columnCount; c++) {
+            if (columnNames[c] == name) return c;
+        }
+        return -1;
+    }
+
+    // One field's text, quotes removed; doubled quotes are collapsed into
+    // the table's arena, anything else points into the mapping
+    StringRef textAt(int row, int column) {
+        const long long* offsets = rowOffsets(row);
+        const char* begin = file.data() + offsets[column];
+        const char* end = file.data() + offsets[column + 1] - (column + 1 < columnCount ? 1 : 0);
+        if (begin == end || *begin != '"') return StringRef(begin, static_cast<int>(end - begin));
+
+        const char* close = begin + 1;
+        bool escaped = false;
+        while (close < end) {
+            if (*close == '"') {
+                if (close + 1 < end && close[1] == '"') {
+                    escaped = true;
+                    close += 2;
+                    continue;
+                }
+                break;
+            }
+            close++;
+        }
+        if (!escaped) return StringRef(begin + 1, static_cast<int>(close - begin - 1));
+
+        std::string text;
+        for (const char* p = begin + 1; p < close; p++) {
+            text += *p;
+            if (*p == '"') p++;     // Skip the second quote of a pair
+        }
+        return unescaped.store(text.data(), static_cast<int>(text.size()));
+    }
+
+    // Numbers convert like std::stod / std::stoi; a field with no number reads as 0
+    double realAt(int row, int column) {
+        return textAt(row, column).toDouble();
+    }
+
+    int integerAt(int row, int column) {
+        return textAt(row, column).toInt();
+    }
+
+    // Whole columns, decoded on first use and cached
+    const Array<StringRef>& text(int column) {
+        LazyColumn& cached = columns[column];
+        if (!cached.hasText) {
+            ScopedTimer timer("lazy.decode");
+            cached.text = Array<StringRef>(rowCount > 0 ? rowCount : 1);
+            for (int r = 0; r < rowCount; r++) {
+                cached.text.push_back(textAt(r, column));
+            }
+            cached.hasText = true;
+            countMetric("lazy.columns.decoded", 1);
+        }
+        return cached.text;
+    }
+
+    const Array<double>& real(int column) {
+        LazyColumn& cached = columns[column];
+        if (!cached.hasReal) {
+            ScopedTimer timer("lazy.decode");
+            cached.real = Array<double>(rowCount > 0 ? rowCount : 1);
+            for (int r = 0; r < rowCount; r++) {
+                cached.real.push_back(realAt(r, column));
+            }
+            cached.hasReal = true;
+            countMetric("lazy.columns.decoded", 1);
+        }
+        return cached.real;
+    }
+
+    const Array<int>& integer(int column) {
+        LazyColumn& cached = columns[column];
+        if (!cached.hasInteger) {
+            ScopedTimer timer("lazy.decode");
+            cached.integer = Array<int>(rowCount > 0 ? rowCount : 1);
+            for (int r = 0; r < rowCount; r++) {
+                cached.integer.push_back(integerAt(r, column));
+            }
+            cached.hasInteger = true;
+            countMetric("lazy.columns.decoded", 1);
+        }
+        return cached.integer;
+    }
+
+    LazyTable(const LazyTable&) = delete;
+    LazyTable& operator=(const LazyTable&) = delete;
+};
+
+#endif
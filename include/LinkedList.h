@@ -40,6 +40,19 @@ public:
         return head;
     }
 
+    // Hand the nodes over to the caller; the list is left empty
+    Node<T>* release() {
+        Node<T>* chain = head;
+        head = nullptr;
+        return chain;
+    }
+
+    // Free the current nodes and take ownership of an already linked chain
+    void adopt(Node<T>* chain) {
+        clear();
+        head = chain;
+    }
+
     void clear() {
         Node<T>* current = head;
         while (current) {
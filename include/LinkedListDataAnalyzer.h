@@ -4,8 +4,15 @@
 #include <string>
 #include <cctype>
 #include <algorithm>
+#include <thread>
+#include "Array.h"
 #include "LinkedList.h"
+#include "UnrolledLinkedList.h"
 #include "DataStructures.h"
+#include "ConcurrentWordCounter.h"
+#include "Metrics.h"
+#include "MemoryAccounting.h"
+#include "IncrementalState.h"
 
 class LinkedListDataAnalyzer {
 private:
@@ -13,6 +20,20 @@ private:
     LinkedList<Review> reviews;
     LinkedList<WordFrequency> wordFrequencies;
 
+    // Arena-backed records: string bytes live in stringArena
+    StringArena stringArena;
+    LinkedList<TransactionRef> arenaTransactions;
+    LinkedList<ReviewRef> arenaReviews;
+
+    // Incremental mode: aggregates maintained as batches are appended. The
+    // tails are remembered so appending a batch never walks the stored rows.
+    LinkedList<Transaction> sortedTransactions;
+    Node<Transaction>* sortedTail;
+    Node<Transaction>* transactionsTail;
+    Node<Review>* reviewsTail;
+    TransactionCounters transactionCounters;
+    IncrementalWordTable negativeWords;
+
     // Helper function to convert string to lowercase
     std::string toLowerCase(const std::string& str) {
         std::string result = str;
@@ -104,7 +125,108 @@ private:
         return slow;
     }
 
+    // Sort word frequencies using merge sort
+    void sortWordFrequencies() {
+        Node<WordFrequency>* sortedHead = mergeSort(wordFrequencies.begin(), compareWordFrequency);
+        // Update the head of wordFrequencies
+        wordFrequencies = LinkedList<WordFrequency>();  // Clear the list
+        Node<WordFrequency>* current_node = sortedHead;
+        while (current_node) {
+            wordFrequencies.add(current_node->data);
+            current_node = current_node->next;
+        }
+    }
+
+    // Link a chain after the last node of a list and return the new last node.
+    // tail may be null, in which case the list is walked once to find it.
+    template<typename T>
+    static Node<T>* appendChain(LinkedList<T>& list, Node<T>* tail, Node<T>* chain) {
+        if (!tail) {
+            tail = list.begin();
+            while (tail && tail->next) tail = tail->next;
+        }
+        if (!chain) return tail;
+        if (tail) {
+            tail->next = chain;
+        } else {
+            list.adopt(chain);
+        }
+        while (chain->next) chain = chain->next;
+        return chain;
+    }
+
+    // Iterative merge of two sorted chains; ties take the left node
+    template<typename T>
+    static Node<T>* mergeChains(Node<T>* left, Node<T>* right, int (*compare)(const T&, const T&)) {
+        Node<T> dummy{T()};
+        Node<T>* last = &dummy;
+        while (left && right) {
+            if (compare(left->data, right->data) <= 0) {
+                last->next = left;
+                left = left->next;
+            } else {
+                last->next = right;
+                right = right->next;
+            }
+            last = last->next;
+        }
+        last->next = left ? left : right;
+        return dummy.next;
+    }
+
+    // Count the words of 1-star reviews with numThreads workers
+    Array<WordCountEntry> countNegativeWordsParallel(int numThreads, CounterMode mode) {
+        ScopedTimer timer("analysis.countWords");
+
+        // Workers need random access to their chunk, so index the nodes once
+        Array<Node<Review>*> reviewNodes;
+        Node<Review>* current = reviews.begin();
+        while (current) {
+            reviewNodes.push_back(current);
+            current = current->next;
+        }
+        // Arena-backed reviews are numbered after the owned ones
+        Array<Node<ReviewRef>*> arenaNodes;
+        for (Node<ReviewRef>* node = arenaReviews.begin(); node; node = node->next) {
+            arenaNodes.push_back(node);
+        }
+
+        ConcurrentWordCounter counter(mode, numThreads);
+        int ownedCount = reviewNodes.getSize();
+        int reviewCount = ownedCount + arenaNodes.getSize();
+        timer.addRows(reviewCount);
+        int chunk = (reviewCount + numThreads - 1) / numThreads;
+
+        std::thread* workers = new std::thread[numThreads];
+        for (int t = 0; t < numThreads; t++) {
+            workers[t] = std::thread([this, &counter, &reviewNodes, &arenaNodes, t, chunk, ownedCount, reviewCount]() {
+                int end = std::min(reviewCount, (t + 1) * chunk);
+                for (int i = t * chunk; i < end; i++) {
+                    int rating = i < ownedCount ? reviewNodes[i]->data.rating : arenaNodes[i - ownedCount]->data.rating;
+                    if (rating == 1) {
+                        LinkedList<std::string> words = i < ownedCount
+                            ? splitIntoWords(reviewNodes[i]->data.reviewText)
+                            : splitIntoWords(arenaNodes[i - ownedCount]->data.reviewText.str());
+                        int j = 0;
+                        for (Node<std::string>* word = words.begin(); word; word = word->next) {
+                            counter.addWord(t, word->data, wordPosition(i, j++));
+                        }
+                    }
+                }
+                counter.finishThread(t);
+            });
+        }
+        for (int t = 0; t < numThreads; t++) {
+            workers[t].join();
+        }
+        delete[] workers;
+
+        return counter.collect();
+    }
+
 public:
+    LinkedListDataAnalyzer() : sortedTail(nullptr), transactionsTail(nullptr), reviewsTail(nullptr) {}
+
     // Merge sort implementation
     template<typename T>
     Node<T>* mergeSort(Node<T>* head, int (*compare)(const T&, const T&)) {
@@ -121,6 +243,12 @@ public:
         return merge(left, right, compare);
     }
 
+    // Merge sort for unrolled lists: chunks are sorted in place, then merged
+    template<typename T, int ChunkSize>
+    void mergeSort(UnrolledLinkedList<T, ChunkSize>& list, int (*compare)(const T&, const T&)) {
+        list.mergeSort(compare);
+    }
+
     // Add transaction to the list
     void addTransaction(const Transaction& transaction) {
         transactions.add(transaction);
@@ -131,6 +259,27 @@ public:
         reviews.add(review);
     }
 
+    // Add a transaction whose fields point at caller-owned characters (e.g. the
+    // current CSV line); the bytes are copied into the analyzer's string arena
+    void addTransaction(const TransactionRef& transaction) {
+        arenaTransactions.add(TransactionRef(
+            stringArena.store(transaction.customerId),
+            stringArena.store(transaction.product),
+            stringArena.store(transaction.category),
+            transaction.price,
+            stringArena.store(transaction.date),
+            stringArena.store(transaction.paymentMethod)));
+    }
+
+    // Add a review whose fields point at caller-owned characters
+    void addReview(const ReviewRef& review) {
+        arenaReviews.add(ReviewRef(
+            stringArena.store(review.productId),
+            stringArena.store(review.customerId),
+            review.rating,
+            stringArena.store(review.reviewText)));
+    }
+
     // Linear search for word frequency counting
     void linearSearch(const LinkedList<std::string>& words, LinkedList<WordFrequency>& frequencies) {
         Node<std::string>* wordNode = words.begin();
@@ -156,24 +305,51 @@ public:
 
     // Analyze negative reviews (1-star ratings)
     void analyzeNegativeReviews() {
-        Node<Review>* current = reviews.begin();
-        while (current) {
-            if (current->data.rating == 1) {
-                LinkedList<std::string> words = splitIntoWords(current->data.reviewText);
-                linearSearch(words, wordFrequencies);
+        {
+            ScopedTimer timer("analysis.countWords");
+            int negativeReviews = 0;
+            long long scanned = 0;
+            Node<Review>* current = reviews.begin();
+            while (current) {
+                scanned++;
+                if (current->data.rating == 1) {
+                    LinkedList<std::string> words = splitIntoWords(current->data.reviewText);
+                    linearSearch(words, wordFrequencies);
+                    negativeReviews++;
+                }
+                current = current->next;
             }
-            current = current->next;
+            for (Node<ReviewRef>* node = arenaReviews.begin(); node; node = node->next) {
+                scanned++;
+                if (node->data.rating == 1) {
+                    LinkedList<std::string> words = splitIntoWords(node->data.reviewText.str());
+                    linearSearch(words, wordFrequencies);
+                    negativeReviews++;
+                }
+            }
+            timer.addRows(scanned);
+            countMetric("analysis.negativeReviews", negativeReviews);
         }
 
-        // Sort word frequencies using merge sort
-        Node<WordFrequency>* sortedHead = mergeSort(wordFrequencies.begin(), compareWordFrequency);
-        // Update the head of wordFrequencies
-        wordFrequencies = LinkedList<WordFrequency>();  // Clear the list
-        Node<WordFrequency>* current_node = sortedHead;
-        while (current_node) {
-            wordFrequencies.add(current_node->data);
-            current_node = current_node->next;
+        ScopedTimer timer("analysis.sortWords");
+        sortWordFrequencies();
+    }
+
+    // Multi-threaded analyzeNegativeReviews. Reviews are split into one contiguous
+    // chunk per thread and counted in a ConcurrentWordCounter; the result replaces
+    // the current word list and matches the single-threaded ranking exactly.
+    void analyzeNegativeReviewsParallel(int numThreads, CounterMode mode) {
+        if (numThreads < 1) numThreads = 1;
+
+        // Replay words in first-occurrence order, then rank as usual
+        Array<WordCountEntry> entries = countNegativeWordsParallel(numThreads, mode);
+        wordFrequencies.clear();
+        for (int i = 0; i < entries.getSize(); i++) {
+            wordFrequencies.add(WordFrequency(entries[i].word, entries[i].frequency));
         }
+
+        ScopedTimer sortTimer("analysis.sortWords");
+        sortWordFrequencies();
     }
 
     // Get top N frequent words
@@ -190,9 +366,98 @@ public:
         return result;
     }
 
+    // Incremental mode: take over a batch of new transactions (the batch is left
+    // empty), update the counters and fold the batch into the date order. The
+    // batch is merge sorted on its own; when it starts no earlier than the
+    // current last date it is linked after the tail, otherwise the two sorted
+    // chains are merged.
+    void appendTransactions(LinkedList<Transaction>& batch) {
+        ScopedTimer timer("incremental.transactions");
+        Node<Transaction>* copyHead = nullptr;
+        Node<Transaction>* copyTail = nullptr;
+        for (Node<Transaction>* node = batch.begin(); node; node = node->next) {
+            transactionCounters.add(node->data);
+            Node<Transaction>* copy = new Node<Transaction>(node->data);
+            if (copyTail) {
+                copyTail->next = copy;
+            } else {
+                copyHead = copy;
+            }
+            copyTail = copy;
+        }
+        if (!copyHead) return;
+        transactionsTail = appendChain(transactions, transactionsTail, copyHead);
+
+        Node<Transaction>* sortedBatch = mergeSort(batch.release(), compareTransactionsByDate);
+        if (!sortedTail || compareTransactionsByDate(sortedTail->data, sortedBatch->data) <= 0) {
+            sortedTail = appendChain(sortedTransactions, sortedTail, sortedBatch);
+            return;
+        }
+        sortedTransactions.adopt(mergeChains(sortedTransactions.release(), sortedBatch, compareTransactionsByDate));
+        sortedTail = sortedTransactions.begin();
+        while (sortedTail->next) sortedTail = sortedTail->next;
+    }
+
+    // Incremental mode: take over a batch of new reviews (the batch is left
+    // empty) and count the words of the 1-star ones into the running table,
+    // then re-rank it. Only the new reviews are tokenized.
+    void appendReviews(LinkedList<Review>& batch) {
+        ScopedTimer timer("incremental.reviews");
+        for (Node<Review>* node = batch.begin(); node; node = node->next) {
+            if (node->data.rating == 1) {
+                LinkedList<std::string> words = splitIntoWords(node->data.reviewText);
+                for (Node<std::string>* word = words.begin(); word; word = word->next) {
+                    negativeWords.addWord(word->data);
+                }
+            }
+        }
+        if (!batch.begin()) return;
+        reviewsTail = appendChain(reviews, reviewsTail, batch.release());
+
+        // Rebuild the word list in first-seen order and rank it with the same
+        // stable merge sort as sortWordFrequencies
+        const Array<WordFrequency>& entries = negativeWords.getEntries();
+        Node<WordFrequency>* head = nullptr;
+        Node<WordFrequency>* tail = nullptr;
+        for (int i = 0; i < entries.getSize(); i++) {
+            Node<WordFrequency>* node = new Node<WordFrequency>(entries[i]);
+            if (tail) {
+                tail->next = node;
+            } else {
+                head = node;
+            }
+            tail = node;
+        }
+        wordFrequencies.adopt(mergeSort(head, compareWordFrequency));
+    }
+
+    // Transactions appended in incremental mode, in date order
+    const LinkedList<Transaction>& getSortedTransactions() const { return sortedTransactions; }
+    const TransactionCounters& getTransactionCounters() const { return transactionCounters; }
+
+    // Publish byte accounting for the stored records as metric counters.
+    // Call before Question 1: its sort relinks the stored nodes, after which
+    // the lists no longer reach all of them.
+    void reportRecordMemory() const {
+        reportContainerMemory("transactions", containerMemory(transactions));
+        reportContainerMemory("reviews", containerMemory(reviews));
+        if (stringArena.getBlockCount() > 0) {
+            reportContainerMemory("arenaTransactions", containerMemory(arenaTransactions));
+            reportContainerMemory("arenaReviews", containerMemory(arenaReviews));
+            reportArenaMemory("stringArena", stringArena);
+        }
+    }
+
+    // Same for the word table, once Question 3 has filled it
+    void reportWordMemory() const {
+        reportContainerMemory("wordFrequencies", containerMemory(wordFrequencies));
+    }
+
     // Getters for the lists
     const LinkedList<Transaction>& getTransactions() const { return transactions; }
     const LinkedList<Review>& getReviews() const { return reviews; }
+    const LinkedList<TransactionRef>& getArenaTransactions() const { return arenaTransactions; }
+    const LinkedList<ReviewRef>& getArenaReviews() const { return arenaReviews; }
 };
 
 #endif
@@ -0,0 +1,122 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <string>
+#include "Array.h"
+#include "LinkedList.h"
+#include "DataStructures.h"
+#include "Metrics.h"
+#include "StringArena.h"
+
+// Byte accounting for one container, including what its elements own
+struct ContainerMemory {
+    long long elements;     // Elements stored
+    long long slots;        // Array capacity or list node count
+    long long structBytes;  // Bytes of the slots / nodes themselves
+    long long heapBytes;    // Bytes owned by the elements (string buffers)
+    long long slackBytes;   // Bytes of allocated but unused slots
+    long long heapBlocks;   // Separate heap allocations behind the container
+
+    ContainerMemory() : elements(0), slots(0), structBytes(0), heapBytes(0), slackBytes(0), heapBlocks(0) {}
+
+    long long totalBytes() const { return structBytes + heapBytes; }
+
+    long long bytesPerElement() const {
+        return elements > 0 ? totalBytes() / elements : 0;
+    }
+};
+
+// Heap bytes owned by a value; zero for anything without indirection
+template <typename T>
+long long heapBytes(const T&) {
+    return 0;
+}
+
+// Strings that fit the small-string buffer own no heap memory
+inline long long heapBytes(const std::string& str) {
+    static const size_t inlineCapacity = std::string().capacity();
+    return str.capacity() > inlineCapacity ? static_cast<long long>(str.capacity()) + 1 : 0;
+}
+
+inline long long heapBytes(const Transaction& t) {
+    return heapBytes(t.customerId) + heapBytes(t.product) + heapBytes(t.category) +
+           heapBytes(t.date) + heapBytes(t.paymentMethod);
+}
+
+inline long long heapBytes(const Review& r) {
+    return heapBytes(r.productId) + heapBytes(r.customerId) + heapBytes(r.reviewText);
+}
+
+inline long long heapBytes(const WordFrequency& w) {
+    return heapBytes(w.word);
+}
+
+// Number of heap blocks behind a value (one per heap-allocated string)
+template <typename T>
+long long heapBlocks(const T& value) {
+    return heapBytes(value) > 0 ? 1 : 0;
+}
+
+inline long long heapBlocks(const Transaction& t) {
+    return heapBlocks(t.customerId) + heapBlocks(t.product) + heapBlocks(t.category) +
+           heapBlocks(t.date) + heapBlocks(t.paymentMethod);
+}
+
+inline long long heapBlocks(const Review& r) {
+    return heapBlocks(r.productId) + heapBlocks(r.customerId) + heapBlocks(r.reviewText);
+}
+
+template <typename T>
+ContainerMemory containerMemory(const Array<T>& array) {
+    ContainerMemory memory;
+    memory.elements = array.getSize();
+    memory.slots = array.getCapacity();
+    memory.structBytes = memory.slots * static_cast<long long>(sizeof(T));
+    memory.slackBytes = (memory.slots - memory.elements) * static_cast<long long>(sizeof(T));
+    memory.heapBlocks = 1;
+    for (int i = 0; i < array.getSize(); i++) {
+        memory.heapBytes += heapBytes(array[i]);
+        memory.heapBlocks += heapBlocks(array[i]);
+    }
+    return memory;
+}
+
+// Every list node is its own allocation; the next pointer is pure overhead
+template <typename T>
+ContainerMemory containerMemory(const LinkedList<T>& list) {
+    ContainerMemory memory;
+    for (Node<T>* current = list.begin(); current; current = current->next) {
+        memory.elements++;
+        memory.heapBytes += heapBytes(current->data);
+        memory.heapBlocks += 1 + heapBlocks(current->data);
+    }
+    memory.slots = memory.elements;
+    memory.structBytes = memory.slots * static_cast<long long>(sizeof(Node<T>));
+    memory.slackBytes = memory.slots * static_cast<long long>(sizeof(Node<T>) - sizeof(T));
+    return memory;
+}
+
+// Publish a container's accounting as memory.<name>.* metric counters
+inline void reportContainerMemory(const std::string& name, const ContainerMemory& memory) {
+    Metrics& metrics = Metrics::instance();
+    if (!metrics.isEnabled()) return;
+    std::string prefix = "memory." + name + ".";
+    metrics.addCounter(prefix + "elements", memory.elements);
+    metrics.addCounter(prefix + "slots", memory.slots);
+    metrics.addCounter(prefix + "structBytes", memory.structBytes);
+    metrics.addCounter(prefix + "heapBytes", memory.heapBytes);
+    metrics.addCounter(prefix + "slackBytes", memory.slackBytes);
+    metrics.addCounter(prefix + "heapBlocks", memory.heapBlocks);
+    metrics.addCounter(prefix + "totalBytes", memory.totalBytes());
+    metrics.addCounter(prefix + "bytesPerElement", memory.bytesPerElement());
+}
+
+// Publish the bytes and block count held by a string arena
+inline void reportArenaMemory(const std::string& name, const StringArena& arena) {
+    Metrics& metrics = Metrics::instance();
+    if (!metrics.isEnabled()) return;
+    metrics.addCounter("memory." + name + ".bytesStored", arena.getBytesStored());
+    metrics.addCounter("memory." + name + ".blocks", arena.getBlockCount());
+}
+
+#endif
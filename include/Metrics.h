@@ -0,0 +1,279 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <mutex>
+#include <sys/resource.h>
+#include "Array.h"
+#include "AllocationTracker.h"
+#include "PerfCounters.h"
+
+// Wall time, peak memory, heap allocations and hardware counters of one
+// named phase (summed over calls), with the rows it processed if known
+struct PhaseMetric {
+    std::string name;
+    double seconds;
+    int calls;
+    long peakRssKb;
+    long long allocations;
+    long long allocatedBytes;
+    long long rows;
+    PerfSample perf;
+
+    PhaseMetric(const std::string& n = "", double s = 0, int c = 0, long rss = 0,
+                long long allocs = 0, long long allocBytes = 0, long long r = 0)
+        : name(n), seconds(s), calls(c), peakRssKb(rss), allocations(allocs), allocatedBytes(allocBytes), rows(r) {}
+};
+
+struct CounterMetric {
+    std::string name;
+    long long value;
+
+    CounterMetric(const std::string& n = "", long long v = 0) : name(n), value(v) {}
+};
+
+// Process-wide metrics registry. Everything is a no-op until enable() is
+// called, so instrumented code only pays for one flag check when disabled.
+class Metrics {
+private:
+    bool enabled;
+    bool perfEnabled;
+    std::string program;
+    PerfCounters perfCounters;
+    Array<PhaseMetric> phases;
+    Array<CounterMetric> counters;
+    std::mutex lock;
+
+    Metrics() : enabled(false), perfEnabled(false) {}
+
+    // Escape a string for use inside JSON quotes
+    static std::string escapeJson(const std::string& str) {
+        std::string result;
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+                result += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                result += ' ';
+            } else {
+                result += c;
+            }
+        }
+        return result;
+    }
+
+public:
+    static Metrics& instance() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    void enable(const std::string& programName) {
+        enabled = true;
+        program = programName;
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    // Also sample hardware counters around every phase. False with a reason
+    // if no counter can be opened; phases are then reported without them.
+    bool enablePerfCounters(std::string& error) {
+        perfEnabled = perfCounters.open(error);
+        return perfEnabled;
+    }
+
+    bool isPerfEnabled() const { return enabled && perfEnabled; }
+
+    void readPerf(PerfSample& sample) const {
+        perfCounters.read(sample);
+    }
+
+    // Peak resident set size of the process so far, in KB (Linux reports KB)
+    static long samplePeakRssKb() {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+        return usage.ru_maxrss;
+    }
+
+    void recordPhase(const std::string& name, double seconds, long long allocations = 0, long long allocatedBytes = 0,
+                     long long rows = 0, const PerfSample* perf = nullptr) {
+        if (!enabled) return;
+        long rss = samplePeakRssKb();
+        std::lock_guard<std::mutex> guard(lock);
+        int index = 0;
+        while (index < phases.getSize() && phases[index].name != name) {
+            index++;
+        }
+        if (index == phases.getSize()) {
+            phases.push_back(PhaseMetric(name));
+        }
+        PhaseMetric& phase = phases[index];
+        phase.seconds += seconds;
+        phase.calls++;
+        phase.peakRssKb = rss;
+        phase.allocations += allocations;
+        phase.allocatedBytes += allocatedBytes;
+        phase.rows += rows;
+        if (perf) {
+            for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                phase.perf.values[e] += perf->values[e];
+            }
+        }
+    }
+
+    void addCounter(const std::string& name, long long delta) {
+        if (!enabled) return;
+        std::lock_guard<std::mutex> guard(lock);
+        for (int i = 0; i < counters.getSize(); i++) {
+            if (counters[i].name == name) {
+                counters[i].value += delta;
+                return;
+            }
+        }
+        counters.push_back(CounterMetric(name, delta));
+    }
+
+    // Raw counts of the open events, then IPC and misses per row when they apply
+    void writePerf(std::ostream& out, const PhaseMetric& phase) const {
+        const long long* values = phase.perf.values;
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (perfCounters.isOpen(e)) out << ", \"" << PERF_EVENT_NAMES[e] << "\": " << values[e];
+        }
+        if (perfCounters.isOpen(PERF_CYCLES) && perfCounters.isOpen(PERF_INSTRUCTIONS) && values[PERF_CYCLES] > 0) {
+            out << ", \"ipc\": " << static_cast<double>(values[PERF_INSTRUCTIONS]) / values[PERF_CYCLES];
+        }
+        if (phase.rows > 0) {
+            for (int e = PERF_CACHE_MISSES; e < PERF_EVENT_COUNT; e++) {
+                if (perfCounters.isOpen(e)) {
+                    out << ", \"" << PERF_EVENT_NAMES[e] << "PerRow\": " << static_cast<double>(values[e]) / phase.rows;
+                }
+            }
+        }
+    }
+
+    // Write all phases and counters as a JSON document
+    bool writeJson(const std::string& path) {
+        std::ofstream out(path);
+        if (!out.is_open()) return false;
+
+        std::lock_guard<std::mutex> guard(lock);
+        bool tracking = AllocationTracker::isCompiledIn();
+        out << "{\n";
+        out << "  \"program\": \"" << escapeJson(program) << "\",\n";
+        out << "  \"peakRssKb\": " << samplePeakRssKb() << ",\n";
+        if (tracking) {
+            AllocationStats stats = AllocationTracker::snapshot();
+            out << "  \"allocations\": {\"count\": " << stats.allocations
+                << ", \"frees\": " << stats.frees
+                << ", \"bytes\": " << stats.bytesAllocated
+                << ", \"liveBytes\": " << stats.liveBytes
+                << ", \"peakLiveBytes\": " << stats.peakLiveBytes << "},\n";
+        }
+        if (perfEnabled) {
+            out << "  \"perfCounters\": [";
+            bool first = true;
+            for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                if (!perfCounters.isOpen(e)) continue;
+                out << (first ? "" : ", ") << "\"" << PERF_EVENT_NAMES[e] << "\"";
+                first = false;
+            }
+            out << "],\n";
+        }
+        out << "  \"phases\": [";
+        for (int i = 0; i < phases.getSize(); i++) {
+            out << (i == 0 ? "\n" : ",\n");
+            out << "    {\"name\": \"" << escapeJson(phases[i].name) << "\", "
+                << "\"seconds\": " << phases[i].seconds << ", "
+                << "\"calls\": " << phases[i].calls << ", "
+                << "\"peakRssKb\": " << phases[i].peakRssKb;
+            if (tracking) {
+                out << ", \"allocations\": " << phases[i].allocations
+                    << ", \"allocatedBytes\": " << phases[i].allocatedBytes;
+            }
+            if (phases[i].rows > 0) {
+                out << ", \"rows\": " << phases[i].rows;
+            }
+            if (perfEnabled) {
+                writePerf(out, phases[i]);
+            }
+            out << "}";
+        }
+        out << (phases.getSize() > 0 ? "\n  ],\n" : "],\n");
+        out << "  \"counters\": {";
+        for (int i = 0; i < counters.getSize(); i++) {
+            out << (i == 0 ? "\n" : ",\n");
+            out << "    \"" << escapeJson(counters[i].name) << "\": " << counters[i].value;
+        }
+        out << (counters.getSize() > 0 ? "\n  }\n" : "}\n");
+        out << "}\n";
+        return true;
+    }
+};
+
+// Times the enclosing scope and records it as a phase, together with the
+// allocations made meanwhile when allocation tracking is compiled in
+class ScopedTimer {
+private:
+    const char* phase;
+    bool active;
+    bool sampling;
+    long long rows;
+    std::chrono::steady_clock::time_point start;
+    AllocationStats startAllocations;
+    PerfSample startPerf;
+
+public:
+    explicit ScopedTimer(const char* phaseName)
+        : phase(phaseName), active(Metrics::instance().isEnabled()),
+          sampling(Metrics::instance().isPerfEnabled()), rows(0) {
+        if (active) {
+            startAllocations = AllocationTracker::snapshot();
+            if (sampling) Metrics::instance().readPerf(startPerf);
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedTimer() {
+        stop();
+    }
+
+    // Rows handled by this phase, for per-row counter figures
+    void addRows(long long count) {
+        rows += count;
+    }
+
+    // End the phase early; later calls and the destructor do nothing
+    void stop() {
+        if (active) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            PerfSample perf;
+            if (sampling) {
+                Metrics::instance().readPerf(perf);
+                for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                    perf.values[e] -= startPerf.values[e];
+                }
+            }
+            AllocationStats endAllocations = AllocationTracker::snapshot();
+            Metrics::instance().recordPhase(phase, elapsed.count(),
+                                            endAllocations.allocations - startAllocations.allocations,
+                                            endAllocations.bytesAllocated - startAllocations.bytesAllocated,
+                                            rows, sampling ? &perf : nullptr);
+            active = false;
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+// Add to a named row/byte counter
+inline void countMetric(const char* name, long long delta) {
+    Metrics& metrics = Metrics::instance();
+    if (metrics.isEnabled()) {
+        metrics.addCounter(name, delta);
+    }
+}
+
+#endif
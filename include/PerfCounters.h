@@ -0,0 +1,134 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+// Hardware events sampled around each metrics phase
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_DTLB_MISSES,
+    PERF_EVENT_COUNT
+};
+
+const char* const PERF_EVENT_NAMES[PERF_EVENT_COUNT] = {
+    "cycles", "instructions", "cacheMisses", "branchMisses", "dtlbMisses"
+};
+
+// Counter readings at one point in time, indexed by PerfEvent
+struct PerfSample {
+    long long values[PERF_EVENT_COUNT];
+
+    PerfSample() {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) values[e] = 0;
+    }
+};
+
+// Per-process hardware counters through perf_event_open. Each event is
+// opened on its own, so whatever subset the CPU, hypervisor and
+// perf_event_paranoid setting allow is still reported; events that could not
+// be opened read as zero and isOpen() says so. Counting covers user space of
+// this process and of threads started after open(), whose counts are added
+// when they exit. When the kernel multiplexes counters, readings are scaled
+// by the fraction of time each one actually ran.
+class PerfCounters {
+private:
+    int fds[PERF_EVENT_COUNT];
+
+    static void describe(PerfEvent event, perf_event_attr& attr) {
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        switch (event) {
+            case PERF_CYCLES: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+            case PERF_INSTRUCTIONS: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+            case PERF_CACHE_MISSES: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+            case PERF_BRANCH_MISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+            default:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+        }
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    }
+
+public:
+    PerfCounters() {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) fds[e] = -1;
+    }
+
+    ~PerfCounters() {
+        close();
+    }
+
+    // Open every event that is available; false (with the reason of the
+    // first failure) if none is
+    bool open(std::string& error) {
+        close();
+        int firstErrno = 0;
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            perf_event_attr attr;
+            describe(static_cast<PerfEvent>(e), attr);
+            fds[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds[e] < 0 && firstErrno == 0) firstErrno = errno;
+        }
+        if (openCount() > 0) return true;
+
+        if (firstErrno == EACCES || firstErrno == EPERM) {
+            error = "not permitted (see /proc/sys/kernel/perf_event_paranoid)";
+        } else if (firstErrno == ENOENT || firstErrno == EOPNOTSUPP || firstErrno == ENODEV) {
+            error = "no hardware counters on this CPU or virtual machine";
+        } else {
+            error = std::string("perf_event_open: ") + std::strerror(firstErrno);
+        }
+        return false;
+    }
+
+    void close() {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (fds[e] >= 0) ::close(fds[e]);
+            fds[e] = -1;
+        }
+    }
+
+    bool isOpen(int event) const { return fds[event] >= 0; }
+
+    int openCount() const {
+        int count = 0;
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (fds[e] >= 0) count++;
+        }
+        return count;
+    }
+
+    // Current totals since open()
+    void read(PerfSample& sample) const {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            sample.values[e] = 0;
+            uint64_t reading[3];    // Value, time enabled, time running
+            if (fds[e] < 0 || ::read(fds[e], reading, sizeof(reading)) != static_cast<ssize_t>(sizeof(reading))) {
+                continue;
+            }
+            double scale = reading[2] > 0 && reading[2] < reading[1] ? static_cast<double>(reading[1]) / reading[2] : 1.0;
+            sample.values[e] = static_cast<long long>(reading[0] * scale);
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+};
+
+#endif
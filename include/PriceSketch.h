@@ -0,0 +1,329 @@
+#ifndef PRICE_SKETCH_H
+#define PRICE_SKETCH_H
+
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include "Array.h"
+#include "HashMap.h"
+#include "DataStructures.h"
+
+// Cluster of nearby values in a t-digest
+struct Centroid {
+    double mean;
+    double weight;
+
+    Centroid(double m = 0, double w = 0) : mean(m), weight(w) {}
+};
+
+inline bool centroidBefore(const Centroid& a, const Centroid& b) {
+    return a.mean < b.mean;
+}
+
+// Merging t-digest (Dunning & Ertl) for streaming quantiles. Values are
+// buffered and, when the buffer fills, sorted and merged into the centroid
+// list. Centroids near the median may hold many values, those near either
+// end only a few, so tail quantiles such as p99 stay accurate. A digest keeps
+// O(compression) centroids however many values it has seen, and two
+// digests merge by feeding one's centroids into the other.
+class TDigest {
+private:
+    double compression;
+    Array<Centroid> centroids;      // Sorted by mean after compress()
+    Array<Centroid> buffer;         // Values and foreign centroids not merged yet
+    int bufferLimit;
+    double totalWeight;             // Including the buffer
+    double minValue;
+    double maxValue;
+    Array<double> cumulative;       // Weight before each centroid's midpoint, for quantile()
+
+    // Merge the buffer into the centroids with the scale function k2 limit:
+    // a centroid covering quantiles q0..q1 may hold at most
+    // 4 * total * q * (1 - q) / compression at its tighter end
+    void compress() {
+        if (buffer.getSize() == 0) return;
+        // Only the buffer needs sorting; the centroids already are
+        std::sort(buffer.getData(), buffer.getData() + buffer.getSize(), centroidBefore);
+        int total = buffer.getSize() + centroids.getSize();
+        Array<Centroid> all(total);
+        for (int b = 0, c = 0; b + c < total;) {
+            if (c == centroids.getSize() || (b < buffer.getSize() && buffer[b].mean < centroids[c].mean)) {
+                all.push_back(buffer[b++]);
+            } else {
+                all.push_back(centroids[c++]);
+            }
+        }
+        const Centroid* items = all.getData();
+
+        Array<Centroid> merged(static_cast<int>(compression) * 2 + 8);
+        Centroid current = items[0];
+        double weightBefore = 0;
+        for (int i = 1; i < total; i++) {
+            const Centroid& next = items[i];
+            double proposed = current.weight + next.weight;
+            double q0 = weightBefore / totalWeight;
+            double q1 = (weightBefore + proposed) / totalWeight;
+            double limit = 4 * totalWeight * std::min(q0 * (1 - q0), q1 * (1 - q1)) / compression;
+            if (proposed <= limit) {
+                current.mean += (next.mean - current.mean) * next.weight / proposed;
+                current.weight = proposed;
+            } else {
+                weightBefore += current.weight;
+                merged.push_back(current);
+                current = next;
+            }
+        }
+        merged.push_back(current);
+        centroids = merged;
+        buffer = Array<Centroid>(bufferLimit);
+        cumulative = Array<double>();
+    }
+
+    void prepareQueries() {
+        compress();
+        if (cumulative.getSize() == centroids.getSize()) return;
+        cumulative = Array<double>(centroids.getSize() > 0 ? centroids.getSize() : 1);
+        double before = 0;
+        for (int i = 0; i < centroids.getSize(); i++) {
+            cumulative.push_back(before + centroids[i].weight / 2);
+            before += centroids[i].weight;
+        }
+    }
+
+public:
+    TDigest(double compressionFactor = 100)
+        : compression(compressionFactor), bufferLimit(static_cast<int>(compressionFactor) * 20),
+          totalWeight(0), minValue(0), maxValue(0) {
+        buffer = Array<Centroid>(bufferLimit);
+    }
+
+    void add(double value, double weight = 1) {
+        if (totalWeight == 0 || value < minValue) minValue = value;
+        if (totalWeight == 0 || value > maxValue) maxValue = value;
+        buffer.push_back(Centroid(value, weight));
+        totalWeight += weight;
+        if (buffer.getSize() >= bufferLimit) compress();
+    }
+
+    // Fold another digest (e.g. from another thread or an earlier batch) in
+    void merge(const TDigest& other) {
+        if (other.totalWeight == 0) return;
+        if (totalWeight == 0 || other.minValue < minValue) minValue = other.minValue;
+        if (totalWeight == 0 || other.maxValue > maxValue) maxValue = other.maxValue;
+        for (int i = 0; i < other.centroids.getSize(); i++) buffer.push_back(other.centroids[i]);
+        for (int i = 0; i < other.buffer.getSize(); i++) buffer.push_back(other.buffer[i]);
+        totalWeight += other.totalWeight;
+        if (buffer.getSize() >= bufferLimit) compress();
+    }
+
+    // Value below which a fraction q of the weight lies, interpolated
+    // linearly between centroid midpoints and the exact min and max.
+    // Costs a binary search over at most O(compression) centroids.
+    double quantile(double q) {
+        if (totalWeight == 0) return 0;
+        prepareQueries();
+        if (q <= 0) return minValue;
+        if (q >= 1) return maxValue;
+        double target = q * totalWeight;
+        int n = centroids.getSize();
+        if (target <= cumulative[0]) {
+            double span = cumulative[0];
+            return span > 0 ? minValue + (centroids[0].mean - minValue) * target / span : centroids[0].mean;
+        }
+        if (target >= cumulative[n - 1]) {
+            double span = totalWeight - cumulative[n - 1];
+            return span > 0 ? centroids[n - 1].mean + (maxValue - centroids[n - 1].mean) * (target - cumulative[n - 1]) / span
+                            : centroids[n - 1].mean;
+        }
+        int hi = static_cast<int>(std::upper_bound(cumulative.getData(), cumulative.getData() + n, target) - cumulative.getData());
+        int lo = hi - 1;
+        double fraction = (target - cumulative[lo]) / (cumulative[hi] - cumulative[lo]);
+        return centroids[lo].mean + (centroids[hi].mean - centroids[lo].mean) * fraction;
+    }
+
+    double count() const { return totalWeight; }
+    double min() const { return minValue; }
+    double max() const { return maxValue; }
+    int centroidCount() { compress(); return centroids.getSize(); }
+};
+
+// Fixed-width histogram over [low, high) with one underflow bucket in front
+// and one overflow bucket at the end
+class PriceHistogram {
+private:
+    double low;
+    double high;
+    double scale;                   // Buckets per unit of price
+    int bucketCount;
+    Array<long long> counts;        // bucketCount + 2 entries
+
+public:
+    PriceHistogram(double lowPrice = 0, double highPrice = 2000, int buckets = 20)
+        : low(lowPrice), high(highPrice), scale(buckets / (highPrice - lowPrice)), bucketCount(buckets),
+          counts(buckets + 2) {
+        for (int b = 0; b < buckets + 2; b++) counts.push_back(0);
+    }
+
+    // Bucket a batch of values. Computing every index first in a branch-free
+    // loop lets the compiler vectorize it; only the increments are scalar.
+    // The clamps are written so that NaN fails the first test and lands in
+    // the underflow bucket instead of producing an out-of-range index.
+    void addBatch(const double* values, int n) {
+        int index[256];
+        double lastBucket = bucketCount;
+        long long* count = counts.getData();
+        for (int start = 0; start < n; start += 256) {
+            int chunk = n - start < 256 ? n - start : 256;
+            const double* chunkValues = values + start;
+            for (int i = 0; i < chunk; i++) {
+                double x = (chunkValues[i] - low) * scale;
+                x = x >= -1.0 ? x : -1.0;
+                x = x <= lastBucket ? x : lastBucket;
+                index[i] = static_cast<int>(x + 1.0);
+            }
+            for (int i = 0; i < chunk; i++) {
+                count[index[i]]++;
+            }
+        }
+    }
+
+    void merge(const PriceHistogram& other) {
+        for (int b = 0; b < counts.getSize() && b < other.counts.getSize(); b++) counts[b] += other.counts[b];
+    }
+
+    int getBucketCount() const { return bucketCount; }
+    double bucketLow(int bucket) const { return low + bucket / scale; }
+    long long bucketCountAt(int bucket) const { return counts[bucket + 1]; }
+    long long underflow() const { return counts[0]; }
+    long long overflow() const { return counts[bucketCount + 1]; }
+    double getLow() const { return low; }
+    double getHigh() const { return high; }
+};
+
+const int PRICE_BATCH = 256;
+
+// Quantile digest plus histogram for one group of prices. Prices are
+// collected in batches of PRICE_BATCH and bucketed a batch at a time.
+class PriceSketch {
+private:
+    TDigest digest;
+    PriceHistogram histogram;
+    double pending[PRICE_BATCH];
+    int pendingCount;
+
+    void addBatch(const double* prices, int n) {
+        histogram.addBatch(prices, n);
+        for (int i = 0; i < n; i++) digest.add(prices[i]);
+    }
+
+public:
+    PriceSketch(double low = 0, double high = 2000, int buckets = 20)
+        : histogram(low, high, buckets), pendingCount(0) {}
+
+    // Non-finite prices (strtod accepts "NaN" and "inf") are not counted
+    void add(double price) {
+        if (!std::isfinite(price)) return;
+        pending[pendingCount++] = price;
+        if (pendingCount == PRICE_BATCH) flush();
+    }
+
+    // Bucket and digest the partial batch; queries call this themselves
+    void flush() {
+        addBatch(pending, pendingCount);
+        pendingCount = 0;
+    }
+
+    // Fold another sketch in, e.g. one filled by another thread or from an
+    // earlier batch of rows; both must use the same histogram buckets
+    void merge(const PriceSketch& other) {
+        addBatch(other.pending, other.pendingCount);
+        histogram.merge(other.histogram);
+        digest.merge(other.digest);
+    }
+
+    double quantile(double q) {
+        flush();
+        return digest.quantile(q);
+    }
+
+    double count() const { return digest.count() + pendingCount; }
+    double min() { flush(); return digest.min(); }
+    double max() { flush(); return digest.max(); }
+    const PriceHistogram& getHistogram() { flush(); return histogram; }
+};
+
+// Group names as hash map keys; arena-backed names are copied into a reused buffer
+inline const std::string& priceGroupKey(const std::string& name, std::string&) {
+    return name;
+}
+
+inline const std::string& priceGroupKey(const StringRef& name, std::string& buffer) {
+    buffer.assign(name.data, name.length);
+    return buffer;
+}
+
+// One PriceSketch per distinct value of a grouping column, in first-seen order
+class GroupedPriceSketches {
+private:
+    HashMap<std::string, int> groupIds;
+    Array<std::string> groupNames;
+    Array<PriceSketch> sketches;
+
+    PriceSketch& sketchFor(const std::string& name) {
+        int& id = groupIds.getOrInsert(name, -1);
+        if (id < 0) {
+            id = groupNames.getSize();
+            groupNames.push_back(name);
+            sketches.push_back(PriceSketch());
+        }
+        return sketches[id];
+    }
+
+public:
+    void add(const std::string& group, double price) {
+        sketchFor(group).add(price);
+    }
+
+    void merge(const GroupedPriceSketches& other) {
+        for (int g = 0; g < other.groupNames.getSize(); g++) {
+            sketchFor(other.groupNames[g]).merge(other.sketches[g]);
+        }
+    }
+
+    int getGroupCount() const { return groupNames.getSize(); }
+    const std::string& groupAt(int group) const { return groupNames[group]; }
+    PriceSketch& sketchAt(int group) { return sketches[group]; }
+
+    // Sketch of one group, or nullptr if it has no prices
+    PriceSketch* find(const std::string& group) {
+        const int* id = groupIds.find(group);
+        return id ? &sketches[*id] : nullptr;
+    }
+};
+
+// Price sketches per category and per payment method, filled one
+// transaction at a time during ingest
+class PriceStatistics {
+private:
+    GroupedPriceSketches categories;
+    GroupedPriceSketches paymentMethods;
+    std::string buffer;
+
+public:
+    template <typename T>
+    void add(const T& transaction) {
+        categories.add(priceGroupKey(transaction.category, buffer), transaction.price);
+        paymentMethods.add(priceGroupKey(transaction.paymentMethod, buffer), transaction.price);
+    }
+
+    // Fold in statistics of another thread or batch
+    void merge(const PriceStatistics& other) {
+        categories.merge(other.categories);
+        paymentMethods.merge(other.paymentMethods);
+    }
+
+    GroupedPriceSketches& byCategory() { return categories; }
+    GroupedPriceSketches& byPaymentMethod() { return paymentMethods; }
+};
+
+#endif
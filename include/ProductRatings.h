@@ -0,0 +1,172 @@
+#ifndef PRODUCT_RATINGS_H
+#define PRODUCT_RATINGS_H
+
+#include <string>
+#include <utility>
+#include "Array.h"
+#include "HashMap.h"
+#include "DataStructures.h"
+
+// Product IDs as hash map keys; arena-backed IDs are copied into a reused buffer
+inline const std::string& productKey(const std::string& id, std::string&) {
+    return id;
+}
+
+inline const std::string& productKey(const StringRef& id, std::string& buffer) {
+    buffer.assign(id.data, id.length);
+    return buffer;
+}
+
+// Rating statistics of one product
+struct ProductRating {
+    std::string productId;
+    int count;
+    int histogram[5];       // Reviews per rating, 1-star first
+    long long ratingSum;
+    double score;           // Bayesian average, set by ProductRatingTable::finish
+
+    ProductRating(const std::string& id = "") : productId(id), count(0), ratingSum(0), score(0) {
+        for (int r = 0; r < 5; r++) histogram[r] = 0;
+    }
+
+    double mean() const { return count > 0 ? static_cast<double>(ratingSum) / count : 0; }
+};
+
+// Ranking order for top-K lists: lower score first, then more reviews (more
+// certainly bad), then product ID so equal products always rank the same way
+inline bool ranksWorse(const ProductRating& a, const ProductRating& b) {
+    if (a.score != b.score) return a.score < b.score;
+    if (a.count != b.count) return a.count > b.count;
+    return a.productId < b.productId;
+}
+
+inline bool ranksBetter(const ProductRating& a, const ProductRating& b) {
+    if (a.score != b.score) return a.score > b.score;
+    if (a.count != b.count) return a.count > b.count;
+    return a.productId < b.productId;
+}
+
+// Per-product rating aggregates from one hash-aggregation pass over the
+// reviews. Raw means overrate products with one or two reviews, so products
+// are ranked by a Bayesian average that blends each product's ratings with
+// priorWeight pseudo-reviews at the global mean:
+//     score = (priorWeight * globalMean + ratingSum) / (priorWeight + count)
+// priorWeight defaults to the average number of reviews per product.
+class ProductRatingTable {
+private:
+    HashMap<std::string, int> productIds;   // Product ID -> index in products
+    Array<ProductRating> products;
+    long long totalReviews;
+    long long totalRatingSum;
+    double priorWeight;
+
+    // The k products ranked first by precedes, in rank order. A
+    // bounded heap keeps the k best seen so far with the weakest at the
+    // root, so a pass costs O(n log k) instead of sorting all products.
+    Array<ProductRating> topK(int k, bool (*precedes)(const ProductRating&, const ProductRating&)) const {
+        int n = products.getSize();
+        if (k > n) k = n;
+        Array<int> heap(k > 0 ? k : 1);
+        for (int i = 0; i < n; i++) {
+            if (heap.getSize() < k) {
+                // Sift up: a parent must rank after its children
+                heap.push_back(i);
+                int child = heap.getSize() - 1;
+                while (child > 0) {
+                    int parent = (child - 1) / 2;
+                    if (!precedes(products[heap[parent]], products[heap[child]])) break;
+                    std::swap(heap[parent], heap[child]);
+                    child = parent;
+                }
+            } else if (k > 0 && precedes(products[i], products[heap[0]])) {
+                heap[0] = i;
+                siftDown(heap, heap.getSize(), precedes);
+            }
+        }
+
+        // Pop the weakest repeatedly to fill the result from the back
+        Array<ProductRating> result(k > 0 ? k : 1);
+        for (int i = 0; i < heap.getSize(); i++) result.push_back(ProductRating());
+        for (int size = heap.getSize(); size > 0; size--) {
+            result[size - 1] = products[heap[0]];
+            heap[0] = heap[size - 1];
+            siftDown(heap, size - 1, precedes);
+        }
+        return result;
+    }
+
+    void siftDown(Array<int>& heap, int size, bool (*precedes)(const ProductRating&, const ProductRating&)) const {
+        int parent = 0;
+        while (true) {
+            int weakest = parent;
+            int left = 2 * parent + 1;
+            int right = left + 1;
+            if (left < size && precedes(products[heap[weakest]], products[heap[left]])) weakest = left;
+            if (right < size && precedes(products[heap[weakest]], products[heap[right]])) weakest = right;
+            if (weakest == parent) return;
+            std::swap(heap[parent], heap[weakest]);
+            parent = weakest;
+        }
+    }
+
+public:
+    ProductRatingTable() : totalReviews(0), totalRatingSum(0), priorWeight(0) {}
+
+    // Aggregate the reviews (owned or arena-backed) and compute the scores.
+    // Reviews without a product ID or with a rating outside 1-5 are skipped.
+    // A priorWeight below zero means the average reviews per product.
+    template <typename R>
+    void build(const Array<R>& reviews, double weight = -1) {
+        productIds.clear();
+        products = Array<ProductRating>();
+        totalReviews = 0;
+        totalRatingSum = 0;
+        std::string buffer;
+        for (int i = 0; i < reviews.getSize(); i++) {
+            const R& review = reviews[i];
+            const std::string& key = productKey(review.productId, buffer);
+            if (key.empty() || review.rating < 1 || review.rating > 5) continue;
+            int& index = productIds.getOrInsert(key, -1);
+            if (index < 0) {
+                index = products.getSize();
+                products.push_back(ProductRating(key));
+            }
+            ProductRating& product = products[index];
+            product.count++;
+            product.histogram[review.rating - 1]++;
+            product.ratingSum += review.rating;
+            totalReviews++;
+            totalRatingSum += review.rating;
+        }
+        finish(weight);
+    }
+
+    // Recompute the scores with a different prior weight
+    void finish(double weight = -1) {
+        int n = products.getSize();
+        priorWeight = weight >= 0 ? weight : (n > 0 ? static_cast<double>(totalReviews) / n : 0);
+        double prior = priorWeight * globalMean();
+        for (int i = 0; i < n; i++) {
+            ProductRating& product = products[i];
+            product.score = (prior + product.ratingSum) / (priorWeight + product.count);
+        }
+    }
+
+    // Statistics of one product, or nullptr if it has no reviews
+    const ProductRating* find(const std::string& productId) const {
+        const int* index = productIds.find(productId);
+        return index ? &products[*index] : nullptr;
+    }
+
+    // The k lowest and highest scoring products, in rank order
+    Array<ProductRating> worst(int k) const { return topK(k, ranksWorse); }
+    Array<ProductRating> best(int k) const { return topK(k, ranksBetter); }
+
+    double globalMean() const { return totalReviews > 0 ? static_cast<double>(totalRatingSum) / totalReviews : 0; }
+    double getPriorWeight() const { return priorWeight; }
+    long long getReviewCount() const { return totalReviews; }
+    int getProductCount() const { return products.getSize(); }
+    const Array<ProductRating>& getProducts() const { return products; }
+};
+
+#endif
@@ -0,0 +1,833 @@
+#ifndef QUERY_LANGUAGE_H
+#define QUERY_LANGUAGE_H
+
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <limits>
+#include "Array.h"
+#include "HashMap.h"
+#include "LinkedList.h"
+#include "DataStructures.h"
+#include "Metrics.h"
+
+// Small query language over the transaction and review records:
+//   SELECT <items> FROM transactions|reviews
+//     [WHERE <column> <op> <value> [AND ...]] [GROUP BY <column>]
+//     [ORDER BY <item> [ASC|DESC]] [LIMIT <n>]
+// Items are *, column names, or COUNT(*), SUM(col), AVG(col), MIN(col) and
+// MAX(col). Operators are = != < <= > >=. Keywords and column names are case
+// insensitive; values containing spaces or commas go in double quotes. Dates
+// (DD/MM/YYYY) compare in calendar order.
+//
+// A query compiles to typed predicate and aggregate tables holding member
+// pointers into the record, so the scan is one pass of plain loads and
+// compares with no per-row dispatch or string building.
+
+enum class ColumnType { Text, Date, Real, Integer };
+enum class CompareOp { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+enum class AggregateFunction { Count, Sum, Average, Min, Max };
+
+// Text fields are std::string in owned records and StringRef in arena-backed ones
+inline int textLength(const std::string& text) { return static_cast<int>(text.size()); }
+inline int textLength(const StringRef& text) { return text.length; }
+inline const char* textData(const std::string& text) { return text.data(); }
+inline const char* textData(const StringRef& text) { return text.data; }
+
+// Text as a hash map key; arena-backed text is copied into a reused buffer
+inline const std::string& textKey(const std::string& text, std::string&) {
+    return text;
+}
+
+inline const std::string& textKey(const StringRef& text, std::string& buffer) {
+    buffer.assign(text.data, text.length);
+    return buffer;
+}
+
+template <typename A, typename B>
+int compareText(const A& a, const B& b) {
+    int aLength = textLength(a), bLength = textLength(b);
+    int result = std::memcmp(textData(a), textData(b), std::min(aLength, bLength));
+    return result != 0 ? result : aLength - bLength;
+}
+
+template <typename V>
+bool compareValues(CompareOp op, V a, V b) {
+    switch (op) {
+        case CompareOp::Equal: return a == b;
+        case CompareOp::NotEqual: return a != b;
+        case CompareOp::Less: return a < b;
+        case CompareOp::LessEqual: return a <= b;
+        case CompareOp::Greater: return a > b;
+        case CompareOp::GreaterEqual: return a >= b;
+    }
+    return false;
+}
+
+// One column of a record type: its name, type and the member that holds it
+template <typename T, typename S>
+struct ColumnBinding {
+    const char* name;
+    ColumnType type;
+    S T::* text;            // Text and Date columns
+    double T::* real;       // Real columns
+    int T::* integer;       // Integer columns
+};
+
+template <typename T>
+struct RecordSchema;
+
+// Transaction and TransactionRef differ only in their string type
+template <typename T, typename S>
+struct TransactionSchema {
+    typedef S Text;
+
+    static const char* table() { return "transactions"; }
+
+    static int columns(const ColumnBinding<T, S>*& list) {
+        static const ColumnBinding<T, S> bindings[] = {
+            {"customerId", ColumnType::Text, &T::customerId, nullptr, nullptr},
+            {"product", ColumnType::Text, &T::product, nullptr, nullptr},
+            {"category", ColumnType::Text, &T::category, nullptr, nullptr},
+            {"price", ColumnType::Real, nullptr, &T::price, nullptr},
+            {"date", ColumnType::Date, &T::date, nullptr, nullptr},
+            {"paymentMethod", ColumnType::Text, &T::paymentMethod, nullptr, nullptr},
+        };
+        list = bindings;
+        return 6;
+    }
+};
+
+template <typename T, typename S>
+struct ReviewSchema {
+    typedef S Text;
+
+    static const char* table() { return "reviews"; }
+
+    static int columns(const ColumnBinding<T, S>*& list) {
+        static const ColumnBinding<T, S> bindings[] = {
+            {"productId", ColumnType::Text, &T::productId, nullptr, nullptr},
+            {"customerId", ColumnType::Text, &T::customerId, nullptr, nullptr},
+            {"rating", ColumnType::Integer, nullptr, nullptr, &T::rating},
+            {"reviewText", ColumnType::Text, &T::reviewText, nullptr, nullptr},
+        };
+        list = bindings;
+        return 4;
+    }
+};
+
+template <> struct RecordSchema<Transaction> : TransactionSchema<Transaction, std::string> {};
+template <> struct RecordSchema<TransactionRef> : TransactionSchema<TransactionRef, StringRef> {};
+template <> struct RecordSchema<Review> : ReviewSchema<Review, std::string> {};
+template <> struct RecordSchema<ReviewRef> : ReviewSchema<ReviewRef, StringRef> {};
+
+// Compiled WHERE terms, one table per column type
+template <typename T, typename V>
+struct NumberPredicate {
+    V T::* field;
+    CompareOp op;
+    V value;
+};
+
+template <typename T, typename S>
+struct TextPredicate {
+    S T::* field;
+    CompareOp op;
+    std::string value;
+};
+
+template <typename T, typename S>
+struct DatePredicate {
+    S T::* field;
+    CompareOp op;
+    int key;                // calendarDateKey of the literal
+};
+
+template <typename T>
+struct AggregateSpec {
+    AggregateFunction function;
+    double T::* real;       // Exactly one of these is set, except for COUNT
+    int T::* integer;
+};
+
+// One SELECT item, after resolving it against the schema
+struct SelectItem {
+    std::string label;
+    int column;             // Schema column, or -1
+    int aggregate;          // Index into the aggregate table, or -1
+
+    SelectItem(const std::string& l = "", int c = -1, int a = -1) : label(l), column(c), aggregate(a) {}
+};
+
+struct QueryResult {
+    std::string header;
+    Array<std::string> rows;    // Values separated by ", "
+};
+
+// Tokens of a query: words, quoted values, operators and , ( ) *
+struct QueryToken {
+    std::string text;
+    bool quoted;
+
+    QueryToken(const std::string& t = "", bool q = false) : text(t), quoted(q) {}
+};
+
+inline std::string lowerCase(const std::string& text) {
+    std::string result = text;
+    for (size_t i = 0; i < result.size(); i++) {
+        result[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(result[i])));
+    }
+    return result;
+}
+
+inline bool tokenizeQuery(const std::string& text, Array<QueryToken>& tokens, std::string& error) {
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            i++;
+        } else if (c == '"') {
+            size_t close = text.find('"', i + 1);
+            if (close == std::string::npos) {
+                error = "unterminated quoted value";
+                return false;
+            }
+            tokens.push_back(QueryToken(text.substr(i + 1, close - i - 1), true));
+            i = close + 1;
+        } else if (c == ',' || c == '(' || c == ')' || c == '*') {
+            tokens.push_back(QueryToken(std::string(1, c)));
+            i++;
+        } else if (c == '=' || c == '!' || c == '<' || c == '>') {
+            size_t length = i + 1 < text.size() && (text[i + 1] == '=' || (c == '<' && text[i + 1] == '>')) ? 2 : 1;
+            tokens.push_back(QueryToken(text.substr(i, length)));
+            i += length;
+        } else {
+            size_t start = i;
+            while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])) &&
+                   std::strchr(",()*=!<>\"", text[i]) == nullptr) {
+                i++;
+            }
+            tokens.push_back(QueryToken(text.substr(start, i - start)));
+        }
+    }
+    return true;
+}
+
+inline bool parseCompareOp(const std::string& text, CompareOp& op) {
+    if (text == "=") op = CompareOp::Equal;
+    else if (text == "!=" || text == "<>") op = CompareOp::NotEqual;
+    else if (text == "<") op = CompareOp::Less;
+    else if (text == "<=") op = CompareOp::LessEqual;
+    else if (text == ">") op = CompareOp::Greater;
+    else if (text == ">=") op = CompareOp::GreaterEqual;
+    else return false;
+    return true;
+}
+
+// Table named after FROM, lower-cased ("" if there is none)
+inline std::string queryTable(const std::string& text) {
+    Array<QueryToken> tokens;
+    std::string error;
+    if (!tokenizeQuery(text, tokens, error)) return "";
+    for (int i = 0; i + 1 < tokens.getSize(); i++) {
+        if (!tokens[i].quoted && lowerCase(tokens[i].text) == "from") {
+            return lowerCase(tokens[i + 1].text);
+        }
+    }
+    return "";
+}
+
+// Stable bottom-up merge sort; compare returns <0, 0 or >0
+template <typename E, typename Compare>
+void stableSortBy(Array<E>& items, Compare compare) {
+    int n = items.getSize();
+    if (n < 2) return;
+    E* data = items.getData();
+    E* buffer = new E[n];
+    for (int width = 1; width < n; width *= 2) {
+        for (int low = 0; low < n; low += 2 * width) {
+            int mid = std::min(low + width, n);
+            int high = std::min(low + 2 * width, n);
+            int i = low, j = mid, k = low;
+            while (i < mid && j < high) {
+                buffer[k++] = compare(data[j], data[i]) < 0 ? data[j++] : data[i++];
+            }
+            while (i < mid) buffer[k++] = data[i++];
+            while (j < high) buffer[k++] = data[j++];
+        }
+        for (int i = 0; i < n; i++) {
+            data[i] = buffer[i];
+        }
+    }
+    delete[] buffer;
+}
+
+// Row iteration over either container; onRow returns false to stop early
+template <typename T, typename Callback>
+void forEachRow(const Array<T>& rows, Callback onRow) {
+    const T* data = rows.getData();
+    for (int i = 0; i < rows.getSize(); i++) {
+        if (!onRow(data[i])) return;
+    }
+}
+
+template <typename T, typename Callback>
+void forEachRow(const LinkedList<T>& rows, Callback onRow) {
+    for (Node<T>* node = rows.begin(); node; node = node->next) {
+        if (!onRow(node->data)) return;
+    }
+}
+
+template <typename T>
+class CompiledQuery {
+public:
+    typedef typename RecordSchema<T>::Text Text;
+    typedef ColumnBinding<T, Text> Column;
+
+private:
+    const Column* columns;
+    int columnCount;
+
+    Array<NumberPredicate<T, int> > integerFilters;
+    Array<NumberPredicate<T, double> > realFilters;
+    Array<DatePredicate<T, Text> > dateFilters;
+    Array<TextPredicate<T, Text> > textFilters;
+
+    Array<AggregateSpec<T> > aggregates;
+    Array<SelectItem> items;
+    int groupColumn;        // -1 without GROUP BY
+    bool grouped;           // GROUP BY or any aggregate: one output row per group
+    int orderItem;          // Grouped: index into items, or -1
+    int orderColumn;        // Row listing: schema column, or -1
+    bool descending;
+    int limit;              // -1 for no limit
+
+    int findColumn(const std::string& name) const {
+        std::string wanted = lowerCase(name);
+        for (int c = 0; c < columnCount; c++) {
+            if (lowerCase(columns[c].name) == wanted) return c;
+        }
+        return -1;
+    }
+
+    bool isNumeric(int column) const {
+        return columns[column].type == ColumnType::Real || columns[column].type == ColumnType::Integer;
+    }
+
+    // item := * | column | COUNT | function ( * | column ). An aggregate comes back
+    // with item.aggregate == -2 and its spec filled in, ready for addAggregate.
+    bool parseItem(const Array<QueryToken>& tokens, int& pos, SelectItem& item,
+                   AggregateSpec<T>& spec, std::string& error) {
+        if (pos >= tokens.getSize()) {
+            error = "expected a select item";
+            return false;
+        }
+        const QueryToken& first = tokens[pos++];
+        if (first.text == "*" && !first.quoted) {
+            item = SelectItem("*");
+            return true;
+        }
+        if (pos < tokens.getSize() && tokens[pos].text == "(" && !tokens[pos].quoted) {
+            std::string function = lowerCase(first.text);
+            AggregateFunction kind;
+            if (function == "count") kind = AggregateFunction::Count;
+            else if (function == "sum") kind = AggregateFunction::Sum;
+            else if (function == "avg") kind = AggregateFunction::Average;
+            else if (function == "min") kind = AggregateFunction::Min;
+            else if (function == "max") kind = AggregateFunction::Max;
+            else {
+                error = "unknown function " + first.text;
+                return false;
+            }
+            if (pos + 2 >= tokens.getSize() || tokens[pos + 2].text != ")") {
+                error = "expected " + function + "(column)";
+                return false;
+            }
+            std::string argument = tokens[pos + 1].text;
+            pos += 3;
+            int column = -1;
+            if (argument != "*") {
+                column = findColumn(argument);
+                if (column < 0) {
+                    error = "unknown column " + argument;
+                    return false;
+                }
+            }
+            spec.function = kind;
+            spec.real = nullptr;
+            spec.integer = nullptr;
+            if (kind == AggregateFunction::Count) {
+                // No NULLs in these records, so COUNT(column) counts rows too
+                item = SelectItem("count", -1, -2);
+                return true;
+            }
+            if (column < 0 || !isNumeric(column)) {
+                error = function + " needs a numeric column";
+                return false;
+            }
+            spec.real = columns[column].real;
+            spec.integer = columns[column].integer;
+            item = SelectItem(function + "(" + columns[column].name + ")", column, -2);
+            return true;
+        }
+        int column = findColumn(first.text);
+        if (column < 0 && lowerCase(first.text) == "count") {
+            // Bare COUNT, as in the label ORDER BY refers to
+            spec.function = AggregateFunction::Count;
+            spec.real = nullptr;
+            spec.integer = nullptr;
+            item = SelectItem("count", -1, -2);
+            return true;
+        }
+        if (column < 0) {
+            error = "unknown column " + first.text;
+            return false;
+        }
+        item = SelectItem(columns[column].name, column, -1);
+        return true;
+    }
+
+    // Slot of an aggregate in the table; repeated items share one slot
+    int addAggregate(const SelectItem& item, const AggregateSpec<T>& spec) {
+        for (int i = 0; i < items.getSize(); i++) {
+            if (items[i].aggregate >= 0 && items[i].label == item.label) return items[i].aggregate;
+        }
+        aggregates.push_back(spec);
+        return aggregates.getSize() - 1;
+    }
+
+    bool addPredicate(int column, CompareOp op, const QueryToken& value, std::string& error) {
+        const Column& binding = columns[column];
+        if (binding.type == ColumnType::Text) {
+            TextPredicate<T, Text> predicate = {binding.text, op, value.text};
+            textFilters.push_back(predicate);
+            return true;
+        }
+        if (binding.type == ColumnType::Date) {
+            if (value.text.size() != 10) {
+                error = "expected a date like 31/01/2023 for " + std::string(binding.name);
+                return false;
+            }
+            DatePredicate<T, Text> predicate = {binding.text, op, calendarDateKey(value.text)};
+            dateFilters.push_back(predicate);
+            return true;
+        }
+        char* end = nullptr;
+        double number = std::strtod(value.text.c_str(), &end);
+        if (value.text.empty() || *end != '\0') {
+            error = "expected a number for " + std::string(binding.name);
+            return false;
+        }
+        if (binding.type == ColumnType::Real) {
+            NumberPredicate<T, double> predicate = {binding.real, op, number};
+            realFilters.push_back(predicate);
+        } else {
+            if (number != static_cast<int>(number)) {
+                error = "expected a whole number for " + std::string(binding.name);
+                return false;
+            }
+            NumberPredicate<T, int> predicate = {binding.integer, op, static_cast<int>(number)};
+            integerFilters.push_back(predicate);
+        }
+        return true;
+    }
+
+    static bool isKeyword(const Array<QueryToken>& tokens, int pos, const char* keyword) {
+        return pos < tokens.getSize() && !tokens[pos].quoted && lowerCase(tokens[pos].text) == keyword;
+    }
+
+    // Ordering of two rows on one column
+    int compareColumn(const T& a, const T& b, int column) const {
+        const Column& binding = columns[column];
+        switch (binding.type) {
+            case ColumnType::Text: return compareText(a.*binding.text, b.*binding.text);
+            case ColumnType::Date: return calendarDateKey(a.*binding.text) - calendarDateKey(b.*binding.text);
+            case ColumnType::Real: return a.*binding.real < b.*binding.real ? -1 : (b.*binding.real < a.*binding.real ? 1 : 0);
+            case ColumnType::Integer: return a.*binding.integer - b.*binding.integer;
+        }
+        return 0;
+    }
+
+    void formatColumn(std::ostream& out, const T& row, int column) const {
+        const Column& binding = columns[column];
+        switch (binding.type) {
+            case ColumnType::Text:
+            case ColumnType::Date: out.write(textData(row.*binding.text), textLength(row.*binding.text)); break;
+            case ColumnType::Real: out << row.*binding.real; break;
+            case ColumnType::Integer: out << row.*binding.integer; break;
+        }
+    }
+
+    QueryResult listRows(Array<const T*>& matched) const {
+        if (orderColumn >= 0) {
+            int column = orderColumn;
+            int sign = descending ? -1 : 1;
+            stableSortBy(matched, [this, column, sign](const T* a, const T* b) {
+                return sign * compareColumn(*a, *b, column);
+            });
+        }
+
+        QueryResult result;
+        Array<int> shown;
+        for (int i = 0; i < items.getSize(); i++) {
+            if (items[i].label != "*") {
+                shown.push_back(items[i].column);
+                continue;
+            }
+            for (int c = 0; c < columnCount; c++) {
+                shown.push_back(c);
+            }
+        }
+        for (int i = 0; i < shown.getSize(); i++) {
+            result.header += (i > 0 ? ", " : "") + std::string(columns[shown[i]].name);
+        }
+
+        int count = limit >= 0 ? std::min(limit, matched.getSize()) : matched.getSize();
+        for (int r = 0; r < count; r++) {
+            std::ostringstream line;
+            for (int i = 0; i < shown.getSize(); i++) {
+                if (i > 0) line << ", ";
+                formatColumn(line, *matched[r], shown[i]);
+            }
+            result.rows.push_back(line.str());
+        }
+        return result;
+    }
+
+public:
+    CompiledQuery()
+        : columnCount(0), groupColumn(-1), grouped(false), orderItem(-1), orderColumn(-1),
+          descending(false), limit(-1) {
+        columnCount = RecordSchema<T>::columns(columns);
+    }
+
+    // Parse and bind a query (once per object); false with a message if it is
+    // malformed or names another table
+    bool compile(const std::string& text, std::string& error) {
+        Array<QueryToken> tokens;
+        if (!tokenizeQuery(text, tokens, error)) return false;
+        int pos = 0;
+
+        if (!isKeyword(tokens, pos++, "select")) {
+            error = "query must start with SELECT";
+            return false;
+        }
+        while (true) {
+            SelectItem item;
+            AggregateSpec<T> spec;
+            if (!parseItem(tokens, pos, item, spec, error)) return false;
+            if (item.aggregate == -2) item.aggregate = addAggregate(item, spec);
+            items.push_back(item);
+            if (pos < tokens.getSize() && tokens[pos].text == "," && !tokens[pos].quoted) {
+                pos++;
+                continue;
+            }
+            break;
+        }
+
+        if (!isKeyword(tokens, pos++, "from") || pos >= tokens.getSize()) {
+            error = "expected FROM <table>";
+            return false;
+        }
+        if (lowerCase(tokens[pos].text) != RecordSchema<T>::table()) {
+            error = "unknown table " + tokens[pos].text;
+            return false;
+        }
+        pos++;
+
+        if (isKeyword(tokens, pos, "where")) {
+            pos++;
+            while (true) {
+                if (pos + 2 >= tokens.getSize()) {
+                    error = "expected <column> <op> <value> after WHERE";
+                    return false;
+                }
+                int column = findColumn(tokens[pos].text);
+                if (column < 0) {
+                    error = "unknown column " + tokens[pos].text;
+                    return false;
+                }
+                CompareOp op;
+                if (!parseCompareOp(tokens[pos + 1].text, op)) {
+                    error = "unknown operator " + tokens[pos + 1].text;
+                    return false;
+                }
+                if (!addPredicate(column, op, tokens[pos + 2], error)) return false;
+                pos += 3;
+                if (!isKeyword(tokens, pos, "and")) break;
+                pos++;
+            }
+        }
+
+        if (isKeyword(tokens, pos, "group")) {
+            if (!isKeyword(tokens, pos + 1, "by") || pos + 2 >= tokens.getSize()) {
+                error = "expected GROUP BY <column>";
+                return false;
+            }
+            groupColumn = findColumn(tokens[pos + 2].text);
+            if (groupColumn < 0) {
+                error = "unknown column " + tokens[pos + 2].text;
+                return false;
+            }
+            if (columns[groupColumn].type == ColumnType::Real) {
+                error = "cannot group by " + std::string(columns[groupColumn].name);
+                return false;
+            }
+            pos += 3;
+        }
+
+        grouped = groupColumn >= 0 || aggregates.getSize() > 0;
+        for (int i = 0; i < items.getSize(); i++) {
+            if (items[i].label == "*" && (grouped || items.getSize() > 1)) {
+                error = "* must be the only item and cannot be aggregated";
+                return false;
+            }
+            if (grouped && items[i].aggregate < 0 && items[i].column != groupColumn) {
+                error = std::string("column ") + items[i].label +
+                        (groupColumn >= 0 ? " is not the GROUP BY column" : " needs GROUP BY");
+                return false;
+            }
+        }
+
+        if (isKeyword(tokens, pos, "order")) {
+            if (!isKeyword(tokens, pos + 1, "by")) {
+                error = "expected ORDER BY <item>";
+                return false;
+            }
+            pos += 2;
+            SelectItem key;
+            AggregateSpec<T> spec;
+            if (!parseItem(tokens, pos, key, spec, error)) return false;
+            if (grouped) {
+                for (int i = 0; i < items.getSize() && orderItem < 0; i++) {
+                    if (items[i].label == key.label) orderItem = i;
+                }
+                if (orderItem < 0) {
+                    error = "ORDER BY " + key.label + " is not a selected item";
+                    return false;
+                }
+            } else {
+                if (key.aggregate != -1 || key.column < 0) {
+                    error = "ORDER BY needs a column";
+                    return false;
+                }
+                orderColumn = key.column;
+            }
+            if (isKeyword(tokens, pos, "desc")) {
+                descending = true;
+                pos++;
+            } else if (isKeyword(tokens, pos, "asc")) {
+                pos++;
+            }
+        }
+
+        if (isKeyword(tokens, pos, "limit")) {
+            if (pos + 1 >= tokens.getSize()) {
+                error = "expected LIMIT <n>";
+                return false;
+            }
+            char* end = nullptr;
+            long value = std::strtol(tokens[pos + 1].text.c_str(), &end, 10);
+            if (*end != '\0' || value < 0) {
+                error = "expected LIMIT <n>";
+                return false;
+            }
+            limit = static_cast<int>(value);
+            pos += 2;
+        }
+
+        if (pos < tokens.getSize()) {
+            error = "unexpected " + tokens[pos].text;
+            return false;
+        }
+        return true;
+    }
+
+    // All WHERE terms, cheapest first
+    bool matches(const T& row) const {
+        const NumberPredicate<T, int>* integers = integerFilters.getData();
+        for (int i = 0; i < integerFilters.getSize(); i++) {
+            if (!compareValues(integers[i].op, row.*integers[i].field, integers[i].value)) return false;
+        }
+        const NumberPredicate<T, double>* reals = realFilters.getData();
+        for (int i = 0; i < realFilters.getSize(); i++) {
+            if (!compareValues(reals[i].op, row.*reals[i].field, reals[i].value)) return false;
+        }
+        const DatePredicate<T, Text>* dates = dateFilters.getData();
+        for (int i = 0; i < dateFilters.getSize(); i++) {
+            if (!compareValues(dates[i].op, calendarDateKey(row.*dates[i].field), dates[i].key)) return false;
+        }
+        const TextPredicate<T, Text>* texts = textFilters.getData();
+        for (int i = 0; i < textFilters.getSize(); i++) {
+            const Text& field = row.*texts[i].field;
+            if (texts[i].op == CompareOp::Equal || texts[i].op == CompareOp::NotEqual) {
+                // Length check first: most mismatches never touch the bytes
+                bool equal = textLength(field) == static_cast<int>(texts[i].value.size()) &&
+                             std::memcmp(textData(field), texts[i].value.data(), texts[i].value.size()) == 0;
+                if (equal != (texts[i].op == CompareOp::Equal)) return false;
+            } else if (!compareValues(texts[i].op, compareText(field, texts[i].value), 0)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Run the query in a single pass over rows (an Array or a LinkedList)
+    template <typename Rows>
+    QueryResult run(const Rows& rows) const {
+        ScopedTimer timer("query.run");
+
+        if (!grouped) {
+            // Without ORDER BY the scan can stop as soon as LIMIT rows matched
+            Array<const T*> matched;
+            bool stopAtLimit = orderColumn < 0 && limit >= 0;
+            if (!stopAtLimit || limit > 0) {
+                forEachRow(rows, [this, &matched, stopAtLimit](const T& row) {
+                    if (matches(row)) matched.push_back(&row);
+                    return !stopAtLimit || matched.getSize() < limit;
+                });
+            }
+            return listRows(matched);
+        }
+
+        // One accumulator slot per aggregate and group, plus a row count per group
+        int aggregateCount = aggregates.getSize();
+        const AggregateSpec<T>* specs = aggregates.getData();
+        Array<long long> counts;
+        Array<double> accumulators;
+        Array<std::string> groupLabels;
+        Array<int> groupSortKeys;           // Date and integer groups order numerically
+        HashMap<std::string, int> textGroups;
+        HashMap<int, int> integerGroups;
+        std::string keyBuffer;
+
+        auto addGroup = [&](const std::string& label, int sortKey) {
+            counts.push_back(0);
+            for (int a = 0; a < aggregateCount; a++) {
+                double start = 0;
+                if (specs[a].function == AggregateFunction::Min) start = std::numeric_limits<double>::infinity();
+                if (specs[a].function == AggregateFunction::Max) start = -std::numeric_limits<double>::infinity();
+                accumulators.push_back(start);
+            }
+            groupLabels.push_back(label);
+            groupSortKeys.push_back(sortKey);
+            return counts.getSize() - 1;
+        };
+        if (groupColumn < 0) addGroup("", 0);
+        const Column* group = groupColumn >= 0 ? &columns[groupColumn] : nullptr;
+
+        forEachRow(rows, [&](const T& row) {
+            if (!matches(row)) return true;
+            int slot = 0;
+            if (group && group->type == ColumnType::Integer) {
+                int value = row.*group->integer;
+                int& id = integerGroups.getOrInsert(value, -1);
+                if (id < 0) id = addGroup(std::to_string(value), value);
+                slot = id;
+            } else if (group) {
+                const std::string& key = textKey(row.*group->text, keyBuffer);
+                int& id = textGroups.getOrInsert(key, -1);
+                if (id < 0) id = addGroup(key, group->type == ColumnType::Date ? calendarDateKey(key) : 0);
+                slot = id;
+            }
+
+            counts.getData()[slot]++;
+            double* accumulator = accumulators.getData() + static_cast<long long>(slot) * aggregateCount;
+            for (int a = 0; a < aggregateCount; a++) {
+                if (specs[a].function == AggregateFunction::Count) continue;
+                double value = specs[a].real ? row.*specs[a].real : row.*specs[a].integer;
+                switch (specs[a].function) {
+                    case AggregateFunction::Min: accumulator[a] = std::min(accumulator[a], value); break;
+                    case AggregateFunction::Max: accumulator[a] = std::max(accumulator[a], value); break;
+                    default: accumulator[a] += value; break;
+                }
+            }
+            return true;
+        });
+
+        // Final aggregate values, then the group order
+        int groupCount = counts.getSize();
+        Array<double> values(groupCount * aggregateCount + 1);
+        for (int g = 0; g < groupCount; g++) {
+            for (int a = 0; a < aggregateCount; a++) {
+                double value = accumulators[g * aggregateCount + a];
+                if (specs[a].function == AggregateFunction::Count) value = static_cast<double>(counts[g]);
+                if (specs[a].function == AggregateFunction::Average) value = counts[g] > 0 ? value / counts[g] : 0;
+                values.push_back(value);
+            }
+        }
+
+        Array<int> order(groupCount > 0 ? groupCount : 1);
+        for (int g = 0; g < groupCount; g++) {
+            order.push_back(g);
+        }
+        if (orderItem >= 0) {
+            const SelectItem& key = items[orderItem];
+            int sign = descending ? -1 : 1;
+            bool byLabel = key.aggregate < 0;
+            bool labelIsText = byLabel && group && group->type == ColumnType::Text;
+            stableSortBy(order, [&](int a, int b) {
+                if (labelIsText) return sign * groupLabels[a].compare(groupLabels[b]);
+                if (byLabel) return sign * (groupSortKeys[a] < groupSortKeys[b] ? -1 : (groupSortKeys[b] < groupSortKeys[a] ? 1 : 0));
+                double x = values[a * aggregateCount + key.aggregate];
+                double y = values[b * aggregateCount + key.aggregate];
+                return sign * (x < y ? -1 : (y < x ? 1 : 0));
+            });
+        }
+
+        QueryResult result;
+        for (int i = 0; i < items.getSize(); i++) {
+            result.header += (i > 0 ? ", " : "") + items[i].label;
+        }
+        int shown = limit >= 0 ? std::min(limit, groupCount) : groupCount;
+        for (int r = 0; r < shown; r++) {
+            int g = order[r];
+            std::ostringstream line;
+            for (int i = 0; i < items.getSize(); i++) {
+                if (i > 0) line << ", ";
+                const SelectItem& item = items[i];
+                if (item.aggregate < 0) {
+                    line << groupLabels[g];
+                    continue;
+                }
+                const AggregateSpec<T>& spec = specs[item.aggregate];
+                double value = values[g * aggregateCount + item.aggregate];
+                if (spec.function == AggregateFunction::Count) {
+                    line << counts[g];
+                } else if (counts[g] == 0) {
+                    line << "-";        // MIN/MAX/AVG of no rows
+                } else if (spec.integer && spec.function != AggregateFunction::Average) {
+                    line << static_cast<long long>(value);
+                } else {
+                    line << std::fixed << std::setprecision(2) << value;
+                }
+            }
+            result.rows.push_back(line.str());
+        }
+        return result;
+    }
+};
+
+// Compile a query against whichever table it names and run it over that
+// container; Rows is Array or LinkedList of owned or arena-backed records
+template <template <typename> class Rows, typename TR, typename RV>
+bool runQuery(const std::string& text, const Rows<TR>& transactions, const Rows<RV>& reviews,
+              QueryResult& result, std::string& error) {
+    std::string table = queryTable(text);
+    if (table == RecordSchema<RV>::table()) {
+        CompiledQuery<RV> query;
+        if (!query.compile(text, error)) return false;
+        result = query.run(reviews);
+        return true;
+    }
+    CompiledQuery<TR> query;
+    if (!query.compile(text, error)) return false;
+    result = query.run(transactions);
+    return true;
+}
+
+#endif
@@ -0,0 +1,469 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <queue>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "ArrayDataAnalyzer.h"
+#include "RowSchema.h"
+#include "IncrementalState.h"
+
+// Line protocol spoken over the Unix socket. Every request is one line; every
+// response is "OK <n>" followed by n payload lines, or a single "ERR <reason>".
+//   PAGE <offset> <limit>            transactions in date order (limit <= 1000)
+//   PERCENT <category>,<payment>     matches, category total, percentage
+//   TOPWORDS <rating> <k>            most frequent review words for a rating
+//   STATS                            row counts and snapshot version
+//   REFRESH                          reload both files into a new snapshot
+//   QUIT                             close the connection
+const int MAX_QUERY_LINE = 4096;
+const int MAX_PAGE_ROWS = 1000;
+const int CLIENT_SEND_TIMEOUT_SECONDS = 5;
+
+// Everything a query reads, built once per load and never modified after, so
+// any number of workers can share it without locking
+struct DatasetSnapshot {
+    Array<Transaction> sortedTransactions;
+    TransactionCounters counters;
+    Array<WordFrequency> wordsByRating[6];  // Indexed by rating 1-5
+    int reviewCount;
+    long long version;
+
+    DatasetSnapshot() : reviewCount(0), version(0) {}
+};
+
+// Load both CSV files through an analyzer and precompute every answer source
+inline bool loadSnapshot(const std::string& transactionsPath, const std::string& reviewsPath,
+                         DatasetSnapshot& snapshot, std::string& error) {
+    ScopedTimer timer("server.load");
+    ArrayDataAnalyzer analyzer;
+    std::string line;
+
+    std::ifstream transFile(transactionsPath.c_str());
+    if (!transFile) {
+        error = "could not open " + transactionsPath;
+        return false;
+    }
+    std::getline(transFile, line);
+    while (std::getline(transFile, line)) {
+        Transaction trans;
+        if (TransactionRow::parse(line, trans)) {
+            analyzer.addTransaction(trans);
+            snapshot.counters.add(trans);
+        }
+    }
+
+    std::ifstream reviewFile(reviewsPath.c_str());
+    if (!reviewFile) {
+        error = "could not open " + reviewsPath;
+        return false;
+    }
+    std::getline(reviewFile, line);
+    while (std::getline(reviewFile, line)) {
+        Review review;
+        if (ReviewRow::parse(line, review)) {
+            analyzer.addReview(review);
+        }
+    }
+
+    snapshot.sortedTransactions = analyzer.getTransactions();
+    analyzer.quickSort(snapshot.sortedTransactions, compareTransactionsByDate);
+    for (int rating = 1; rating <= 5; rating++) {
+        snapshot.wordsByRating[rating] = analyzer.rankWordsForRating(rating);
+    }
+    snapshot.reviewCount = analyzer.getReviews().getSize();
+    return true;
+}
+
+inline std::string queryError(const std::string& reason) {
+    return "ERR " + reason + "\n";
+}
+
+// Answer one request line (anything but REFRESH and QUIT) from a snapshot
+inline std::string answerQuery(const DatasetSnapshot& snapshot, const std::string& line) {
+    std::istringstream request(line);
+    std::string command;
+    request >> command;
+    std::ostringstream payload;
+    int lines = 0;
+
+    if (command == "PAGE") {
+        int offset = -1, limit = -1;
+        if (!(request >> offset >> limit) || offset < 0 || limit < 0) {
+            return queryError("usage: PAGE <offset> <limit>");
+        }
+        if (limit > MAX_PAGE_ROWS) limit = MAX_PAGE_ROWS;
+        const Array<Transaction>& rows = snapshot.sortedTransactions;
+        // Clamp before adding so offset + limit cannot overflow
+        int total = rows.getSize();
+        if (offset > total) offset = total;
+        if (limit > total - offset) limit = total - offset;
+        for (int i = offset; i < offset + limit; i++) {
+            const Transaction& t = rows[i];
+            payload << t.date << ", " << t.customerId << ", " << t.product << ", "
+                    << t.category << ", " << t.price << ", " << t.paymentMethod << "\n";
+            lines++;
+        }
+    } else if (command == "PERCENT") {
+        std::string rest;
+        std::getline(request >> std::ws, rest);
+        size_t comma = rest.find(',');
+        if (comma == std::string::npos) {
+            return queryError("usage: PERCENT <category>,<payment method>");
+        }
+        std::string category = rest.substr(0, comma);
+        std::string payment = rest.substr(comma + 1);
+        int total = snapshot.counters.category(category);
+        int matches = snapshot.counters.categoryPayment(category, payment);
+        double percentage = total > 0 ? static_cast<double>(matches) / total * 100 : 0;
+        payload << matches << " " << total << " " << std::fixed << std::setprecision(2) << percentage << "\n";
+        lines = 1;
+    } else if (command == "TOPWORDS") {
+        int rating = 0, k = 0;
+        if (!(request >> rating >> k) || rating < 1 || rating > 5 || k < 0) {
+            return queryError("usage: TOPWORDS <rating 1-5> <k>");
+        }
+        const Array<WordFrequency>& words = snapshot.wordsByRating[rating];
+        for (int i = 0; i < k && i < words.getSize(); i++) {
+            payload << words[i].word << " " << words[i].frequency << "\n";
+            lines++;
+        }
+    } else if (command == "STATS") {
+        payload << "transactions " << snapshot.sortedTransactions.getSize()
+                << " reviews " << snapshot.reviewCount
+                << " version " << snapshot.version << "\n";
+        lines = 1;
+    } else {
+        return queryError("unknown command");
+    }
+
+    std::ostringstream response;
+    response << "OK " << lines << "\n" << payload.str();
+    return response.str();
+}
+
+enum LineStatus {
+    LINE_READY,         // A complete line was read
+    LINE_PENDING,       // No complete line yet and the socket has no more data
+    LINE_CLOSED         // EOF, error or an overlong line
+};
+
+// Buffered line reader over a socket
+class SocketLineReader {
+private:
+    int fd;
+    std::string pending;
+
+    bool takeBufferedLine(std::string& line) {
+        size_t newline = pending.find('\n');
+        if (newline == std::string::npos) return false;
+        line = pending.substr(0, newline);
+        pending.erase(0, newline + 1);
+        if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+        return true;
+    }
+
+    LineStatus receive(std::string& line, int flags) {
+        while (true) {
+            if (takeBufferedLine(line)) return LINE_READY;
+            if (pending.size() > static_cast<size_t>(MAX_QUERY_LINE)) return LINE_CLOSED;
+            char buffer[4096];
+            ssize_t got = recv(fd, buffer, sizeof(buffer), flags);
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return LINE_PENDING;
+            if (got <= 0) return LINE_CLOSED;
+            pending.append(buffer, got);
+        }
+    }
+
+public:
+    explicit SocketLineReader(int socketFd) : fd(socketFd) {}
+
+    // Next line without its newline; false on EOF, error or an overlong line
+    bool readLine(std::string& line) {
+        return receive(line, 0) == LINE_READY;
+    }
+
+    // Like readLine, but never blocks: a partial line stays buffered
+    LineStatus tryReadLine(std::string& line) {
+        return receive(line, MSG_DONTWAIT);
+    }
+};
+
+inline bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+// An open client and the partial request read from it so far
+struct ClientConnection {
+    int fd;
+    SocketLineReader reader;
+
+    explicit ClientConnection(int socketFd) : fd(socketFd), reader(socketFd) {}
+};
+
+// Serves the protocol over a Unix domain socket. The poll loop in run()
+// watches the listening socket and every idle connection; when a client
+// sends data its connection goes to a fixed pool of workers, which answer
+// the complete requests against the current snapshot and hand it back to
+// the poll loop. Workers are only busy while there are requests to answer,
+// so idle clients cannot starve others. A client that stops reading its
+// responses is dropped after CLIENT_SEND_TIMEOUT_SECONDS. REFRESH builds a
+// new snapshot off to the side and swaps the pointer, so readers never wait
+// on a reload and in-flight queries finish on the snapshot they started with.
+class QueryServer {
+private:
+    std::string socketPath;
+    std::string transactionsPath;
+    std::string reviewsPath;
+    int threadCount;
+    int listenFd;
+    std::atomic<bool> stopping;
+
+    std::mutex snapshotMutex;               // Guards only the pointer swap
+    std::shared_ptr<const DatasetSnapshot> snapshot;
+    std::mutex refreshMutex;                // One reload at a time
+    long long nextVersion;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::queue<ClientConnection*> readyClients;     // Have data, wait for a worker
+    std::queue<ClientConnection*> returnedClients;  // Served, wait for the poll loop
+    int wakeFds[2];                                 // Pipe that wakes the poll loop
+
+    std::shared_ptr<const DatasetSnapshot> currentSnapshot() {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        return snapshot;
+    }
+
+    std::string refresh() {
+        std::lock_guard<std::mutex> refreshLock(refreshMutex);
+        std::string error;
+        if (!reload(error)) return queryError(error);
+        return answerQuery(*currentSnapshot(), "STATS");
+    }
+
+    static void closeClient(ClientConnection* client) {
+        close(client->fd);
+        delete client;
+    }
+
+    // Answer every complete request the client has sent; false once the
+    // connection should be closed
+    bool serveRequests(ClientConnection* client) {
+        std::string line;
+        while (true) {
+            LineStatus status = client->reader.tryReadLine(line);
+            if (status == LINE_PENDING) return true;
+            if (status == LINE_CLOSED || line == "QUIT") return false;
+            if (line.empty()) continue;
+            countMetric("server.queries", 1);
+            std::string response = line == "REFRESH" ? refresh() : answerQuery(*currentSnapshot(), line);
+            if (!sendAll(client->fd, response)) return false;
+        }
+    }
+
+    // Give a served connection back to the poll loop
+    void returnClient(ClientConnection* client) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (!stopping) {
+                returnedClients.push(client);
+                client = nullptr;
+            }
+        }
+        if (client) {
+            closeClient(client);
+            return;
+        }
+        char wake = 0;
+        while (write(wakeFds[1], &wake, 1) < 0 && errno == EINTR) {}
+    }
+
+    void workerLoop() {
+        while (true) {
+            ClientConnection* client;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [this]() { return stopping || !readyClients.empty(); });
+                if (readyClients.empty()) return;
+                client = readyClients.front();
+                readyClients.pop();
+            }
+            if (serveRequests(client)) {
+                returnClient(client);
+            } else {
+                closeClient(client);
+            }
+        }
+    }
+
+    void acceptClient(Array<ClientConnection*>& idle) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) return;
+        timeval timeout;
+        timeout.tv_sec = CLIENT_SEND_TIMEOUT_SECONDS;
+        timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        idle.push_back(new ClientConnection(fd));
+    }
+
+    // Watch the listening socket and the idle connections until stop(),
+    // waking up regularly to notice shutdown
+    void pollLoop() {
+        Array<ClientConnection*> idle;
+        Array<pollfd> watched;
+        while (!stopping) {
+            watched = Array<pollfd>(idle.getSize() + 2);
+            pollfd p;
+            p.events = POLLIN;
+            p.revents = 0;
+            p.fd = listenFd;
+            watched.push_back(p);
+            p.fd = wakeFds[0];
+            watched.push_back(p);
+            for (int c = 0; c < idle.getSize(); c++) {
+                p.fd = idle[c]->fd;
+                watched.push_back(p);
+            }
+            int ready = poll(watched.getData(), watched.getSize(), 200);
+            if (ready < 0 && errno != EINTR) break;
+            if (ready <= 0) continue;
+
+            // Connections with data (or a hangup) go to the workers
+            Array<ClientConnection*> stillIdle(idle.getSize() > 0 ? idle.getSize() : 1);
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                for (int c = 0; c < idle.getSize(); c++) {
+                    if (watched[c + 2].revents != 0) {
+                        readyClients.push(idle[c]);
+                        queueReady.notify_one();
+                    } else {
+                        stillIdle.push_back(idle[c]);
+                    }
+                }
+                if (watched[1].revents != 0) {
+                    char drain[64];
+                    while (read(wakeFds[0], drain, sizeof(drain)) == static_cast<ssize_t>(sizeof(drain))) {}
+                    while (!returnedClients.empty()) {
+                        stillIdle.push_back(returnedClients.front());
+                        returnedClients.pop();
+                    }
+                }
+            }
+            idle = stillIdle;
+            if (watched[0].revents != 0) acceptClient(idle);
+        }
+        for (int c = 0; c < idle.getSize(); c++) {
+            closeClient(idle[c]);
+        }
+    }
+
+public:
+    QueryServer(const std::string& socket, const std::string& transactions, const std::string& reviews, int threads)
+        : socketPath(socket), transactionsPath(transactions), reviewsPath(reviews),
+          threadCount(threads > 0 ? threads : 1), listenFd(-1), stopping(false), nextVersion(1) {
+        wakeFds[0] = wakeFds[1] = -1;
+    }
+
+    // Build a fresh snapshot from the files and publish it
+    bool reload(std::string& error) {
+        std::shared_ptr<DatasetSnapshot> fresh(new DatasetSnapshot());
+        if (!loadSnapshot(transactionsPath, reviewsPath, *fresh, error)) return false;
+        fresh->version = nextVersion++;
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        snapshot = fresh;
+        return true;
+    }
+
+    // Bind the socket and serve until stop() is called
+    bool run(std::string& error) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            error = "socket path too long: " + socketPath;
+            return false;
+        }
+        std::strcpy(address.sun_path, socketPath.c_str());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0) {
+            error = std::string("socket: ") + std::strerror(errno);
+            return false;
+        }
+        unlink(socketPath.c_str());
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            listen(listenFd, 64) < 0) {
+            error = "could not listen on " + socketPath + ": " + std::strerror(errno);
+            close(listenFd);
+            return false;
+        }
+        if (pipe(wakeFds) < 0 || fcntl(wakeFds[0], F_SETFL, O_NONBLOCK) < 0) {
+            error = std::string("pipe: ") + std::strerror(errno);
+            close(listenFd);
+            return false;
+        }
+
+        std::thread* workers = new std::thread[threadCount];
+        for (int t = 0; t < threadCount; t++) {
+            workers[t] = std::thread([this]() { workerLoop(); });
+        }
+
+        pollLoop();
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+            while (!readyClients.empty()) {
+                closeClient(readyClients.front());
+                readyClients.pop();
+            }
+            while (!returnedClients.empty()) {
+                closeClient(returnedClients.front());
+                returnedClients.pop();
+            }
+        }
+        queueReady.notify_all();
+        for (int t = 0; t < threadCount; t++) {
+            workers[t].join();
+        }
+        delete[] workers;
+        close(wakeFds[0]);
+        close(wakeFds[1]);
+        close(listenFd);
+        unlink(socketPath.c_str());
+        return true;
+    }
+
+    // Only sets a lock-free flag, so it is safe from another thread or a
+    // signal handler; run() notices within a poll interval and shuts down
+    void stop() {
+        stopping = true;
+    }
+};
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <sys/stat.h>
+#include "Array.h"
+#include "DataStructures.h"
+#include "IncrementalState.h"
+#include "LazyTable.h"
+#include "FastHash.h"
+#include "Metrics.h"
+
+// Everything the standard questions print, in a form that can be reloaded
+// without reading the datasets
+struct AnalysisResults {
+    Array<long long> sortedOffsets;     // Byte offset of each transaction line, in date order
+    TransactionCounters counters;       // Category/payment counts
+    Array<WordFrequency> topWords;      // Ranked words of the requested rating
+};
+
+const uint64_t RESULT_CACHE_MAGIC = 0x31454843414e4145ULL;     // "EANACHE1"
+
+// Identity of one input file when the results were computed
+struct InputFingerprint {
+    long long size;
+    long long mtimeNs;
+    uint64_t contentHash;
+    bool hashed;
+
+    InputFingerprint() : size(-1), mtimeNs(0), contentHash(0), hashed(false) {}
+};
+
+inline bool statInput(const std::string& path, InputFingerprint& print) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return false;
+    print.size = info.st_size;
+    print.mtimeNs = static_cast<long long>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+    print.hashed = false;
+    return true;
+}
+
+inline bool hashInput(const std::string& path, InputFingerprint& print) {
+    if (print.hashed) return true;
+    ScopedTimer timer("cache.hashInput");
+    MappedFile file;
+    std::string error;
+    if (!file.open(path, error)) return false;
+    print.contentHash = fastHash64(file.data(), static_cast<size_t>(file.size()));
+    print.hashed = true;
+    return true;
+}
+
+// On-disk cache of AnalysisResults for one pair of input files and one set
+// of analysis parameters. Each combination gets its own entry file in the
+// cache directory, named by a hash of the input paths and parameters. The
+// entry records the size, modification time and content hash of both inputs:
+// if size and mtime still match, the entry is used without reading the
+// inputs; if only the mtime changed, the inputs are rehashed and the entry is
+// still used when the contents are identical. Entries are written to a
+// temporary file and renamed into place, so readers never see a partial one.
+class ResultCache {
+private:
+    std::string directory;
+    std::string inputPaths[2];
+    std::string parameters;
+    InputFingerprint current[2];
+    bool statted;
+
+    // Absolute path where it resolves, so the same relative names in two
+    // directories get separate entries
+    static std::string resolve(const std::string& path) {
+        char resolved[PATH_MAX];
+        return realpath(path.c_str(), resolved) ? std::string(resolved) : path;
+    }
+
+    std::string entryPath() const {
+        std::string key = resolve(inputPaths[0]) + '\n' + resolve(inputPaths[1]) + '\n' + parameters;
+        char name[40];
+        std::snprintf(name, sizeof(name), "analysis-%016llx.cache",
+                      static_cast<unsigned long long>(fastHash64(key.data(), key.size())));
+        return directory + "/" + name;
+    }
+
+    template <typename V>
+    static void put(std::ofstream& out, const V& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    static void putString(std::ofstream& out, const std::string& text) {
+        put(out, static_cast<int>(text.size()));
+        out.write(text.data(), text.size());
+    }
+
+    // Bounds-checked reader over a loaded entry
+    struct EntryReader {
+        const char* p;
+        const char* end;
+
+        template <typename V>
+        bool get(V& value) {
+            if (end - p < static_cast<long>(sizeof(value))) return false;
+            std::memcpy(&value, p, sizeof(value));
+            p += sizeof(value);
+            return true;
+        }
+
+        bool getString(std::string& text) {
+            int length;
+            if (!get(length) || length < 0 || end - p < length) return false;
+            text.assign(p, length);
+            p += length;
+            return true;
+        }
+    };
+
+    bool statInputs() {
+        if (!statted) {
+            statted = statInput(inputPaths[0], current[0]) && statInput(inputPaths[1], current[1]);
+        }
+        return statted;
+    }
+
+    bool matches(int input, const InputFingerprint& stored) {
+        if (stored.size != current[input].size) return false;
+        if (stored.mtimeNs == current[input].mtimeNs) return true;
+        return hashInput(inputPaths[input], current[input]) && current[input].contentHash == stored.contentHash;
+    }
+
+public:
+    ResultCache(const std::string& dir, const std::string& transactionsPath, const std::string& reviewsPath,
+                const std::string& params)
+        : directory(dir), parameters(params), statted(false) {
+        inputPaths[0] = transactionsPath;
+        inputPaths[1] = reviewsPath;
+    }
+
+    // True and fills results if a valid entry exists for the current inputs
+    bool load(AnalysisResults& results) {
+        ScopedTimer timer("cache.load");
+        if (!statInputs()) return false;
+        MappedFile file;
+        std::string error;
+        if (!file.open(entryPath(), error)) return false;
+
+        EntryReader in = {file.data(), file.data() + file.size()};
+        uint64_t magic;
+        std::string storedParameters;
+        InputFingerprint stored[2];
+        if (!in.get(magic) || magic != RESULT_CACHE_MAGIC || !in.getString(storedParameters) || storedParameters != parameters) {
+            return false;
+        }
+        for (int i = 0; i < 2; i++) {
+            if (!in.get(stored[i].size) || !in.get(stored[i].mtimeNs) || !in.get(stored[i].contentHash)) return false;
+        }
+        if (!matches(0, stored[0]) || !matches(1, stored[1])) return false;
+
+        int rows, pairs, words;
+        if (!in.get(rows) || rows < 0 || in.end - in.p < static_cast<long long>(rows) * 8) return false;
+        results.sortedOffsets = Array<long long>(rows > 0 ? rows : 1);
+        for (int i = 0; i < rows; i++) {
+            long long offset;
+            in.get(offset);
+            results.sortedOffsets.push_back(offset);
+        }
+        if (!in.get(pairs) || pairs < 0) return false;
+        for (int i = 0; i < pairs; i++) {
+            std::string category, paymentMethod;
+            int count;
+            if (!in.getString(category) || !in.getString(paymentMethod) || !in.get(count)) return false;
+            results.counters.add(category, paymentMethod, count);
+        }
+        if (!in.get(words) || words < 0) return false;
+        for (int i = 0; i < words; i++) {
+            WordFrequency word;
+            if (!in.getString(word.word) || !in.get(word.frequency)) return false;
+            results.topWords.push_back(word);
+        }
+        countMetric("cache.rows", rows);
+        return true;
+    }
+
+    // Write an entry for the inputs as they were when load() looked at them;
+    // nothing is stored if they have changed since
+    bool store(const AnalysisResults& results, std::string& error) {
+        ScopedTimer timer("cache.store");
+        InputFingerprint now[2];
+        if (!statInputs() || !statInput(inputPaths[0], now[0]) || !statInput(inputPaths[1], now[1])) {
+            error = "could not stat the input files";
+            return false;
+        }
+        for (int i = 0; i < 2; i++) {
+            if (now[i].size != current[i].size || now[i].mtimeNs != current[i].mtimeNs) {
+                error = inputPaths[i] + " changed during the run";
+                return false;
+            }
+            if (!hashInput(inputPaths[i], current[i])) {
+                error = "could not read " + inputPaths[i];
+                return false;
+            }
+        }
+        if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+            error = "could not create " + directory + ": " + std::strerror(errno);
+            return false;
+        }
+
+        std::string path = entryPath();
+        std::string temporary = path + ".tmp";
+        std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        put(out, RESULT_CACHE_MAGIC);
+        putString(out, parameters);
+        for (int i = 0; i < 2; i++) {
+            put(out, current[i].size);
+            put(out, current[i].mtimeNs);
+            put(out, current[i].contentHash);
+        }
+        put(out, results.sortedOffsets.getSize());
+        out.write(reinterpret_cast<const char*>(results.sortedOffsets.getData()),
+                  static_cast<std::streamsize>(results.sortedOffsets.getSize()) * 8);
+
+        int pairs = 0;
+        results.counters.forEachPair([&pairs](const std::string&, const std::string&, int) { pairs++; });
+        put(out, pairs);
+        results.counters.forEachPair([&out](const std::string& category, const std::string& paymentMethod, int count) {
+            putString(out, category);
+            putString(out, paymentMethod);
+            put(out, count);
+        });
+        put(out, results.topWords.getSize());
+        for (int i = 0; i < results.topWords.getSize(); i++) {
+            putString(out, results.topWords[i].word);
+            put(out, results.topWords[i].frequency);
+        }
+        out.close();
+        if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            error = "could not write " + path;
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,606 @@
+#ifndef REVIEW_INDEX_H
+#define REVIEW_INDEX_H
+
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+#include <algorithm>
+#include "Array.h"
+#include "HashMap.h"
+#include "DataStructures.h"
+#include "ProductRatings.h"
+#include "LazyTable.h"
+#include "ResultCache.h"
+#include "Metrics.h"
+
+// Call visit(word) for each word of a review, with the analyzers' rules:
+// split on whitespace, drop punctuation, lowercase, skip empty words
+template <typename F>
+void forEachReviewWord(const char* text, int length, std::string& word, F visit) {
+    int i = 0;
+    while (i < length) {
+        while (i < length && std::isspace(static_cast<unsigned char>(text[i]))) i++;
+        if (i == length) break;
+        word.clear();
+        while (i < length && !std::isspace(static_cast<unsigned char>(text[i]))) {
+            unsigned char c = static_cast<unsigned char>(text[i++]);
+            if (!std::ispunct(c)) word.push_back(static_cast<char>(std::tolower(c)));
+        }
+        if (!word.empty()) visit(word);
+    }
+}
+
+inline void reviewTextBytes(const std::string& text, const char*& data, int& length) {
+    data = text.data();
+    length = static_cast<int>(text.size());
+}
+
+inline void reviewTextBytes(const StringRef& text, const char*& data, int& length) {
+    data = text.data;
+    length = text.length;
+}
+
+// Sorted strings stored as one character block plus offsets (count + 1),
+// searchable in place whether owned or mapped from an index file
+struct StringTable {
+    const long long* offsets;
+    const char* chars;
+    int count;
+
+    StringTable() : offsets(nullptr), chars(nullptr), count(0) {}
+
+    // Position of text, or -1
+    int find(const std::string& text) const {
+        int lo = 0, hi = count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            int order = compareAt(mid, text);
+            if (order == 0) return mid;
+            if (order < 0) lo = mid + 1; else hi = mid;
+        }
+        return -1;
+    }
+
+    int compareAt(int i, const std::string& text) const {
+        size_t length = static_cast<size_t>(offsets[i + 1] - offsets[i]);
+        int order = std::memcmp(chars + offsets[i], text.data(), std::min(length, text.size()));
+        if (order != 0) return order;
+        return length < text.size() ? -1 : (length > text.size() ? 1 : 0);
+    }
+
+    std::string at(int i) const {
+        return std::string(chars + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i]));
+    }
+};
+
+// A parsed --search query: terms joined by AND (the default) or OR, plus
+// optional filters on the matching reviews
+struct ReviewQuery {
+    Array<std::string> terms;
+    bool matchAll;
+    int rating;             // 0 = any
+    std::string productId;  // Empty = any
+
+    ReviewQuery() : matchAll(true), rating(0) {}
+};
+
+// Parse "word word", "word AND word" or "word OR word"; words are normalized
+// like review text. AND and OR cannot be mixed.
+inline bool parseReviewQuery(const std::string& text, ReviewQuery& query, std::string& error) {
+    query.terms = Array<std::string>();
+    bool sawAnd = false, sawOr = false;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find(' ', start);
+        if (end == std::string::npos) end = text.size();
+        std::string token = text.substr(start, end - start);
+        start = end + 1;
+        if (token.empty()) continue;
+        if (token == "AND") {
+            sawAnd = true;
+            continue;
+        }
+        if (token == "OR") {
+            sawOr = true;
+            continue;
+        }
+        std::string word;
+        int words = 0;
+        forEachReviewWord(token.data(), static_cast<int>(token.size()), word, [&](const std::string& w) {
+            query.terms.push_back(w);
+            words++;
+        });
+        if (words == 0) {
+            error = "\"" + token + "\" has no letters or digits";
+            return false;
+        }
+    }
+    if (sawAnd && sawOr) {
+        error = "AND and OR cannot be mixed";
+        return false;
+    }
+    if (query.terms.getSize() == 0) {
+        error = "no search terms";
+        return false;
+    }
+    query.matchAll = !sawOr;
+    return true;
+}
+
+const uint64_t REVIEW_INDEX_MAGIC = 0x31584449564552ULL;     // "REVIDX1"
+const int POSTING_BLOCK = 64;
+
+// Inverted index from review words to the rows of the reviews containing
+// them. Each term's rows are kept in blocks of POSTING_BLOCK: a skip table
+// holds every block's first row, and the rest are stored as varint-encoded
+// gaps, typically one byte each. Intersections gallop over the skip table
+// and decode only the blocks they land in. The index also keeps each
+// review's rating and product so results can be filtered without the
+// reviews. All tables are flat arrays, so save() writes them as they are
+// and load() maps the file and uses it in place.
+class ReviewIndex {
+private:
+    // Owned storage when built in memory
+    Array<long long> termOffsetData;
+    Array<char> termCharData;
+    Array<int> termFirstBlockData;
+    Array<int> termRowCountData;
+    Array<int> blockFirstRowData;
+    Array<long long> blockOffsetData;
+    Array<unsigned char> postingData;
+    Array<long long> productOffsetData;
+    Array<char> productCharData;
+    Array<int> reviewProductData;
+    Array<unsigned char> reviewRatingData;
+
+    // Read-only views, into the arrays above or into the mapped file
+    StringTable terms;
+    const int* termFirstBlock;      // termCount + 1 entries
+    const int* termRowCount;
+    const int* blockFirstRow;
+    const long long* blockOffset;
+    const unsigned char* postings;
+    StringTable products;
+    const int* reviewProduct;
+    const unsigned char* reviewRating;
+    int reviewCount;
+    long long postingBytes;
+    int blockCount;
+
+    MappedFile mapped;
+    InputFingerprint source;        // Reviews file the index was built from
+
+    // Sections of a saved index, in file order
+    struct FileHeader {
+        uint64_t magic;
+        long long sourceSize;
+        long long sourceMtimeNs;
+        long long reviewCount;
+        long long termCount;
+        long long termChars;
+        long long blockCount;
+        long long postingBytes;
+        long long productCount;
+        long long productChars;
+    };
+
+    static void appendVarint(Array<unsigned char>& out, unsigned int value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    // Sort the strings, build their table and map old ids to sorted positions
+    static void buildStringTable(const Array<std::string>& strings, Array<long long>& offsets, Array<char>& chars,
+                                 Array<int>& newId) {
+        int n = strings.getSize();
+        Array<int> order(n > 0 ? n : 1);
+        for (int i = 0; i < n; i++) order.push_back(i);
+        std::sort(order.getData(), order.getData() + n,
+                  [&strings](int a, int b) { return strings[a] < strings[b]; });
+        offsets = Array<long long>(n + 1);
+        chars = Array<char>();
+        newId = Array<int>(n > 0 ? n : 1);
+        for (int i = 0; i < n; i++) newId.push_back(0);
+        offsets.push_back(0);
+        for (int i = 0; i < n; i++) {
+            const std::string& s = strings[order[i]];
+            for (size_t c = 0; c < s.size(); c++) chars.push_back(s[c]);
+            offsets.push_back(chars.getSize());
+            newId[order[i]] = i;
+        }
+    }
+
+    void pointAtOwnedData() {
+        terms.offsets = termOffsetData.getData();
+        terms.chars = termCharData.getData();
+        terms.count = termOffsetData.getSize() - 1;
+        termFirstBlock = termFirstBlockData.getData();
+        termRowCount = termRowCountData.getData();
+        blockFirstRow = blockFirstRowData.getData();
+        blockOffset = blockOffsetData.getData();
+        postings = postingData.getData();
+        postingBytes = postingData.getSize();
+        blockCount = blockFirstRowData.getSize();
+        products.offsets = productOffsetData.getData();
+        products.chars = productCharData.getData();
+        products.count = productOffsetData.getSize() - 1;
+        reviewProduct = reviewProductData.getData();
+        reviewRating = reviewRatingData.getData();
+        reviewCount = reviewRatingData.getSize();
+    }
+
+    bool passes(int row, int rating, int product) const {
+        return (rating == 0 || reviewRating[row] == rating) && (product < 0 || reviewProduct[row] == product);
+    }
+
+public:
+    // Sequential reader over one term's rows with galloping advanceTo()
+    class Cursor {
+    private:
+        const ReviewIndex* index;
+        int block;
+        int blockEnd;
+        int remaining;              // Rows left to decode in the current block
+        int termRows;
+        int termFirstBlock;
+        const unsigned char* p;
+        int row;
+        bool done;
+
+        void loadBlock(int b) {
+            block = b;
+            row = index->blockFirstRow[b];
+            p = index->postings + index->blockOffset[b];
+            int rowsBefore = (b - termFirstBlock) * POSTING_BLOCK;
+            int rowsInBlock = std::min(POSTING_BLOCK, termRows - rowsBefore);
+            remaining = rowsInBlock - 1;
+        }
+
+    public:
+        Cursor(const ReviewIndex* owner = nullptr, int term = -1)
+            : index(owner), block(0), blockEnd(0), remaining(0), termRows(0), termFirstBlock(0),
+              p(nullptr), row(0), done(true) {
+            if (term < 0) return;
+            termFirstBlock = index->termFirstBlock[term];
+            blockEnd = index->termFirstBlock[term + 1];
+            termRows = index->termRowCount[term];
+            done = termFirstBlock == blockEnd;
+            if (!done) loadBlock(termFirstBlock);
+        }
+
+        bool atEnd() const { return done; }
+        int current() const { return row; }
+        int rowCount() const { return termRows; }
+
+        void next() {
+            if (remaining > 0) {
+                unsigned int gap = 0;
+                int shift = 0;
+                while (*p & 0x80) {
+                    gap |= static_cast<unsigned int>(*p++ & 0x7f) << shift;
+                    shift += 7;
+                }
+                gap |= static_cast<unsigned int>(*p++) << shift;
+                row += static_cast<int>(gap);
+                remaining--;
+            } else if (block + 1 < blockEnd) {
+                loadBlock(block + 1);
+            } else {
+                done = true;
+            }
+        }
+
+        // Move to the first row >= target. Finds the block by galloping
+        // (doubling steps, then binary search) over the skip table.
+        void advanceTo(int target) {
+            if (done || row >= target) return;
+            if (block + 1 < blockEnd && index->blockFirstRow[block + 1] <= target) {
+                // Last block starting at or before target
+                int lo = block + 1, step = 1;
+                while (lo + step < blockEnd && index->blockFirstRow[lo + step] <= target) {
+                    lo += step;
+                    step *= 2;
+                }
+                int hi = std::min(lo + step, blockEnd);
+                while (hi - lo > 1) {
+                    int mid = (lo + hi) / 2;
+                    if (index->blockFirstRow[mid] <= target) lo = mid; else hi = mid;
+                }
+                loadBlock(lo);
+            }
+            while (!done && row < target) next();
+        }
+    };
+
+    ReviewIndex()
+        : termFirstBlock(nullptr), termRowCount(nullptr), blockFirstRow(nullptr), blockOffset(nullptr),
+          postings(nullptr), reviewProduct(nullptr), reviewRating(nullptr), reviewCount(0), postingBytes(0),
+          blockCount(0) {}
+
+    // Index the reviews (owned or arena-backed); rows are their positions.
+    // sourcePath is recorded so a saved index can tell if it is stale.
+    template <typename R>
+    void build(const Array<R>& reviews, const std::string& sourcePath) {
+        ScopedTimer timer("index.reviews");
+        mapped.close();
+        statInput(sourcePath, source);
+
+        HashMap<std::string, int> termIds;
+        Array<std::string> termNames;
+        Array<int> lastRowOfTerm;           // Skips repeats of a word within one review
+        HashMap<std::string, int> productIds;
+        Array<std::string> productNames;
+        Array<int> occurrenceTerm;          // One (term, row) pair per distinct word of a review
+        Array<int> occurrenceRow;
+        reviewProductData = Array<int>(reviews.getSize() > 0 ? reviews.getSize() : 1);
+        reviewRatingData = Array<unsigned char>(reviews.getSize() > 0 ? reviews.getSize() : 1);
+
+        std::string word, productBuffer;
+        for (int row = 0; row < reviews.getSize(); row++) {
+            const R& review = reviews[row];
+            const std::string& product = productKey(review.productId, productBuffer);
+            int& productId = productIds.getOrInsert(product, -1);
+            if (productId < 0) {
+                productId = productNames.getSize();
+                productNames.push_back(product);
+            }
+            reviewProductData.push_back(productId);
+            reviewRatingData.push_back(static_cast<unsigned char>(review.rating >= 0 && review.rating <= 255 ? review.rating : 0));
+
+            const char* text;
+            int length;
+            reviewTextBytes(review.reviewText, text, length);
+            forEachReviewWord(text, length, word, [&](const std::string& w) {
+                int& term = termIds.getOrInsert(w, -1);
+                if (term < 0) {
+                    term = termNames.getSize();
+                    termNames.push_back(w);
+                    lastRowOfTerm.push_back(-1);
+                }
+                if (lastRowOfTerm[term] == row) return;
+                lastRowOfTerm[term] = row;
+                occurrenceTerm.push_back(term);
+                occurrenceRow.push_back(row);
+            });
+        }
+
+        // Sorted term and product tables; product ids become sorted positions
+        Array<int> termPosition, productPosition;
+        buildStringTable(termNames, termOffsetData, termCharData, termPosition);
+        buildStringTable(productNames, productOffsetData, productCharData, productPosition);
+        for (int row = 0; row < reviewProductData.getSize(); row++) {
+            reviewProductData[row] = productPosition[reviewProductData[row]];
+        }
+
+        // Counting sort of the occurrences by sorted term; rows stay ascending
+        int termCount = termNames.getSize();
+        Array<int> start(termCount + 1);
+        for (int t = 0; t <= termCount; t++) start.push_back(0);
+        for (int i = 0; i < occurrenceTerm.getSize(); i++) start[termPosition[occurrenceTerm[i]] + 1]++;
+        for (int t = 0; t < termCount; t++) start[t + 1] += start[t];
+        Array<int> rows(occurrenceRow.getSize() > 0 ? occurrenceRow.getSize() : 1);
+        for (int i = 0; i < occurrenceRow.getSize(); i++) rows.push_back(0);
+        Array<int> next = start;
+        for (int i = 0; i < occurrenceTerm.getSize(); i++) {
+            rows[next[termPosition[occurrenceTerm[i]]]++] = occurrenceRow[i];
+        }
+
+        // Blocks of gap-encoded rows per term
+        termFirstBlockData = Array<int>(termCount + 1);
+        termRowCountData = Array<int>(termCount > 0 ? termCount : 1);
+        blockFirstRowData = Array<int>();
+        blockOffsetData = Array<long long>();
+        postingData = Array<unsigned char>(occurrenceRow.getSize() + 1);
+        for (int t = 0; t < termCount; t++) {
+            termFirstBlockData.push_back(blockFirstRowData.getSize());
+            termRowCountData.push_back(start[t + 1] - start[t]);
+            for (int i = start[t]; i < start[t + 1]; i++) {
+                if ((i - start[t]) % POSTING_BLOCK == 0) {
+                    blockFirstRowData.push_back(rows[i]);
+                    blockOffsetData.push_back(postingData.getSize());
+                } else {
+                    appendVarint(postingData, static_cast<unsigned int>(rows[i] - rows[i - 1]));
+                }
+            }
+        }
+        termFirstBlockData.push_back(blockFirstRowData.getSize());
+        blockOffsetData.push_back(postingData.getSize());
+        pointAtOwnedData();
+
+        timer.addRows(reviews.getSize());
+        countMetric("index.reviews.terms", termCount);
+        countMetric("index.reviews.postings", occurrenceRow.getSize());
+        countMetric("index.reviews.postingBytes", postingData.getSize());
+    }
+
+    // Write the index to path (through a temporary file renamed into place)
+    bool save(const std::string& path, std::string& error) const {
+        std::string temporary = path + ".tmp";
+        std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        FileHeader header;
+        header.magic = REVIEW_INDEX_MAGIC;
+        header.sourceSize = source.size;
+        header.sourceMtimeNs = source.mtimeNs;
+        header.reviewCount = reviewCount;
+        header.termCount = terms.count;
+        header.termChars = terms.offsets[terms.count];
+        header.blockCount = blockCount;
+        header.postingBytes = postingBytes;
+        header.productCount = products.count;
+        header.productChars = products.offsets[products.count];
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // Every section starts on an 8-byte boundary so it can be used in place
+        long long written = sizeof(header);
+        auto section = [&out, &written](const void* data, long long bytes) {
+            out.write(static_cast<const char*>(data), bytes);
+            written += bytes;
+            static const char padding[8] = {0};
+            long long pad = (8 - written % 8) % 8;
+            out.write(padding, pad);
+            written += pad;
+        };
+        section(terms.offsets, (terms.count + 1) * 8LL);
+        section(terms.chars, header.termChars);
+        section(termFirstBlock, (terms.count + 1) * 4LL);
+        section(termRowCount, terms.count * 4LL);
+        section(blockFirstRow, blockCount * 4LL);
+        section(blockOffset, (blockCount + 1) * 8LL);
+        section(postings, postingBytes);
+        section(products.offsets, (products.count + 1) * 8LL);
+        section(products.chars, header.productChars);
+        section(reviewProduct, reviewCount * 4LL);
+        section(reviewRating, reviewCount);
+        out.close();
+        if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            error = "could not write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    // Map a saved index; false if it is missing, malformed, or was built
+    // from a different version of sourcePath (by size and mtime)
+    bool load(const std::string& path, const std::string& sourcePath, std::string& error) {
+        ScopedTimer timer("index.reviews.load");
+        if (!mapped.open(path, error)) return false;
+        FileHeader header;
+        if (mapped.size() < static_cast<long long>(sizeof(header))) {
+            error = path + " is not a review index";
+            return false;
+        }
+        std::memcpy(&header, mapped.data(), sizeof(header));
+        InputFingerprint current;
+        if (header.magic != REVIEW_INDEX_MAGIC) {
+            error = path + " is not a review index";
+            return false;
+        }
+        if (!statInput(sourcePath, current) || current.size != header.sourceSize ||
+            current.mtimeNs != header.sourceMtimeNs) {
+            error = path + " was built from a different " + sourcePath;
+            return false;
+        }
+
+        const char* p = mapped.data() + sizeof(header);
+        const char* end = mapped.data() + mapped.size();
+        bool fits = true;
+        auto section = [&p, end, &fits](long long bytes) {
+            const char* start = p;
+            if (bytes < 0 || end - p < bytes) {
+                fits = false;
+                return start;
+            }
+            p += bytes + (8 - bytes % 8) % 8;
+            if (p > end) p = end;
+            return start;
+        };
+        terms.offsets = reinterpret_cast<const long long*>(section((header.termCount + 1) * 8));
+        terms.chars = section(header.termChars);
+        termFirstBlock = reinterpret_cast<const int*>(section((header.termCount + 1) * 4));
+        termRowCount = reinterpret_cast<const int*>(section(header.termCount * 4));
+        blockFirstRow = reinterpret_cast<const int*>(section(header.blockCount * 4));
+        blockOffset = reinterpret_cast<const long long*>(section((header.blockCount + 1) * 8));
+        postings = reinterpret_cast<const unsigned char*>(section(header.postingBytes));
+        products.offsets = reinterpret_cast<const long long*>(section((header.productCount + 1) * 8));
+        products.chars = section(header.productChars);
+        reviewProduct = reinterpret_cast<const int*>(section(header.reviewCount * 4));
+        reviewRating = reinterpret_cast<const unsigned char*>(section(header.reviewCount));
+        if (!fits) {
+            error = path + " is truncated";
+            mapped.close();
+            return false;
+        }
+        terms.count = static_cast<int>(header.termCount);
+        products.count = static_cast<int>(header.productCount);
+        blockCount = static_cast<int>(header.blockCount);
+        postingBytes = header.postingBytes;
+        reviewCount = static_cast<int>(header.reviewCount);
+        source.size = header.sourceSize;
+        source.mtimeNs = header.sourceMtimeNs;
+        return true;
+    }
+
+    // Rows of the reviews matching the query, ascending
+    Array<int> search(const ReviewQuery& query) const {
+        ScopedTimer timer("index.reviews.search");
+        Array<int> result;
+        int product = -1;
+        if (!query.productId.empty()) {
+            product = products.find(query.productId);
+            if (product < 0) return result;
+        }
+
+        int n = query.terms.getSize();
+        Array<Cursor> cursors(n > 0 ? n : 1);
+        for (int i = 0; i < n; i++) {
+            cursors.push_back(Cursor(this, terms.find(query.terms[i])));
+        }
+
+        if (!query.matchAll) {
+            // Union: concatenate, sort and drop repeats
+            for (int i = 0; i < n; i++) {
+                for (Cursor& c = cursors[i]; !c.atEnd(); c.next()) {
+                    if (passes(c.current(), query.rating, product)) result.push_back(c.current());
+                }
+            }
+            std::sort(result.getData(), result.getData() + result.getSize());
+            int kept = 0;
+            for (int i = 0; i < result.getSize(); i++) {
+                if (kept == 0 || result[kept - 1] != result[i]) result[kept++] = result[i];
+            }
+            Array<int> unique(kept > 0 ? kept : 1);
+            for (int i = 0; i < kept; i++) unique.push_back(result[i]);
+            return unique;
+        }
+
+        // Intersection led by the rarest term; the others gallop to each candidate
+        for (int i = 0; i < n; i++) {
+            if (cursors[i].atEnd()) return result;
+        }
+        std::sort(cursors.getData(), cursors.getData() + n,
+                  [](const Cursor& a, const Cursor& b) { return a.rowCount() < b.rowCount(); });
+        int candidate = cursors[0].current();
+        while (true) {
+            bool matched = true;
+            for (int i = 1; i < n; i++) {
+                cursors[i].advanceTo(candidate);
+                if (cursors[i].atEnd()) return result;
+                if (cursors[i].current() > candidate) {
+                    candidate = cursors[i].current();
+                    matched = false;
+                    break;
+                }
+            }
+            if (matched) {
+                if (passes(candidate, query.rating, product)) result.push_back(candidate);
+                cursors[0].next();
+            } else {
+                cursors[0].advanceTo(candidate);
+            }
+            if (cursors[0].atEnd()) return result;
+            candidate = cursors[0].current();
+        }
+    }
+
+    // Rows containing a term (0 if it never occurs)
+    int rowCount(const std::string& term) const {
+        int t = terms.find(term);
+        return t < 0 ? 0 : termRowCount[t];
+    }
+
+    int getReviewCount() const { return reviewCount; }
+    int getTermCount() const { return terms.count; }
+    long long getPostingBytes() const { return postingBytes; }
+
+    ReviewIndex(const ReviewIndex&) = delete;
+    ReviewIndex& operator=(const ReviewIndex&) = delete;
+};
+
+#endif
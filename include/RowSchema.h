@@ -0,0 +1,176 @@
+#ifndef ROW_SCHEMA_H
+#define ROW_SCHEMA_H
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include "DataStructures.h"
+
+// Compile-time description of a CSV row: each Field names a column index and
+// the struct member it fills, and the member type picks the parser. A
+// RowSchema expands into one straight-line parser per record type that walks
+// the line once and writes every field directly into its member; no
+// per-row field containers are built.
+//
+// Fields are split on commas. A field that starts with a double quote runs to
+// the matching closing quote, so quoted text may contain commas; a doubled
+// quote inside it stands for one quote character and is unescaped in place,
+// which is why the line buffer is taken by non-const reference.
+
+// Parsers from one field's characters to a member, selected by member type
+template <typename M>
+struct FieldParser;
+
+template <>
+struct FieldParser<std::string> {
+    static bool parse(const char* data, int length, std::string& out) {
+        out.assign(data, length);
+        return true;
+    }
+};
+
+// The reference points into the line; arena-backed analyzers copy it on insert
+template <>
+struct FieldParser<StringRef> {
+    static bool parse(const char* data, int length, StringRef& out) {
+        out = StringRef(data, length);
+        return true;
+    }
+};
+
+// Like std::stod: leading digits are enough, but a field with no number is
+// rejected (the row is skipped instead of throwing)
+template <>
+struct FieldParser<double> {
+    static bool parse(const char* data, int length, double& out) {
+        char buffer[64];
+        int len = length < 63 ? length : 63;
+        std::memcpy(buffer, data, len);
+        buffer[len] = '\0';
+        char* end = nullptr;
+        out = std::strtod(buffer, &end);
+        return end != buffer;
+    }
+};
+
+template <>
+struct FieldParser<int> {
+    static bool parse(const char* data, int length, int& out) {
+        char buffer[32];
+        int len = length < 31 ? length : 31;
+        std::memcpy(buffer, data, len);
+        buffer[len] = '\0';
+        char* end = nullptr;
+        out = static_cast<int>(std::strtol(buffer, &end, 10));
+        return end != buffer;
+    }
+};
+
+// Cut the next field off the line at cursor. Sets data/length to its
+// contents (quotes removed, doubled quotes collapsed) and moves cursor past
+// the separator. False if there is no field left or a quote is unterminated.
+inline bool nextCsvField(char*& cursor, char* end, const char*& data, int& length) {
+    if (cursor == nullptr) return false;   // Past the last field
+    char* start = cursor;
+    if (start < end && *start == '"') {
+        char* out = start + 1;
+        char* in = start + 1;
+        while (true) {
+            if (in == end) return false;
+            if (*in == '"') {
+                if (in + 1 < end && in[1] == '"') {
+                    *out++ = '"';
+                    in += 2;
+                    continue;
+                }
+                in++;
+                break;
+            }
+            *out++ = *in++;
+        }
+        data = start + 1;
+        length = static_cast<int>(out - data);
+        // Anything between the closing quote and the separator is dropped
+        char* comma = static_cast<char*>(std::memchr(in, ',', end - in));
+        cursor = comma ? comma + 1 : nullptr;
+        return true;
+    }
+    char* comma = static_cast<char*>(std::memchr(start, ',', end - start));
+    data = start;
+    length = static_cast<int>((comma ? comma : end) - start);
+    cursor = comma ? comma + 1 : nullptr;
+    return true;
+}
+
+// One column of a row: its position in the line and the member it fills
+template <int Index, typename T, typename M, M T::* Member>
+struct Field {
+    static const int index = Index;
+
+    static bool apply(const char* data, int length, T& row) {
+        return FieldParser<M>::parse(data, length, row.*Member);
+    }
+};
+
+// Walks the fields in line order; every step is resolved at compile time, so
+// the recursion flattens into one unrolled sequence of split-and-parse steps
+template <typename T, int Position, typename... Fields>
+struct FieldWalker;
+
+template <typename T, int Position>
+struct FieldWalker<T, Position> {
+    static bool parse(char*&, char*, T&) { return true; }
+};
+
+template <typename T, int Position, typename First, typename... Rest>
+struct FieldWalker<T, Position, First, Rest...> {
+    static_assert(First::index >= Position, "schema fields must be listed in column order");
+
+    static bool parse(char*& cursor, char* end, T& row) {
+        const char* data;
+        int length;
+        for (int skipped = Position; skipped < First::index; skipped++) {
+            if (!nextCsvField(cursor, end, data, length)) return false;
+        }
+        if (!nextCsvField(cursor, end, data, length) || !First::apply(data, length, row)) return false;
+        return FieldWalker<T, First::index + 1, Rest...>::parse(cursor, end, row);
+    }
+};
+
+template <typename T, typename... Fields>
+struct RowSchema {
+    // Parse one line into row; false if a field is missing or malformed.
+    // Columns after the last schema field are ignored.
+    static bool parse(char* line, int length, T& row) {
+        char* cursor = line;
+        return FieldWalker<T, 0, Fields...>::parse(cursor, line + length, row);
+    }
+
+    static bool parse(std::string& line, T& row) {
+        return parse(&line[0], static_cast<int>(line.size()), row);
+    }
+};
+
+// Schemas of the two cleaned files, for owned and arena-backed records
+template <typename T, typename S>
+using TransactionSchemaOf = RowSchema<T,
+    Field<0, T, S, &T::customerId>,
+    Field<1, T, S, &T::product>,
+    Field<2, T, S, &T::category>,
+    Field<3, T, double, &T::price>,
+    Field<4, T, S, &T::date>,
+    Field<5, T, S, &T::paymentMethod> >;
+
+template <typename T, typename S>
+using ReviewSchemaOf = RowSchema<T,
+    Field<0, T, S, &T::productId>,
+    Field<1, T, S, &T::customerId>,
+    Field<2, T, int, &T::rating>,
+    Field<3, T, S, &T::reviewText> >;
+
+typedef TransactionSchemaOf<Transaction, std::string> TransactionRow;
+typedef TransactionSchemaOf<TransactionRef, StringRef> TransactionRefRow;
+typedef ReviewSchemaOf<Review, std::string> ReviewRow;
+typedef ReviewSchemaOf<ReviewRef, StringRef> ReviewRefRow;
+
+#endif
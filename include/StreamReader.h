@@ -0,0 +1,285 @@
+#ifndef STREAM_READER_H
+#define STREAM_READER_H
+
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fcntl.h>
+#include <unistd.h>
+
+const size_t STREAM_BLOCK_BYTES = 1 << 20;
+const int STREAM_BLOCK_COUNT = 4;
+
+// Open an input source: "-" is stdin, "fd:N" an inherited descriptor (e.g.
+// from 3< <(zcat file.gz)), anything else a file path. owned tells whether
+// the caller must close the descriptor.
+inline bool openInputSource(const std::string& source, int& fd, bool& owned, std::string& error) {
+    owned = false;
+    if (source == "-") {
+        fd = STDIN_FILENO;
+        return true;
+    }
+    if (source.compare(0, 3, "fd:") == 0) {
+        char* end = nullptr;
+        long number = std::strtol(source.c_str() + 3, &end, 10);
+        if (source.size() == 3 || *end != '\0' || number < 0) {
+            error = "invalid descriptor in " + source;
+            return false;
+        }
+        if (fcntl(static_cast<int>(number), F_GETFD) < 0) {
+            error = source + " is not an open descriptor";
+            return false;
+        }
+        fd = static_cast<int>(number);
+        return true;
+    }
+    fd = ::open(source.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "could not open " + source + ": " + std::strerror(errno);
+        return false;
+    }
+    owned = true;
+    return true;
+}
+
+// Line reader for pipes and other unseekable input. A reader thread fills a
+// ring of STREAM_BLOCK_COUNT blocks with read() while the caller takes lines
+// out of the completed ones, so reading and parsing overlap and throughput
+// is bounded by the slower of the two. A line that straddles two blocks is
+// copied into a carry buffer; all others are handed out in place.
+class BlockStreamReader {
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    int fd;
+    bool ownsFd;
+    size_t blockBytes;
+    Block blocks[STREAM_BLOCK_COUNT];
+
+    // Ring state, guarded by lock: blocks [released, filled) hold data
+    std::mutex lock;
+    std::condition_variable blockFilled;
+    std::condition_variable blockReleased;
+    long long filled;
+    long long released;
+    bool finished;              // No more blocks will be filled
+    bool stopping;              // Destructor asks the reader thread to quit
+    std::string readError;
+    std::thread reader;
+
+    // Consumer side
+    long long current;          // Block being read, -1 before the first
+    size_t position;
+    bool drained;               // Every filled block has been read
+    std::string carry;          // Start of a line continued in the next block
+    long long bytesRead;
+
+    void fillBlocks() {
+        for (long long next = 0;; next++) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                blockReleased.wait(guard, [&]() { return stopping || next - released < STREAM_BLOCK_COUNT; });
+                if (stopping) break;
+            }
+            Block& block = blocks[next % STREAM_BLOCK_COUNT];
+            size_t size = 0;
+            bool atEnd = false;
+            std::string error;
+            // Fill the whole block: pipes return at most their buffer per read
+            while (size < blockBytes) {
+                ssize_t got = ::read(fd, block.data + size, blockBytes - size);
+                if (got < 0 && errno == EINTR) continue;
+                if (got < 0) error = std::strerror(errno);
+                if (got <= 0) {
+                    atEnd = true;
+                    break;
+                }
+                size += got;
+            }
+            block.size = size;
+            std::lock_guard<std::mutex> guard(lock);
+            if (size > 0) filled++;
+            if (atEnd) {
+                finished = true;
+                readError = error;
+            }
+            blockFilled.notify_one();
+            if (atEnd) break;
+        }
+    }
+
+    // Hand the current block back to the reader and wait for the next one
+    bool advanceBlock() {
+        std::unique_lock<std::mutex> guard(lock);
+        if (current >= 0) {
+            released = current + 1;
+            blockReleased.notify_one();
+        }
+        current++;
+        position = 0;
+        blockFilled.wait(guard, [&]() { return finished || current < filled; });
+        drained = current >= filled;
+        return !drained;
+    }
+
+public:
+    explicit BlockStreamReader(size_t bytesPerBlock = STREAM_BLOCK_BYTES)
+        : fd(-1), ownsFd(false), blockBytes(bytesPerBlock), filled(0), released(0), finished(false),
+          stopping(false), current(-1), position(0), drained(false), bytesRead(0) {
+        for (int b = 0; b < STREAM_BLOCK_COUNT; b++) {
+            blocks[b].data = nullptr;
+            blocks[b].size = 0;
+        }
+    }
+
+    ~BlockStreamReader() {
+        if (reader.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            blockReleased.notify_one();
+            reader.join();
+        }
+        if (ownsFd) ::close(fd);
+        for (int b = 0; b < STREAM_BLOCK_COUNT; b++) {
+            delete[] blocks[b].data;
+        }
+    }
+
+    BlockStreamReader(const BlockStreamReader&) = delete;
+    BlockStreamReader& operator=(const BlockStreamReader&) = delete;
+
+    // Open the source (see openInputSource) and start the reader thread
+    bool open(const std::string& source, std::string& error) {
+        if (!openInputSource(source, fd, ownsFd, error)) return false;
+        for (int b = 0; b < STREAM_BLOCK_COUNT; b++) {
+            blocks[b].data = new char[blockBytes];
+        }
+        reader = std::thread(&BlockStreamReader::fillBlocks, this);
+        return true;
+    }
+
+    // Next line without its '\n', valid until the following call. Like
+    // std::getline, a last line without a newline is still returned.
+    bool nextLine(const char*& line, size_t& length) {
+        carry.clear();
+        while (!drained) {
+            if (current >= 0 && position < blocks[current % STREAM_BLOCK_COUNT].size) {
+                const Block& block = blocks[current % STREAM_BLOCK_COUNT];
+                const char* start = block.data + position;
+                size_t available = block.size - position;
+                const char* newline = static_cast<const char*>(std::memchr(start, '\n', available));
+                if (newline) {
+                    size_t size = newline - start;
+                    position += size + 1;
+                    bytesRead += size + 1;
+                    if (carry.empty()) {
+                        line = start;
+                        length = size;
+                    } else {
+                        carry.append(start, size);
+                        line = carry.data();
+                        length = carry.size();
+                    }
+                    return true;
+                }
+                // The line continues in the next block
+                carry.append(start, available);
+                bytesRead += available;
+                position = block.size;
+            }
+            if (!advanceBlock()) break;
+        }
+        if (carry.empty()) return false;
+        line = carry.data();
+        length = carry.size();
+        return true;
+    }
+
+    bool nextLine(std::string& line) {
+        const char* data;
+        size_t length;
+        if (!nextLine(data, length)) return false;
+        line.assign(data, length);
+        return true;
+    }
+
+    // After nextLine returned false: whether the input ended with a read error
+    bool failed(std::string& error) {
+        std::lock_guard<std::mutex> guard(lock);
+        error = readError;
+        return !readError.empty();
+    }
+
+    long long getBytesRead() const { return bytesRead; }
+};
+
+// Lines of one input: a file read with std::getline, or a source given on
+// the command line (see openInputSource) read by a BlockStreamReader
+class LineInput {
+private:
+    std::ifstream file;
+    BlockStreamReader stream;
+    bool streaming;
+    long long lineBytes;        // Bytes of the last line, with its newline
+
+public:
+    LineInput() : streaming(false), lineBytes(0) {}
+
+    bool openFile(const std::string& path) {
+        file.open(path.c_str());
+        return file.is_open();
+    }
+
+    bool openStream(const std::string& source, std::string& error) {
+        streaming = true;
+        return stream.open(source, error);
+    }
+
+    bool next(std::string& line) {
+        if (!streaming) {
+            if (!std::getline(file, line)) return false;
+            lineBytes = line.size() + 1;
+            return true;
+        }
+        if (!stream.nextLine(line)) return false;
+        lineBytes = line.size() + 1;
+        return true;
+    }
+
+    // Next line into a NUL-terminated buffer. A file line that does not fit
+    // ends the input as istream::getline does; a streamed one is skipped.
+    bool next(char* line, int capacity) {
+        if (!streaming) {
+            if (!file.getline(line, capacity)) return false;
+            lineBytes = file.gcount();
+            return true;
+        }
+        const char* data;
+        size_t length;
+        while (stream.nextLine(data, length)) {
+            if (length >= static_cast<size_t>(capacity)) continue;
+            std::memcpy(line, data, length);
+            line[length] = '\0';
+            lineBytes = length + 1;
+            return true;
+        }
+        return false;
+    }
+
+    long long lastLineBytes() const { return lineBytes; }
+
+    // After next returned false: whether a streamed input ended with a read error
+    bool failed(std::string& error) { return streaming && stream.failed(error); }
+};
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <ostream>
+#include "Array.h"
+
+// Non-owning reference to characters stored elsewhere (usually a StringArena)
+struct StringRef {
+    const char* data;
+    int length;
+
+    StringRef() : data(""), length(0) {}
+    StringRef(const char* d, int len) : data(d), length(len) {}
+
+    bool empty() const { return length == 0; }
+    char front() const { return data[0]; }
+    char back() const { return data[length - 1]; }
+
+    std::string str() const { return std::string(data, length); }
+
+    bool operator==(const char* other) const {
+        return std::strncmp(data, other, length) == 0 && other[length] == '\0';
+    }
+
+    bool operator!=(const char* other) const { return !(*this == other); }
+
+    bool operator==(const StringRef& other) const {
+        return length == other.length && std::memcmp(data, other.data, length) == 0;
+    }
+
+    // Parse as a number the way std::stod / std::stoi would
+    double toDouble() const {
+        char buffer[64];
+        int len = length < 63 ? length : 63;
+        std::memcpy(buffer, data, len);
+        buffer[len] = '\0';
+        return std::strtod(buffer, nullptr);
+    }
+
+    int toInt() const {
+        char buffer[32];
+        int len = length < 31 ? length : 31;
+        std::memcpy(buffer, data, len);
+        buffer[len] = '\0';
+        return static_cast<int>(std::strtol(buffer, nullptr, 10));
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const StringRef& ref) {
+    return out.write(ref.data, ref.length);
+}
+
+// Bump allocator that owns the string bytes of one load. Strings are copied
+// into large blocks, so storing a record costs no per-field heap allocation and
+// teardown frees a handful of blocks instead of one buffer per string.
+class StringArena {
+private:
+    Array<char*> blocks;
+    int blockSize;
+    int used;           // Bytes used in the last block
+    long long totalBytes;
+
+    char* allocateBlock(int size) {
+        char* block = new char[size];
+        blocks.push_back(block);
+        return block;
+    }
+
+public:
+    StringArena(int blockSize = 1 << 20) : blockSize(blockSize), used(blockSize), totalBytes(0) {}
+
+    ~StringArena() {
+        clear();
+    }
+
+    // Records point into the blocks, so the arena is not copyable
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    // Copy the characters into the arena and return a reference to the copy
+    StringRef store(const char* data, int length) {
+        if (length <= 0) return StringRef();
+        totalBytes += length;
+
+        // Oversized strings get a dedicated block; the current block stays open
+        if (length > blockSize / 4) {
+            char* block = new char[length];
+            std::memcpy(block, data, length);
+            if (blocks.getSize() > 0) {
+                char* current = blocks[blocks.getSize() - 1];
+                blocks[blocks.getSize() - 1] = block;
+                blocks.push_back(current);
+            } else {
+                blocks.push_back(block);
+                used = blockSize;
+            }
+            return StringRef(block, length);
+        }
+
+        if (used + length > blockSize) {
+            allocateBlock(blockSize);
+            used = 0;
+        }
+        char* target = blocks[blocks.getSize() - 1] + used;
+        std::memcpy(target, data, length);
+        used += length;
+        return StringRef(target, length);
+    }
+
+    StringRef store(const StringRef& ref) {
+        return store(ref.data, ref.length);
+    }
+
+    // Free every block; all references handed out become invalid
+    void clear() {
+        for (int i = 0; i < blocks.getSize(); i++) {
+            delete[] blocks[i];
+        }
+        blocks = Array<char*>();
+        used = blockSize;
+        totalBytes = 0;
+    }
+
+    long long getBytesStored() const { return totalBytes; }
+    int getBlockCount() const { return blocks.getSize(); }
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef TIME_INDEX_H
+#define TIME_INDEX_H
+
+#include <string>
+#include <algorithm>
+#include "Array.h"
+#include "DataStructures.h"
+
+// Half-open range [begin, end) of positions in the index's calendar order
+struct RowRange {
+    int begin;
+    int end;
+
+    RowRange(int b = 0, int e = 0) : begin(b), end(e) {}
+    int count() const { return end - begin; }
+};
+
+// Month bucket key of a calendarDateKey: year * 100 + month
+inline int monthKeyOf(int calendarKey) {
+    return calendarKey / 100;
+}
+
+// Index over an array of transactions by calendar date (calendarDateKey).
+// The rows are kept in place and visited through a permutation in calendar
+// order, so the caller's array keeps its Question 1 order. Rows are
+// bucketed per day and per month; each bucket stores its first position,
+// and prefix sums of price make count, revenue and average over any date
+// range two binary searches away.
+class TimeIndex {
+private:
+    Array<int> order;             // Row offsets in calendar order, ties in array order
+    Array<int> dayKeys;           // Distinct calendarDateKey values, ascending
+    Array<int> dayStart;          // First position of each day, plus a final sentinel
+    Array<double> dayRevenue;     // Price total of all days before each day
+    Array<int> monthKeys;         // Distinct monthKeyOf values, ascending
+    Array<int> monthFirstDay;     // Index into dayKeys of each month's first day, plus sentinel
+
+    // First bucket whose key is >= key
+    static int lowerBound(const Array<int>& keys, int key) {
+        int low = 0, high = keys.getSize();
+        while (low < high) {
+            int mid = low + (high - low) / 2;
+            if (keys[mid] < key) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // Revenue of the days [firstDay, endDay)
+    double revenueOfDays(int firstDay, int endDay) const {
+        return dayRevenue[endDay] - dayRevenue[firstDay];
+    }
+
+    // Bucket index of a month key, or -1
+    int findMonth(int monthKey) const {
+        int m = lowerBound(monthKeys, monthKey);
+        return m < monthKeys.getSize() && monthKeys[m] == monthKey ? m : -1;
+    }
+
+public:
+    // Build from an array of Transaction or TransactionRef in any order.
+    // Positions returned by queries map to rows of that array with rowAt.
+    template <typename T>
+    void build(const Array<T>& rows) {
+        int n = rows.getSize();
+        Array<int> keys(n > 0 ? n : 1);
+        order = Array<int>(n > 0 ? n : 1);
+        for (int i = 0; i < n; i++) {
+            keys.push_back(calendarDateKey(rows[i].date));
+            order.push_back(i);
+        }
+        std::stable_sort(order.getData(), order.getData() + n,
+                         [&keys](int a, int b) { return keys[a] < keys[b]; });
+
+        dayKeys = Array<int>();
+        dayStart = Array<int>();
+        dayRevenue = Array<double>();
+        monthKeys = Array<int>();
+        monthFirstDay = Array<int>();
+
+        double runningRevenue = 0;
+        for (int p = 0; p < n; p++) {
+            int key = keys[order[p]];
+            if (dayKeys.getSize() == 0 || dayKeys[dayKeys.getSize() - 1] != key) {
+                if (monthKeys.getSize() == 0 || monthKeys[monthKeys.getSize() - 1] != monthKeyOf(key)) {
+                    monthKeys.push_back(monthKeyOf(key));
+                    monthFirstDay.push_back(dayKeys.getSize());
+                }
+                dayKeys.push_back(key);
+                dayStart.push_back(p);
+                dayRevenue.push_back(runningRevenue);
+            }
+            runningRevenue += rows[order[p]].price;
+        }
+        dayStart.push_back(n);
+        dayRevenue.push_back(runningRevenue);
+        monthFirstDay.push_back(dayKeys.getSize());
+    }
+
+    // Row of the indexed array at a position of a RowRange
+    int rowAt(int position) const { return order[position]; }
+
+    // Positions whose date key lies in [fromKey, toKey]; O(log days)
+    RowRange rowsBetween(int fromKey, int toKey) const {
+        if (dayKeys.getSize() == 0 || fromKey > toKey) return RowRange();
+        int firstDay = lowerBound(dayKeys, fromKey);
+        int endDay = lowerBound(dayKeys, toKey + 1);
+        return RowRange(dayStart[firstDay], dayStart[endDay]);
+    }
+
+    RowRange rowsBetween(const std::string& from, const std::string& to) const {
+        return rowsBetween(calendarDateKey(from), calendarDateKey(to));
+    }
+
+    int countBetween(const std::string& from, const std::string& to) const {
+        return rowsBetween(from, to).count();
+    }
+
+    double revenueBetween(const std::string& from, const std::string& to) const {
+        if (dayKeys.getSize() == 0) return 0;
+        int firstDay = lowerBound(dayKeys, calendarDateKey(from));
+        int endDay = lowerBound(dayKeys, calendarDateKey(to) + 1);
+        return firstDay < endDay ? revenueOfDays(firstDay, endDay) : 0;
+    }
+
+    double averageBetween(const std::string& from, const std::string& to) const {
+        int count = countBetween(from, to);
+        return count > 0 ? revenueBetween(from, to) / count : 0;
+    }
+
+    // Positions of one month (monthKey = year * 100 + month); O(log months)
+    RowRange rowsInMonth(int monthKey) const {
+        int m = findMonth(monthKey);
+        if (m < 0) return RowRange();
+        return RowRange(dayStart[monthFirstDay[m]], dayStart[monthFirstDay[m + 1]]);
+    }
+
+    int countInMonth(int monthKey) const {
+        return rowsInMonth(monthKey).count();
+    }
+
+    double revenueInMonth(int monthKey) const {
+        int m = findMonth(monthKey);
+        return m >= 0 ? revenueOfDays(monthFirstDay[m], monthFirstDay[m + 1]) : 0;
+    }
+
+    // First / last n positions of a date range, in calendar order
+    RowRange firstRowsBetween(const std::string& from, const std::string& to, int n) const {
+        RowRange range = rowsBetween(from, to);
+        if (range.count() > n) range.end = range.begin + n;
+        return range;
+    }
+
+    RowRange lastRowsBetween(const std::string& from, const std::string& to, int n) const {
+        RowRange range = rowsBetween(from, to);
+        if (range.count() > n) range.begin = range.end - n;
+        return range;
+    }
+
+    int getDayCount() const { return dayKeys.getSize(); }
+    int getMonthCount() const { return monthKeys.getSize(); }
+};
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef UNROLLED_LINKED_LIST_H
+#define UNROLLED_LINKED_LIST_H
+
+// Node holding up to ChunkSize elements in a contiguous block
+template <typename T, int ChunkSize>
+struct UnrolledNode {
+    T items[ChunkSize];
+    int count;
+    UnrolledNode* next;
+
+    UnrolledNode() : count(0), next(nullptr) {}
+};
+
+// Singly linked list of fixed-size chunks. Traversal walks begin()->next like
+// LinkedList, visiting items[0..count) of each node, so a scan touches one
+// node per ChunkSize elements instead of one per element. Appends are O(1)
+// through a tail pointer.
+template <typename T, int ChunkSize = 32>
+class UnrolledLinkedList {
+    static_assert(ChunkSize >= 16 && ChunkSize <= 64, "ChunkSize should be between 16 and 64");
+
+public:
+    typedef UnrolledNode<T, ChunkSize> NodeType;
+
+private:
+    NodeType* head;
+    NodeType* tail;
+    int size;
+
+    void copyFrom(const UnrolledLinkedList& other) {
+        for (NodeType* node = other.head; node; node = node->next) {
+            for (int i = 0; i < node->count; i++) {
+                add(node->items[i]);
+            }
+        }
+    }
+
+    // Stable insertion sort inside one chunk
+    static void sortChunk(NodeType* node, int (*compare)(const T&, const T&)) {
+        for (int i = 1; i < node->count; i++) {
+            T value = node->items[i];
+            int j = i - 1;
+            while (j >= 0 && compare(node->items[j], value) > 0) {
+                node->items[j + 1] = node->items[j];
+                j--;
+            }
+            node->items[j + 1] = value;
+        }
+    }
+
+    // Append one element to an output chain being built by merge
+    static void appendTo(NodeType*& outHead, NodeType*& outTail, const T& value) {
+        if (!outTail || outTail->count == ChunkSize) {
+            NodeType* node = new NodeType();
+            if (outTail) {
+                outTail->next = node;
+            } else {
+                outHead = node;
+            }
+            outTail = node;
+        }
+        outTail->items[outTail->count++] = value;
+    }
+
+    // Merge two sorted chains into a new packed chain, freeing the inputs.
+    // Ties take the left element, which keeps the sort stable.
+    static NodeType* mergeChains(NodeType* left, NodeType* right, int (*compare)(const T&, const T&)) {
+        NodeType* outHead = nullptr;
+        NodeType* outTail = nullptr;
+        int li = 0, ri = 0;
+
+        while (left && right) {
+            if (compare(left->items[li], right->items[ri]) <= 0) {
+                appendTo(outHead, outTail, left->items[li]);
+                if (++li == left->count) {
+                    NodeType* done = left;
+                    left = left->next;
+                    delete done;
+                    li = 0;
+                }
+            } else {
+                appendTo(outHead, outTail, right->items[ri]);
+                if (++ri == right->count) {
+                    NodeType* done = right;
+                    right = right->next;
+                    delete done;
+                    ri = 0;
+                }
+            }
+        }
+
+        NodeType* rest = left ? left : right;
+        int restIndex = left ? li : ri;
+        while (rest) {
+            for (int i = restIndex; i < rest->count; i++) {
+                appendTo(outHead, outTail, rest->items[i]);
+            }
+            NodeType* done = rest;
+            rest = rest->next;
+            delete done;
+            restIndex = 0;
+        }
+        return outHead;
+    }
+
+public:
+    UnrolledLinkedList() : head(nullptr), tail(nullptr), size(0) {}
+
+    // Copy constructor
+    UnrolledLinkedList(const UnrolledLinkedList& other) : head(nullptr), tail(nullptr), size(0) {
+        copyFrom(other);
+    }
+
+    ~UnrolledLinkedList() {
+        clear();
+    }
+
+    // Copy assignment operator
+    UnrolledLinkedList& operator=(const UnrolledLinkedList& other) {
+        if (this != &other) {
+            clear();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    void add(const T& data) {
+        if (!tail || tail->count == ChunkSize) {
+            NodeType* node = new NodeType();
+            if (tail) {
+                tail->next = node;
+            } else {
+                head = node;
+            }
+            tail = node;
+        }
+        tail->items[tail->count++] = data;
+        size++;
+    }
+
+    NodeType* begin() const {
+        return head;
+    }
+
+    int getSize() const { return size; }
+
+    void clear() {
+        NodeType* current = head;
+        while (current) {
+            NodeType* temp = current;
+            current = current->next;
+            delete temp;
+        }
+        head = nullptr;
+        tail = nullptr;
+        size = 0;
+    }
+
+    // Stable merge sort at chunk granularity: each chunk is sorted in place,
+    // then runs of chunks are merged pairwise bottom-up until one run remains
+    void mergeSort(int (*compare)(const T&, const T&)) {
+        if (!head) return;
+
+        // Detach every chunk as a sorted single-chunk run
+        int runCount = 0;
+        for (NodeType* node = head; node; node = node->next) {
+            runCount++;
+        }
+        NodeType** runs = new NodeType*[runCount];
+        NodeType* node = head;
+        for (int i = 0; i < runCount; i++) {
+            NodeType* next = node->next;
+            node->next = nullptr;
+            sortChunk(node, compare);
+            runs[i] = node;
+            node = next;
+        }
+
+        while (runCount > 1) {
+            int merged = 0;
+            for (int i = 0; i < runCount; i += 2) {
+                runs[merged++] = (i + 1 < runCount) ? mergeChains(runs[i], runs[i + 1], compare) : runs[i];
+            }
+            runCount = merged;
+        }
+
+        head = runs[0];
+        delete[] runs;
+        tail = head;
+        while (tail->next) {
+            tail = tail->next;
+        }
+    }
+};
+
+#endif
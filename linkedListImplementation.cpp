@@ -1,187 +1,480 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
 #include "include/LinkedListDataAnalyzer.h"
+#include "include/QueryLanguage.h"
+#include "include/RowSchema.h"
+#include "include/StreamReader.h"
 
-// Helper function to split CSV line
-LinkedList<std::string> splitCSV(const std::string& line) {
-    LinkedList<std::string> result;
-    std::string item;
-    size_t start = 0;
-    size_t end = 0;
-    
-    while ((end = line.find(',', start)) != std::string::npos) {
-        item = line.substr(start, end - start);
-        // Remove quotes if present
-        if (item.front() == '"' && item.back() == '"') {
-            item = item.substr(1, item.length() - 2);
+// Run each --query; false if one is invalid
+template <typename TR, typename RV>
+bool runQueries(const Array<std::string>& queries, const LinkedList<TR>& transactions,
+                const LinkedList<RV>& reviews, Array<QueryResult>& results) {
+    for (int i = 0; i < queries.getSize(); i++) {
+        QueryResult result;
+        std::string error;
+        if (!runQuery(queries[i], transactions, reviews, result, error)) {
+            std::cerr << "Invalid query (" << error << "): " << queries[i] << std::endl;
+            return false;
         }
-        result.add(item);
-        start = end + 1;
+        results.push_back(result);
     }
-    // Add the last item
-    item = line.substr(start);
-    if (item.front() == '"' && item.back() == '"') {
-        item = item.substr(1, item.length() - 2);
+    return true;
+}
+
+void printQuery(const std::string& text, const QueryResult& result) {
+    std::cout << "\nQuery: " << text << std::endl;
+    std::cout << result.header << std::endl;
+    for (int i = 0; i < result.rows.getSize(); i++) {
+        std::cout << result.rows[i] << std::endl;
     }
-    result.add(item);
-    return result;
 }
 
-int main() {
-    LinkedListDataAnalyzer analyzer;
+// Print one transaction row of the Question 1 listing
+template <typename T>
+void printTransaction(const T& t) {
+    std::cout << t.date << ", " 
+              << t.customerId << ", "
+              << t.product << ", "
+              << t.category << ", "
+              << t.price << ", "
+              << t.paymentMethod << std::endl;
+}
 
-    // Read transactions
-    std::ifstream transFile("transactions_cleaned.csv");
-    std::string line;
-    
-    // Skip header
-    std::getline(transFile, line);
-    
-    while (std::getline(transFile, line)) {
-        LinkedList<std::string> fields = splitCSV(line);
-        int size = 0;
-        Node<std::string>* current = fields.begin();
-        while (current) {
-            size++;
-            current = current->next;
-        }
-        
-        if (size >= 6) {
-            current = fields.begin();
-            std::string customerId = current->data;
-            current = current->next;
-            std::string product = current->data;
-            current = current->next;
-            std::string category = current->data;
-            current = current->next;
-            double price = std::stod(current->data);
-            current = current->next;
-            std::string date = current->data;
-            current = current->next;
-            std::string paymentMethod = current->data;
-            
-            Transaction trans(customerId, product, category, price, date, paymentMethod);
-            analyzer.addTransaction(trans);
-        }
+void printQuestion1Header(int totalTransactions) {
+    // 1. How can you efficiently sort customer transactions by date and display the total number of transactions in both datasets?
+    std::cout << "1. How can you efficiently sort customer transactions by date and display the total number of transactions in both datasets?" << std::endl;
+    std::cout << "\nTotal number of transactions: " << totalTransactions << std::endl;
+
+    // Display first 100 transactions
+    std::cout << "\nFirst 100 transactions (sorted by date):" << std::endl;
+    std::cout << "Date, Customer ID, Product, Category, Price, Payment Method" << std::endl;
+}
+
+void printQuestion1Footer(int totalTransactions) {
+    if (totalTransactions > 100) {
+        std::cout << "\n... and " << (totalTransactions - 100) << " more transactions" << std::endl;
     }
+}
 
-    // Read reviews
-    std::ifstream reviewFile("reviews_cleaned.csv");
-    
-    // Skip header
-    std::getline(reviewFile, line);
-    
-    while (std::getline(reviewFile, line)) {
-        LinkedList<std::string> fields = splitCSV(line);
-        int size = 0;
-        Node<std::string>* current = fields.begin();
-        while (current) {
-            size++;
-            current = current->next;
-        }
-        
-        if (size >= 4) {
-            current = fields.begin();
-            std::string productId = current->data;
-            current = current->next;
-            std::string customerId = current->data;
-            current = current->next;
-            int rating = std::stoi(current->data);
-            current = current->next;
-            std::string reviewText = current->data;
-            
-            Review review(productId, customerId, rating, reviewText);
-            analyzer.addReview(review);
+// Count one transaction towards Question 2
+template <typename T>
+void countElectronicsCreditCard(const T& t, int& totalElectronics, int& electronicsCreditCard) {
+    if (t.category == "Electronics") {
+        totalElectronics++;
+        if (t.paymentMethod == "Credit Card") {
+            electronicsCreditCard++;
         }
     }
+}
 
-    // 1. How can you efficiently sort customer transactions by date and display the total number of transactions in both datasets?
-    std::cout << "1. How can you efficiently sort customer transactions by date and display the total number of transactions in both datasets?" << std::endl;
+void printQuestion2(int totalElectronics, int electronicsCreditCard) {
+    // 2. What percentage of purchases in the "Electronics" category were made using Credit Card payments?
+    std::cout << "\n2. What percentage of purchases in the \"Electronics\" category were made using Credit Card payments?" << std::endl;
     
+    if (totalElectronics > 0) {
+        double percentage = (static_cast<double>(electronicsCreditCard) / totalElectronics) * 100;
+        std::cout << "\nOut of " << totalElectronics << " Electronics purchases:" << std::endl;
+        std::cout << electronicsCreditCard << " were made with Credit Card (" << std::fixed << std::setprecision(2) << percentage << "%)" << std::endl;
+    } else {
+        std::cout << "\nNo Electronics purchases found in the dataset." << std::endl;
+    }
+}
+
+// Questions 1 and 2, for owned (Transaction) or arena-backed (TransactionRef) records
+template <typename T>
+void answerTransactionQuestions(LinkedListDataAnalyzer& analyzer, const LinkedList<T>& storedTransactions) {
+    // Counted up front so the walk is not timed as part of the sort
+    int storedCount = 0;
+    for (Node<T>* node = storedTransactions.begin(); node; node = node->next) {
+        storedCount++;
+    }
+
     // Get all transactions and sort them by date
-    LinkedList<Transaction> transactions = analyzer.getTransactions();
-    Node<Transaction>* sortedHead = analyzer.mergeSort(transactions.begin(), compareTransactionsByDate);
+    ScopedTimer sortTimer("sort.transactionsByDate");
+    sortTimer.addRows(storedCount);
+    LinkedList<T> transactions = storedTransactions;
+    Node<T>* sortedHead = analyzer.mergeSort(transactions.begin(), compareTransactionsByDate);
+    sortTimer.stop();
     
     // Count total transactions
     int totalTransactions = 0;
-    Node<Transaction>* current = sortedHead;
+    Node<T>* current = sortedHead;
     while (current) {
         totalTransactions++;
         current = current->next;
     }
     
     // Update the transactions list with sorted nodes
-    transactions = LinkedList<Transaction>();  // Clear the list
+    transactions = LinkedList<T>();  // Clear the list
     current = sortedHead;
     while (current) {
         transactions.add(current->data);
         current = current->next;
     }
 
-    std::cout << "\nTotal number of transactions: " << totalTransactions << std::endl;
-
-    // Display first 100 transactions
-    std::cout << "\nFirst 100 transactions (sorted by date):" << std::endl;
-    std::cout << "Date, Customer ID, Product, Category, Price, Payment Method" << std::endl;
-
+    printQuestion1Header(totalTransactions);
     int displayCount = 0;
     current = sortedHead;
     while (current && displayCount < 100) {
-        const Transaction& t = current->data;
-        std::cout << t.date << ", " 
-                  << t.customerId << ", "
-                  << t.product << ", "
-                  << t.category << ", "
-                  << t.price << ", "
-                  << t.paymentMethod << std::endl;
+        printTransaction(current->data);
         current = current->next;
         displayCount++;
     }
+    printQuestion1Footer(totalTransactions);
 
-    if (totalTransactions > 100) {
-        std::cout << "\n... and " << (totalTransactions - 100) << " more transactions" << std::endl;
-    }
-
-    // 2. What percentage of purchases in the "Electronics" category were made using Credit Card payments?
-    std::cout << "\n2. What percentage of purchases in the \"Electronics\" category were made using Credit Card payments?" << std::endl;
-    
+    ScopedTimer scanTimer("scan.electronicsCreditCard");
     int totalElectronics = 0;
     int electronicsCreditCard = 0;
     
     current = sortedHead;
     while (current) {
-        const Transaction& t = current->data;
-        if (t.category == "Electronics") {
-            totalElectronics++;
-            if (t.paymentMethod == "Credit Card") {
-                electronicsCreditCard++;
-            }
-        }
+        countElectronicsCreditCard(current->data, totalElectronics, electronicsCreditCard);
         current = current->next;
     }
+    scanTimer.addRows(totalTransactions);
+    scanTimer.stop();
     
-    if (totalElectronics > 0) {
-        double percentage = (static_cast<double>(electronicsCreditCard) / totalElectronics) * 100;
-        std::cout << "\nOut of " << totalElectronics << " Electronics purchases:" << std::endl;
-        std::cout << electronicsCreditCard << " were made with Credit Card (" << std::fixed << std::setprecision(2) << percentage << "%)" << std::endl;
-    } else {
-        std::cout << "\nNo Electronics purchases found in the dataset." << std::endl;
+    printQuestion2(totalElectronics, electronicsCreditCard);
+}
+
+// Questions 1 and 2 on an unrolled copy of the stored transactions
+template <typename T>
+void answerTransactionQuestionsUnrolled(LinkedListDataAnalyzer& analyzer, const LinkedList<T>& storedTransactions) {
+    UnrolledLinkedList<T> transactions;
+    for (Node<T>* node = storedTransactions.begin(); node; node = node->next) {
+        transactions.add(node->data);
     }
 
-    // 3. Which words are most frequently used in product reviews rated 1-star?
-    std::cout << "\n3. Which words are most frequently used in product reviews rated 1-star?" << std::endl;
+    // Sort chunk by chunk; the merge is stable, so the order matches mergeSort
+    ScopedTimer sortTimer("sort.transactionsByDate");
+    analyzer.mergeSort(transactions, compareTransactionsByDate);
+    sortTimer.addRows(transactions.getSize());
+    sortTimer.stop();
 
-    // Analyze negative reviews
-    analyzer.analyzeNegativeReviews();
-    LinkedList<WordFrequency> topWords = analyzer.getTopFrequentWords(5);
+    int totalTransactions = transactions.getSize();
+    printQuestion1Header(totalTransactions);
+    int displayCount = 0;
+    for (auto* node = transactions.begin(); node && displayCount < 100; node = node->next) {
+        for (int i = 0; i < node->count && displayCount < 100; i++) {
+            printTransaction(node->items[i]);
+            displayCount++;
+        }
+    }
+    printQuestion1Footer(totalTransactions);
+
+    ScopedTimer scanTimer("scan.electronicsCreditCard");
+    int totalElectronics = 0;
+    int electronicsCreditCard = 0;
+    for (auto* node = transactions.begin(); node; node = node->next) {
+        for (int i = 0; i < node->count; i++) {
+            countElectronicsCreditCard(node->items[i], totalElectronics, electronicsCreditCard);
+        }
+    }
+    scanTimer.addRows(totalTransactions);
+    scanTimer.stop();
+
+    printQuestion2(totalElectronics, electronicsCreditCard);
+}
 
+void printTopWords(const LinkedList<WordFrequency>& topWords) {
     std::cout << "\nTop 5 frequent words in negative reviews:\n";
     Node<WordFrequency>* wordNode = topWords.begin();
     while (wordNode) {
         std::cout << wordNode->data.word << ": " << wordNode->data.frequency << " occurrences\n";
         wordNode = wordNode->next;
     }
+}
+
+// All three answers from the aggregates kept up to date in incremental mode
+void answerIncrementalQuestions(LinkedListDataAnalyzer& analyzer) {
+    // Question 2 leaves the stream in fixed two-decimal mode; undo it for each round
+    std::cout << std::defaultfloat << std::setprecision(6);
+
+    const TransactionCounters& counters = analyzer.getTransactionCounters();
+    int totalTransactions = counters.getTotal();
+    printQuestion1Header(totalTransactions);
+    int displayCount = 0;
+    Node<Transaction>* current = analyzer.getSortedTransactions().begin();
+    while (current && displayCount < 100) {
+        printTransaction(current->data);
+        current = current->next;
+        displayCount++;
+    }
+    printQuestion1Footer(totalTransactions);
+
+    printQuestion2(counters.category("Electronics"), counters.categoryPayment("Electronics", "Credit Card"));
+
+    std::cout << "\n3. Which words are most frequently used in product reviews rated 1-star?" << std::endl;
+    printTopWords(analyzer.getTopFrequentWords(5));
+}
+
+// Incremental mode: load both files through append readers, answer, then
+// poll every intervalSeconds and re-answer whenever new rows have arrived
+void followFiles(LinkedListDataAnalyzer& analyzer, int intervalSeconds) {
+    AppendReader transReader("transactions_cleaned.csv");
+    AppendReader reviewReader("reviews_cleaned.csv");
+    bool first = true;
+    while (true) {
+        LinkedList<Transaction> newTransactions;
+        LinkedList<Review> newReviews;
+        Node<Transaction>* transTail = nullptr;
+        Node<Review>* reviewTail = nullptr;
+        int transCount = transReader.readNewLines([&](std::string& line) {
+            Transaction trans;
+            if (!TransactionRow::parse(line, trans)) return;
+            // Append through the remembered tail instead of LinkedList::add's walk
+            Node<Transaction>* node = new Node<Transaction>(trans);
+            if (transTail) {
+                transTail->next = node;
+            } else {
+                newTransactions.adopt(node);
+            }
+            transTail = node;
+        });
+        int reviewCount = reviewReader.readNewLines([&](std::string& line) {
+            Review review;
+            if (!ReviewRow::parse(line, review)) return;
+            Node<Review>* node = new Node<Review>(review);
+            if (reviewTail) {
+                reviewTail->next = node;
+            } else {
+                newReviews.adopt(node);
+            }
+            reviewTail = node;
+        });
+
+        if (first || transCount > 0 || reviewCount > 0) {
+            analyzer.appendTransactions(newTransactions);
+            analyzer.appendReviews(newReviews);
+            if (!first) {
+                std::cout << "\n=== " << transCount << " new transactions, "
+                          << reviewCount << " new reviews ===\n" << std::endl;
+            }
+            answerIncrementalQuestions(analyzer);
+            std::cout.flush();
+            first = false;
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(intervalSeconds));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Optional flags: --threads N, --counter sharded|thread-local, --metrics FILE, --perf, --arena, --unrolled,
+    // --follow SECONDS, --query TEXT, --transactions-input SOURCE, --reviews-input SOURCE
+    // ("-" for stdin, fd:N or a path)
+    int numThreads = 1;
+    bool useArena = false;
+    bool useUnrolled = false;
+    int followInterval = 0;
+    Array<std::string> queries;
+    std::string metricsPath;
+    std::string transSource, reviewSource;
+    bool usePerfCounters = false;
+    CounterMode counterMode = CounterMode::ThreadLocal;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            numThreads = std::atoi(argv[++i]);
+        } else if (arg == "--counter" && i + 1 < argc) {
+            if (!parseCounterMode(argv[++i], counterMode)) {
+                std::cerr << "Unknown counter mode: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else if (arg == "--perf") {
+            usePerfCounters = true;
+        } else if (arg == "--arena") {
+            useArena = true;
+        } else if (arg == "--unrolled") {
+            useUnrolled = true;
+        } else if (arg == "--query" && i + 1 < argc) {
+            queries.push_back(argv[++i]);
+        } else if (arg == "--follow" && i + 1 < argc) {
+            followInterval = std::atoi(argv[++i]);
+            if (followInterval < 1) {
+                std::cerr << "Error: --follow expects a polling interval in seconds" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--transactions-input" && i + 1 < argc) {
+            transSource = argv[++i];
+        } else if (arg == "--reviews-input" && i + 1 < argc) {
+            reviewSource = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--threads N] [--counter sharded|thread-local] [--metrics FILE] [--perf] [--arena] [--unrolled]"
+                      << " [--follow SECONDS] [--query TEXT] [--transactions-input -|fd:N|FILE] [--reviews-input -|fd:N|FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (followInterval > 0 && (useArena || useUnrolled || queries.getSize() > 0 || !metricsPath.empty())) {
+        std::cerr << "Error: --follow answers only the three standard questions and cannot be combined with"
+                  << " --arena, --unrolled, --query or --metrics" << std::endl;
+        return 1;
+    }
+    if ((!transSource.empty() || !reviewSource.empty()) && followInterval > 0) {
+        std::cerr << "Error: --transactions-input and --reviews-input read each input once and cannot be combined with --follow"
+                  << std::endl;
+        return 1;
+    }
+    if (transSource == "-" && reviewSource == "-") {
+        std::cerr << "Error: only one of --transactions-input and --reviews-input can read stdin" << std::endl;
+        return 1;
+    }
+
+    if (usePerfCounters && metricsPath.empty()) {
+        std::cerr << "Error: --perf adds hardware counters to the --metrics output and needs --metrics FILE" << std::endl;
+        return 1;
+    }
+    if (!metricsPath.empty()) {
+        Metrics::instance().enable("linked_list_analysis");
+    }
+    std::string perfError;
+    if (usePerfCounters && !Metrics::instance().enablePerfCounters(perfError)) {
+        std::cerr << "Warning: hardware counters unavailable (" << perfError << "); reporting times only" << std::endl;
+    }
+
+    LinkedListDataAnalyzer analyzer;
+
+    if (followInterval > 0) {
+        followFiles(analyzer, followInterval);
+        return 0;
+    }
+
+    // Read transactions
+    ScopedTimer transIngestTimer("ingest.transactions");
+    LineInput transFile;
+    std::string inputError;
+    if (!transSource.empty()) {
+        if (!transFile.openStream(transSource, inputError)) {
+            std::cerr << "Error: --transactions-input: " << inputError << std::endl;
+            return 1;
+        }
+    } else {
+        transFile.openFile("transactions_cleaned.csv");
+    }
+    std::string line;
+    long long rows = 0, bytes = 0;
+    
+    // Skip header
+    transFile.next(line);
+    
+    while (transFile.next(line)) {
+        rows++;
+        bytes += line.size() + 1;
+        if (useArena) {
+            // Field bytes are copied straight from the line into the arena
+            TransactionRef ref;
+            if (TransactionRefRow::parse(line, ref)) {
+                analyzer.addTransaction(ref);
+            }
+            continue;
+        }
+        Transaction trans;
+        if (TransactionRow::parse(line, trans)) {
+            analyzer.addTransaction(trans);
+        }
+    }
+
+    if (transFile.failed(inputError)) {
+        std::cerr << "Error: reading transactions failed: " << inputError << std::endl;
+        return 1;
+    }
+    transIngestTimer.addRows(rows);
+    transIngestTimer.stop();
+    countMetric("ingest.transactions.rows", rows);
+    countMetric("ingest.transactions.bytes", bytes);
+
+    // Read reviews
+    ScopedTimer reviewIngestTimer("ingest.reviews");
+    LineInput reviewFile;
+    if (!reviewSource.empty()) {
+        if (!reviewFile.openStream(reviewSource, inputError)) {
+            std::cerr << "Error: --reviews-input: " << inputError << std::endl;
+            return 1;
+        }
+    } else {
+        reviewFile.openFile("reviews_cleaned.csv");
+    }
+    rows = 0;
+    bytes = 0;
+    
+    // Skip header
+    reviewFile.next(line);
+    
+    while (reviewFile.next(line)) {
+        rows++;
+        bytes += line.size() + 1;
+        if (useArena) {
+            ReviewRef ref;
+            if (ReviewRefRow::parse(line, ref)) {
+                analyzer.addReview(ref);
+            }
+            continue;
+        }
+        Review review;
+        if (ReviewRow::parse(line, review)) {
+            analyzer.addReview(review);
+        }
+    }
+
+    if (reviewFile.failed(inputError)) {
+        std::cerr << "Error: reading reviews failed: " << inputError << std::endl;
+        return 1;
+    }
+    reviewIngestTimer.addRows(rows);
+    reviewIngestTimer.stop();
+    countMetric("ingest.reviews.rows", rows);
+    countMetric("ingest.reviews.bytes", bytes);
+
+    // Measured now because Question 1's sort relinks the stored list's nodes
+    if (!metricsPath.empty()) {
+        analyzer.reportRecordMemory();
+    }
+
+    // Queries run before Question 1, whose sort relinks the stored list's nodes
+    Array<QueryResult> queryResults;
+    bool validQueries = useArena
+        ? runQueries(queries, analyzer.getArenaTransactions(), analyzer.getArenaReviews(), queryResults)
+        : runQueries(queries, analyzer.getTransactions(), analyzer.getReviews(), queryResults);
+    if (!validQueries) return 1;
+
+    if (useArena && useUnrolled) {
+        answerTransactionQuestionsUnrolled(analyzer, analyzer.getArenaTransactions());
+    } else if (useArena) {
+        answerTransactionQuestions(analyzer, analyzer.getArenaTransactions());
+    } else if (useUnrolled) {
+        answerTransactionQuestionsUnrolled(analyzer, analyzer.getTransactions());
+    } else {
+        answerTransactionQuestions(analyzer, analyzer.getTransactions());
+    }
+
+    for (int i = 0; i < queries.getSize(); i++) {
+        printQuery(queries[i], queryResults[i]);
+    }
+
+    // 3. Which words are most frequently used in product reviews rated 1-star?
+    std::cout << "\n3. Which words are most frequently used in product reviews rated 1-star?" << std::endl;
+
+    // Analyze negative reviews
+    if (numThreads > 1) {
+        analyzer.analyzeNegativeReviewsParallel(numThreads, counterMode);
+    } else {
+        analyzer.analyzeNegativeReviews();
+    }
+    printTopWords(analyzer.getTopFrequentWords(5));
+
+    if (!metricsPath.empty()) {
+        analyzer.reportWordMemory();
+    }
+    if (!metricsPath.empty() && !Metrics::instance().writeJson(metricsPath)) {
+        std::cerr << "Error: Could not write metrics to " << metricsPath << std::endl;
+        return 1;
+    }
 
     return 0;
 }
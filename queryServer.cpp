@@ -0,0 +1,106 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <csignal>
+#include "include/QueryServer.h"
+
+QueryServer* runningServer = nullptr;
+
+void handleSignal(int) {
+    if (runningServer) runningServer->stop();
+}
+
+// Send each stdin line to the server and print the response payload
+int runClient(const std::string& socketPath) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "Error: Could not connect to " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    SocketLineReader reader(fd);
+    std::string request, line;
+    int status = 0;
+    while (std::getline(std::cin, request)) {
+        if (request.empty()) continue;
+        if (!sendAll(fd, request + "\n")) {
+            status = 1;
+            break;
+        }
+        if (request == "QUIT") break;
+        if (!reader.readLine(line)) {
+            std::cerr << "Error: Connection closed by server" << std::endl;
+            status = 1;
+            break;
+        }
+        if (line.compare(0, 3, "OK ") != 0) {
+            std::cout << line << std::endl;
+            continue;
+        }
+        int payloadLines = std::atoi(line.c_str() + 3);
+        for (int i = 0; i < payloadLines && reader.readLine(line); i++) {
+            std::cout << line << "\n";
+        }
+        std::cout.flush();
+    }
+    close(fd);
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    // Serves queries over the cleaned datasets, or acts as a client with --client
+    std::string socketPath = "analysis.sock";
+    int numThreads = 4;
+    bool clientMode = false;
+    std::string metricsPath;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            numThreads = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--client") == 0) {
+            clientMode = true;
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--socket PATH] [--threads N] [--metrics FILE] [--client]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (clientMode) {
+        return runClient(socketPath);
+    }
+
+    if (!metricsPath.empty()) {
+        Metrics::instance().enable("query_server");
+    }
+
+    QueryServer server(socketPath, "transactions_cleaned.csv", "reviews_cleaned.csv", numThreads);
+    std::string error;
+    if (!server.reload(error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+    runningServer = &server;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::cerr << "Listening on " << socketPath << " with " << numThreads << " worker thread(s)" << std::endl;
+    if (!server.run(error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+    if (!metricsPath.empty() && !Metrics::instance().writeJson(metricsPath)) {
+        std::cerr << "Error: Could not write metrics to " << metricsPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
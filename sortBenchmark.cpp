@@ -0,0 +1,400 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cmath>
+#include <chrono>
+#include <utility>
+#include "include/ArrayDataAnalyzer.h"
+#include "include/LinkedListDataAnalyzer.h"
+#include "include/DataGenerator.h"
+
+// Element operations performed by the sort being measured
+struct SortCounters {
+    long long comparisons;
+    long long moves;        // Element copies/moves; a std::swap is three
+
+    SortCounters() : comparisons(0), moves(0) {}
+};
+
+SortCounters sortCounters;
+
+// Element wrapper that counts every copy and move made of it. The sorts take
+// plain comparison function pointers, so comparisons are counted by
+// countedCompare, which unwraps and forwards to the real comparison.
+template <typename T>
+struct Counted {
+    T value;
+
+    Counted() {}
+    explicit Counted(const T& v) : value(v) {}
+
+    Counted(const Counted& other) : value(other.value) { sortCounters.moves++; }
+    Counted(Counted&& other) : value(std::move(other.value)) { sortCounters.moves++; }
+
+    Counted& operator=(const Counted& other) {
+        value = other.value;
+        sortCounters.moves++;
+        return *this;
+    }
+
+    Counted& operator=(Counted&& other) {
+        value = std::move(other.value);
+        sortCounters.moves++;
+        return *this;
+    }
+};
+
+template <typename T, int (*Compare)(const T&, const T&)>
+int countedCompare(const Counted<T>& a, const Counted<T>& b) {
+    sortCounters.comparisons++;
+    return Compare(a.value, b.value);
+}
+
+// Input shapes, each described by one key per position
+enum InputShape { SHAPE_SORTED, SHAPE_REVERSED, SHAPE_ORGAN_PIPE, SHAPE_FEW_UNIQUE, SHAPE_RANDOM,
+                  SHAPE_NEARLY_SORTED, SHAPE_COUNT };
+
+const char* const SHAPE_NAMES[SHAPE_COUNT] = {"sorted", "reversed", "organPipe", "fewUnique", "random", "nearlySorted"};
+
+// Keys 0..n-1 in the given shape; key order is the intended sort order
+Array<int> shapeKeys(int shape, int n, RowRandom& random) {
+    Array<int> keys(n > 0 ? n : 1);
+    for (int i = 0; i < n; i++) {
+        switch (shape) {
+            case SHAPE_REVERSED: keys.push_back(n - 1 - i); break;
+            case SHAPE_ORGAN_PIPE: keys.push_back(i < (n + 1) / 2 ? i : n - 1 - i); break;
+            case SHAPE_FEW_UNIQUE: keys.push_back(static_cast<int>(random.below(8))); break;
+            default: keys.push_back(i); break;
+        }
+    }
+    if (shape == SHAPE_RANDOM) {
+        for (int i = n - 1; i > 0; i--) {
+            std::swap(keys[i], keys[random.below(i + 1)]);
+        }
+    } else if (shape == SHAPE_NEARLY_SORTED) {
+        // About 1% of positions swapped with a near neighbour
+        for (int s = 0; s < n / 100; s++) {
+            int i = static_cast<int>(random.below(n));
+            int j = i + 1 + static_cast<int>(random.below(10));
+            if (j < n) std::swap(keys[i], keys[j]);
+        }
+    }
+    return keys;
+}
+
+// Transactions whose dates order like their keys: the comparison reads the
+// year, then characters 0-1, then characters 3-4, so the key's digits are
+// laid out in that order. The dates are not calendar dates, which the
+// comparison never checks.
+Transaction transactionForKey(int key) {
+    char date[10];
+    appendDigits(date, (key / 100) % 100, 2);
+    date[2] = '/';
+    appendDigits(date + 3, key % 100, 2);
+    date[5] = '/';
+    appendDigits(date + 6, 1000 + key / 10000, 4);
+    return Transaction("CUST1000", "Laptop", "Electronics", 999.99, std::string(date, 10), "Credit Card");
+}
+
+// Word frequencies sort by descending frequency
+WordFrequency wordForKey(int key) {
+    return WordFrequency("word" + std::to_string(key), 100000000 - key);
+}
+
+// Result of one (element type, shape, algorithm, size) cell
+struct SortResult {
+    std::string element;
+    std::string shape;
+    std::string algorithm;
+    int size;
+    long long comparisons;
+    long long moves;
+    double medianSeconds;
+    bool sorted;
+
+    // Comparisons relative to n log2 n; large values flag quadratic behaviour
+    double comparisonRatio() const {
+        return size > 1 ? comparisons / (size * std::log2(static_cast<double>(size))) : 0;
+    }
+};
+
+int compareDoubles(const double& a, const double& b) {
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+double median(Array<double>& values) {
+    ArrayDataAnalyzer sorter;
+    sorter.quickSort(values, compareDoubles);
+    int n = values.getSize();
+    if (n == 0) return 0;
+    return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+// Each algorithm sorts a fresh container built from the same elements. A
+// counted pass on Counted<T> gives comparisons and moves; the timed passes
+// run on plain T so the counting does not inflate the times.
+template <typename T>
+class SortRunner {
+private:
+    typedef int (*Compare)(const T&, const T&);
+    typedef int (*CountedCompare)(const Counted<T>&, const Counted<T>&);
+
+    Compare compare;
+    CountedCompare counted;
+    int repetitions;
+
+    template <typename E>
+    static void buildList(const Array<T>& elements, LinkedList<E>& list) {
+        Node<E>* head = nullptr;
+        Node<E>* tail = nullptr;
+        for (int i = 0; i < elements.getSize(); i++) {
+            Node<E>* node = new Node<E>(E(elements[i]));
+            if (tail) {
+                tail->next = node;
+            } else {
+                head = node;
+            }
+            tail = node;
+        }
+        list.adopt(head);
+    }
+
+    template <typename E>
+    static bool isSorted(const Array<E>& array, int (*cmp)(const E&, const E&)) {
+        for (int i = 1; i < array.getSize(); i++) {
+            if (cmp(array[i - 1], array[i]) > 0) return false;
+        }
+        return true;
+    }
+
+    template <typename E>
+    static bool isSorted(Node<E>* node, int (*cmp)(const E&, const E&)) {
+        for (; node && node->next; node = node->next) {
+            if (cmp(node->data, node->next->data) > 0) return false;
+        }
+        return true;
+    }
+
+    template <typename E, int ChunkSize>
+    static bool isSorted(const UnrolledLinkedList<E, ChunkSize>& list, int (*cmp)(const E&, const E&)) {
+        const E* previous = nullptr;
+        for (UnrolledNode<E, ChunkSize>* node = list.begin(); node; node = node->next) {
+            for (int i = 0; i < node->count; i++) {
+                if (previous && cmp(*previous, node->items[i]) > 0) return false;
+                previous = &node->items[i];
+            }
+        }
+        return true;
+    }
+
+    // Sort one container of element type E with the named algorithm
+    template <typename E>
+    static bool sortOnce(const char* algorithm, const Array<T>& elements, int (*cmp)(const E&, const E&),
+                         double& seconds) {
+        std::string name = algorithm;
+        bool sorted = false;
+        if (name == "array.quickSort") {
+            Array<E> array(elements.getSize() > 0 ? elements.getSize() : 1);
+            for (int i = 0; i < elements.getSize(); i++) {
+                array.push_back(E(elements[i]));
+            }
+            ArrayDataAnalyzer analyzer;
+            sortCounters = SortCounters();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            analyzer.quickSort(array, cmp);
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            SortCounters result = sortCounters;
+            sorted = isSorted(array, cmp);
+            sortCounters = result;     // Leave out the checking comparisons
+        } else if (name == "list.mergeSort") {
+            LinkedList<E> list;
+            buildList(elements, list);
+            LinkedListDataAnalyzer analyzer;
+            sortCounters = SortCounters();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            list.adopt(analyzer.mergeSort(list.release(), cmp));
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            SortCounters result = sortCounters;
+            sorted = isSorted(list.begin(), cmp);
+            sortCounters = result;     // Leave out the checking comparisons
+        } else {
+            UnrolledLinkedList<E, 32> list;
+            for (int i = 0; i < elements.getSize(); i++) {
+                list.add(E(elements[i]));
+            }
+            LinkedListDataAnalyzer analyzer;
+            sortCounters = SortCounters();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            analyzer.mergeSort(list, cmp);
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            SortCounters result = sortCounters;
+            sorted = isSorted(list, cmp);
+            sortCounters = result;     // Leave out the checking comparisons
+        }
+        return sorted;
+    }
+
+public:
+    SortRunner(Compare plain, CountedCompare wrapped, int reps)
+        : compare(plain), counted(wrapped), repetitions(reps) {}
+
+    SortResult run(const char* element, int shape, const char* algorithm, const Array<T>& elements) {
+        SortResult result;
+        result.element = element;
+        result.shape = SHAPE_NAMES[shape];
+        result.algorithm = algorithm;
+        result.size = elements.getSize();
+
+        double seconds = 0;
+        result.sorted = sortOnce<Counted<T> >(algorithm, elements, counted, seconds);
+        result.comparisons = sortCounters.comparisons;
+        result.moves = sortCounters.moves;
+
+        Array<double> times(repetitions);
+        for (int r = 0; r < repetitions; r++) {
+            result.sorted = sortOnce<T>(algorithm, elements, compare, seconds) && result.sorted;
+            times.push_back(seconds);
+        }
+        result.medianSeconds = median(times);
+        return result;
+    }
+};
+
+const char* const ALGORITHMS[] = {"array.quickSort", "list.mergeSort", "unrolled.mergeSort"};
+const int ALGORITHM_COUNT = 3;
+
+void writeCsv(std::ostream& out, const Array<SortResult>& results) {
+    out << "element,shape,algorithm,size,comparisons,moves,medianSeconds,comparisonsPerNLogN,sorted\n";
+    for (int i = 0; i < results.getSize(); i++) {
+        const SortResult& r = results[i];
+        out << r.element << "," << r.shape << "," << r.algorithm << "," << r.size << ","
+            << r.comparisons << "," << r.moves << "," << r.medianSeconds << ","
+            << r.comparisonRatio() << "," << (r.sorted ? "true" : "false") << "\n";
+    }
+}
+
+void writeJson(std::ostream& out, const Array<SortResult>& results, uint64_t seed) {
+    out << "{\n";
+    out << "  \"seed\": " << seed << ",\n";
+    out << "  \"results\": [";
+    for (int i = 0; i < results.getSize(); i++) {
+        const SortResult& r = results[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"element\": \"" << r.element << "\", \"shape\": \"" << r.shape << "\", "
+            << "\"algorithm\": \"" << r.algorithm << "\", \"size\": " << r.size << ", "
+            << "\"comparisons\": " << r.comparisons << ", \"moves\": " << r.moves << ", "
+            << "\"medianSeconds\": " << r.medianSeconds << ", "
+            << "\"comparisonsPerNLogN\": " << r.comparisonRatio() << ", "
+            << "\"sorted\": " << (r.sorted ? "true" : "false") << "}";
+    }
+    out << (results.getSize() > 0 ? "\n  ]\n" : "]\n");
+    out << "}\n";
+}
+
+int main(int argc, char* argv[]) {
+    // Sorts Transaction and WordFrequency inputs of adversarial shapes with
+    // every sort in the project and reports comparisons, moves and time
+    Array<int> sizes;
+    int repetitions = 1;
+    uint64_t seed = 42;
+    double maxRatio = 0;
+    bool json = false;
+    std::string outputPath = "-";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                long long size = parseRowCount(item.c_str());
+                if (size < 1 || size > 10000000) {
+                    std::cerr << "Invalid size: " << item << std::endl;
+                    return 1;
+                }
+                sizes.push_back(static_cast<int>(size));
+            }
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            repetitions = std::atoi(argv[++i]);
+            if (repetitions < 1) {
+                std::cerr << "Invalid repetition count: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--max-ratio" && i + 1 < argc) {
+            maxRatio = std::atof(argv[++i]);
+        } else if (arg == "--format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format != "csv" && format != "json") {
+                std::cerr << "Unknown output format: " << format << std::endl;
+                return 1;
+            }
+            json = format == "json";
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--sizes N,N,...] [--repetitions R] [--seed S]"
+                      << " [--max-ratio R] [--format csv|json] [--output FILE|-]" << std::endl;
+            return 1;
+        }
+    }
+    if (sizes.getSize() == 0) {
+        sizes.push_back(1000);
+        sizes.push_back(10000);
+    }
+
+    SortRunner<Transaction> transactionRunner(compareTransactionsByDate,
+        countedCompare<Transaction, compareTransactionsByDate>, repetitions);
+    SortRunner<WordFrequency> wordRunner(compareWordFrequency,
+        countedCompare<WordFrequency, compareWordFrequency>, repetitions);
+    Array<SortResult> results;
+    for (int s = 0; s < sizes.getSize(); s++) {
+        int n = sizes[s];
+        for (int shape = 0; shape < SHAPE_COUNT; shape++) {
+            RowRandom random = blockRandom(seed, shape, n);
+            Array<int> keys = shapeKeys(shape, n, random);
+            Array<Transaction> transactions(n);
+            Array<WordFrequency> words(n);
+            for (int i = 0; i < n; i++) {
+                transactions.push_back(transactionForKey(keys[i]));
+                words.push_back(wordForKey(keys[i]));
+            }
+            std::cerr << "Sorting " << SHAPE_NAMES[shape] << " inputs of " << n << std::endl;
+            for (int a = 0; a < ALGORITHM_COUNT; a++) {
+                results.push_back(transactionRunner.run("Transaction", shape, ALGORITHMS[a], transactions));
+                results.push_back(wordRunner.run("WordFrequency", shape, ALGORITHMS[a], words));
+            }
+        }
+    }
+
+    std::ofstream file;
+    if (outputPath != "-") {
+        file.open(outputPath.c_str());
+        if (!file) {
+            std::cerr << "Error: Could not open " << outputPath << " for writing" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = outputPath == "-" ? std::cout : file;
+    if (json) {
+        writeJson(out, results, seed);
+    } else {
+        writeCsv(out, results);
+    }
+
+    // Wrong orders always fail; comparison blowups fail when --max-ratio is set
+    int failures = 0;
+    for (int i = 0; i < results.getSize(); i++) {
+        const SortResult& r = results[i];
+        bool tooMany = maxRatio > 0 && r.comparisonRatio() > maxRatio;
+        if (!r.sorted || tooMany) {
+            std::cerr << (r.sorted ? "Too many comparisons: " : "Not sorted: ") << r.algorithm << " on "
+                      << r.shape << " " << r.element << " x" << r.size << " ("
+                      << r.comparisonRatio() << " n log n)" << std::endl;
+            failures++;
+        }
+    }
+    if (!out.good()) return 1;
+    return failures > 0 ? 2 : 0;
+}
@@ -0,0 +1,161 @@
+// Regression checks for bugs found in review. Build and run from the
+// repository root:
+//     g++ -std=c++11 -O2 -pthread -o regression_tests tests/regressionTests.cpp && ./regression_tests
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "../include/PriceSketch.h"
+#include "../include/TimeIndex.h"
+#include "../include/QueryLanguage.h"
+#include "../include/CustomerIndex.h"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+// A "NaN" price (accepted by strtod) used to index the histogram out of bounds
+static void testNonFinitePrices() {
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    double inf = std::numeric_limits<double>::infinity();
+
+    PriceHistogram histogram(0, 2000, 20);
+    const double batch[4] = {nan, 50, inf, -inf};
+    histogram.addBatch(batch, 4);
+    long long total = histogram.underflow() + histogram.overflow();
+    for (int b = 0; b < histogram.getBucketCount(); b++) total += histogram.bucketCountAt(b);
+    check(total == 4, "histogram counts every value of a batch with NaN and infinities once");
+    check(histogram.bucketCountAt(0) == 1, "finite value next to NaN lands in its bucket");
+
+    PriceSketch sketch;
+    sketch.add(nan);
+    sketch.add(100);
+    sketch.add(inf);
+    sketch.add(300);
+    check(sketch.count() == 2, "sketch drops non-finite prices");
+    check(sketch.min() == 100 && sketch.max() == 300, "sketch min/max ignore non-finite prices");
+}
+
+// Month buckets used to be keyed on the day of DD/MM/YYYY dates
+static void testMonthBucketsUseMonthField() {
+    const char* dates[5] = {"02/03/2023", "25/03/2023", "13/04/2023", "25/04/2023", "03/01/2024"};
+    Array<Transaction> sorted;
+    for (int i = 0; i < 5; i++) {
+        sorted.push_back(Transaction("C1", "Book", "Books", 10.0 * (i + 1), dates[i], "Cash"));
+    }
+    std::sort(sorted.getData(), sorted.getData() + sorted.getSize(),
+              [](const Transaction& a, const Transaction& b) { return compareTransactionsByDate(a, b) < 0; });
+
+    TimeIndex index;
+    index.build(sorted);
+    check(index.getMonthCount() == 3, "three distinct months");
+    check(index.countInMonth(202303) == 2, "March 2023 holds the 2nd and the 25th");
+    check(index.revenueInMonth(202303) == 30, "March 2023 revenue");
+    check(index.countInMonth(202304) == 2, "April 2023 holds the 13th and the 25th");
+    check(index.revenueInMonth(202304) == 70, "April 2023 revenue");
+    check(index.countInMonth(202401) == 1, "January 2024");
+    check(index.countInMonth(202325) == 0, "no bucket named after day 25");
+}
+
+// Date ranges used to binary-search keys that order a year's days before
+// its months, so a range crossing a month boundary picked up other months
+static void testDateRangeAcrossMonths() {
+    const char* dates[6] = {"20/02/2023", "28/02/2023", "05/03/2023", "15/03/2023", "02/04/2023", "16/04/2023"};
+    Array<Transaction> sorted;
+    for (int i = 0; i < 6; i++) {
+        sorted.push_back(Transaction("C1", "Book", "Books", 10.0 * (i + 1), dates[i], "Cash"));
+    }
+    std::sort(sorted.getData(), sorted.getData() + sorted.getSize(),
+              [](const Transaction& a, const Transaction& b) { return compareTransactionsByDate(a, b) < 0; });
+
+    TimeIndex index;
+    index.build(sorted);
+    check(index.countBetween("25/02/2023", "10/04/2023") == 4, "range 25/02-10/04 holds four rows");
+    check(index.revenueBetween("25/02/2023", "10/04/2023") == 20 + 30 + 40 + 50, "range 25/02-10/04 revenue");
+    check(index.countBetween("01/03/2023", "31/03/2023") == 2, "March holds two rows");
+    RowRange first = index.firstRowsBetween("14/02/2023", "30/04/2023", 3);
+    check(first.count() == 3 && sorted[index.rowAt(first.begin)].date == "20/02/2023" &&
+          sorted[index.rowAt(first.end - 1)].date == "05/03/2023", "first rows of a range are in calendar order");
+}
+
+// Query date comparisons used the day-before-month sort key, so a WHERE
+// range over one month also matched days of other months
+static void testQueryDateRangeIsCalendarOrder() {
+    const char* dates[6] = {"20/02/2023", "28/02/2023", "05/03/2023", "15/03/2023", "02/04/2023", "16/04/2023"};
+    Array<Transaction> transactions;
+    for (int i = 0; i < 6; i++) {
+        transactions.push_back(Transaction("C1", "Book", "Books", 10.0 * (i + 1), dates[i], "Cash"));
+    }
+    Array<Review> reviews;
+    QueryResult result;
+    std::string error;
+    bool ran = runQuery("SELECT COUNT(*), SUM(price) FROM transactions WHERE date >= 01/03/2023 AND date <= 31/03/2023",
+                        transactions, reviews, result, error);
+    check(ran && result.rows.getSize() == 1 && result.rows[0] == "2, 70.00", "WHERE date range over March counts the 5th and the 15th");
+
+    ran = runQuery("SELECT date FROM transactions ORDER BY date DESC LIMIT 2", transactions, reviews, result, error);
+    check(ran && result.rows.getSize() == 2 && result.rows[0] == "16/04/2023" && result.rows[1] == "02/04/2023",
+          "ORDER BY date sorts by calendar date");
+}
+
+// The pair-level hash join must agree with the index-based reviewer spend:
+// the transactions it matches are exactly those of customers with a review
+// of the rating, each counted once however many such reviews there are
+static void testHashJoinMatchesReviewerSpend() {
+    Array<Transaction> transactions;
+    transactions.push_back(Transaction("A", "Book", "Books", 10, "01/01/2023", "Cash"));
+    transactions.push_back(Transaction("A", "Pen", "Books", 20, "02/01/2023", "Cash"));
+    transactions.push_back(Transaction("B", "Book", "Books", 40, "03/01/2023", "Cash"));
+    transactions.push_back(Transaction("C", "Lamp", "Home", 80, "04/01/2023", "Cash"));
+    transactions.push_back(Transaction("", "Lamp", "Home", 160, "05/01/2023", "Cash"));
+    Array<Review> reviews;
+    reviews.push_back(Review("P1", "A", 1, "bad"));
+    reviews.push_back(Review("P2", "A", 1, "worse"));
+    reviews.push_back(Review("P3", "B", 5, "good"));
+    reviews.push_back(Review("P4", "C", 1, "broken"));
+    reviews.push_back(Review("P5", "D", 1, "never bought"));
+    reviews.push_back(Review("P6", "", 1, "anonymous"));
+
+    CustomerIndex index;
+    index.build(transactions, reviews);
+    ReviewerSpend expected = spendOfReviewers(index, transactions, reviews, 1);
+
+    Array<char> matched(transactions.getSize());
+    for (int i = 0; i < transactions.getSize(); i++) matched.push_back(0);
+    int pairs = 0;
+    hashJoinByCustomer(transactions, reviews, [](const Review& r) { return r.rating == 1; },
+                       [&](const Transaction& t, const Review&) {
+                           matched[static_cast<int>(&t - transactions.getData())] = 1;
+                           pairs++;
+                       });
+    int joined = 0;
+    double joinedSpend = 0;
+    for (int i = 0; i < transactions.getSize(); i++) {
+        if (!matched[i]) continue;
+        joined++;
+        joinedSpend += transactions[i].price;
+    }
+    check(pairs == 5, "join emits one pair per matching transaction and review");
+    check(joined == expected.transactions && joined == 3, "join matches the reviewer-spend transactions");
+    check(joinedSpend == expected.totalSpend && joinedSpend == 110, "join matches the reviewer spend");
+}
+
+int main() {
+    testNonFinitePrices();
+    testMonthBucketsUseMonthField();
+    testDateRangeAcrossMonths();
+    testQueryDateRangeIsCalendarOrder();
+    testHashJoinMatchesReviewerSpend();
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All regression checks passed" << std::endl;
+    return 0;
+}